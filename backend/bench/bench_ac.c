@@ -0,0 +1,133 @@
+/**
+ * Phrase Matching Benchmark
+ * Compares the per-phrase strstr loop that nlp_translate used to run with a
+ * single Aho-Corasick scan, as the phrase table grows.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "aho_corasick.h"
+
+#define PHRASES_PER_PATTERN 8
+#define NUM_QUERIES 2000
+#define QUERY_LEN 128
+
+static const char *vocab[] = {
+    "show", "list", "file", "files", "folder", "directory", "create", "make",
+    "delete", "remove", "copy", "move", "rename", "search", "find", "open",
+    "read", "write", "system", "memory", "disk", "process", "network", "user",
+    "current", "recent", "backup", "compare", "count", "words", "lines", "first",
+    "last", "notes", "help", "history", "clear", "screen", "time", "date",
+    "build", "deploy", "logs", "service", "restart", "status", "config", "cache"
+};
+#define VOCAB_SIZE (int)(sizeof(vocab) / sizeof(vocab[0]))
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Random 2-3 word phrase built from the vocabulary
+static void make_phrase(char *out, size_t size) {
+    int words = 2 + rand() % 2;
+    out[0] = '\0';
+    for (int w = 0; w < words; w++) {
+        if (w) strncat(out, " ", size - strlen(out) - 1);
+        strncat(out, vocab[rand() % VOCAB_SIZE], size - strlen(out) - 1);
+    }
+}
+
+// Old strategy: first phrase of the first pattern contained in the input
+static int naive_match(char **phrases, int count, const char *input) {
+    for (int i = 0; i < count; i += PHRASES_PER_PATTERN) {
+        for (int j = i; j < i + PHRASES_PER_PATTERN && j < count; j++) {
+            if (strstr(input, phrases[j])) return j;
+        }
+    }
+    return -1;
+}
+
+typedef struct {
+    char **phrases;
+    int best;
+    size_t best_len;
+} LongestHit;
+
+static void keep_longest(int id, size_t end, void *ctx) {
+    (void)end;
+    LongestHit *h = ctx;
+    size_t len = strlen(h->phrases[id]);
+    if (len > h->best_len || (len == h->best_len && id < h->best)) {
+        h->best = id;
+        h->best_len = len;
+    }
+}
+
+static void run(int count, char **queries) {
+    char **phrases = malloc(sizeof(char *) * count);
+    for (int i = 0; i < count; i++) {
+        phrases[i] = malloc(64);
+        make_phrase(phrases[i], 64);
+    }
+
+    AcAutomaton ac;
+    double t0 = now_sec();
+    ac_build(&ac, (const char *const *)phrases, count);
+    double build = now_sec() - t0;
+
+    int naive_hits = 0, ac_hits = 0;
+    t0 = now_sec();
+    for (int q = 0; q < NUM_QUERIES; q++) {
+        if (naive_match(phrases, count, queries[q]) >= 0) naive_hits++;
+    }
+    double naive = now_sec() - t0;
+
+    t0 = now_sec();
+    for (int q = 0; q < NUM_QUERIES; q++) {
+        LongestHit h = {phrases, -1, 0};
+        ac_scan(&ac, queries[q], strlen(queries[q]), keep_longest, &h);
+        if (h.best >= 0) ac_hits++;
+    }
+    double scan = now_sec() - t0;
+
+    printf("%8d %10u %10.2f %12.2f %12.2f %8.1fx %6d/%d\n",
+           count, ac.state_count, build * 1e3,
+           naive / NUM_QUERIES * 1e6, scan / NUM_QUERIES * 1e6,
+           scan > 0 ? naive / scan : 0.0, ac_hits, naive_hits);
+
+    ac_free(&ac);
+    for (int i = 0; i < count; i++) free(phrases[i]);
+    free(phrases);
+}
+
+int main(void) {
+    srand(42);
+
+    char **queries = malloc(sizeof(char *) * NUM_QUERIES);
+    for (int q = 0; q < NUM_QUERIES; q++) {
+        queries[q] = malloc(QUERY_LEN);
+        queries[q][0] = '\0';
+        while (strlen(queries[q]) < 40) {
+            char phrase[64];
+            make_phrase(phrase, sizeof(phrase));
+            strncat(queries[q], phrase, QUERY_LEN - strlen(queries[q]) - 2);
+            strcat(queries[q], " ");
+        }
+    }
+
+    printf("Phrase matching: strstr loop vs Aho-Corasick (%d queries)\n\n", NUM_QUERIES);
+    printf("%8s %10s %10s %12s %12s %9s %13s\n",
+           "phrases", "states", "build ms", "loop us/q", "ac us/q", "speedup", "hits ac/loop");
+
+    int sizes[] = {40, 160, 640, 2560, 10240};
+    for (int i = 0; i < (int)(sizeof(sizes) / sizeof(sizes[0])); i++) {
+        run(sizes[i], queries);
+    }
+
+    for (int q = 0; q < NUM_QUERIES; q++) free(queries[q]);
+    free(queries);
+    return 0;
+}
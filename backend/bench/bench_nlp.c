@@ -0,0 +1,315 @@
+/**
+ * NLP Accuracy and Latency Benchmark
+ * Runs a labeled corpus through the NLP engine and reports translation
+ * accuracy, argument extraction accuracy, classifier accuracy and per-call
+ * latency. Compares the results against a stored baseline and exits
+ * non-zero on a regression. With --intents, every paraphrase in the given
+ * file must also get its expected intent as the statistical model's top
+ * guess.
+ *
+ * Usage: bench_nlp <corpus.tsv> <baseline.txt> [--intents <cases.tsv>] [--update]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "nlp_engine.h"
+
+#define MAX_ITEMS 4096
+#define MAX_INTENT_CASES 256
+#define MAX_LINE 512
+#define MIN_SECONDS 0.2          // Repeat each latency loop at least this long
+#define DEFAULT_TOLERANCE 0.30   // Allowed latency growth over the baseline
+
+typedef struct {
+    char text[MAX_LINE];
+    char expected[MAX_LINE];     // "-" when nothing should be translated;
+                                 // a command template for intent cases
+} CorpusItem;
+
+typedef struct {
+    const char *name;
+    int higher_is_better;        // Accuracy (%) vs latency (ns)
+    double value;
+} Metric;
+
+enum {
+    M_EXACT, M_COMMAND, M_ARGUMENTS, M_CLASSIFY,
+    M_TRANSLATE, M_TRANSLATE_CACHED, M_SUGGEST, M_CLASSIFY_NS, M_COUNT
+};
+
+static Metric metrics[M_COUNT] = {
+    {"exact_accuracy", 1, 0},
+    {"command_accuracy", 1, 0},
+    {"argument_accuracy", 1, 0},
+    {"classify_accuracy", 1, 0},
+    {"translate_ns", 0, 0},
+    {"translate_cached_ns", 0, 0},
+    {"suggest_ns", 0, 0},
+    {"classify_ns", 0, 0},
+};
+
+static CorpusItem items[MAX_ITEMS];
+static int item_count = 0;
+static CorpusItem intent_cases[MAX_INTENT_CASES];
+static int intent_case_count = 0;
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Read "text<TAB>expected" lines into out; returns the count, or -1
+static int load_corpus(const char *path, CorpusItem *out, int max) {
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
+        perror(path);
+        return -1;
+    }
+    char line[MAX_LINE];
+    int count = 0;
+    while (fgets(line, sizeof(line), fp) && count < max) {
+        line[strcspn(line, "\r\n")] = '\0';
+        char *tab = strchr(line, '\t');
+        if (line[0] == '#' || !tab) continue;
+        *tab = '\0';
+        snprintf(out[count].text, MAX_LINE, "%s", line);
+        snprintf(out[count].expected, MAX_LINE, "%s", tab + 1);
+        count++;
+    }
+    fclose(fp);
+    return count;
+}
+
+// Split "cmd args..." at the first space; args is "" when there are none
+static void split_command(const char *command, char *name, size_t size, const char **args) {
+    size_t len = strcspn(command, " ");
+    snprintf(name, size, "%.*s", (int)len, command);
+    *args = command[len] ? command + len + 1 : "";
+}
+
+// ============ Accuracy ============
+
+static void measure_accuracy(int verbose) {
+    int exact = 0, command_ok = 0, with_args = 0, args_ok = 0, classified = 0, samples = 0;
+
+    for (int i = 0; i < item_count; i++) {
+        const CorpusItem *item = &items[i];
+        NLPResult result = nlp_translate(item->text);
+        const char *got = result.was_translated ? result.translated : "-";
+
+        if (strcmp(got, item->expected) == 0) exact++;
+        else if (verbose) printf("  miss: %-40s -> %-24s (want %s)\n", item->text, got, item->expected);
+
+        char want_name[64], got_name[64];
+        const char *want_args, *got_args;
+        split_command(item->expected, want_name, sizeof(want_name), &want_args);
+        split_command(got, got_name, sizeof(got_name), &got_args);
+        if (strcmp(want_name, got_name) == 0) {
+            command_ok++;
+            // Argument extraction is judged only where the intent was right
+            if (*want_args) {
+                with_args++;
+                if (strcmp(want_args, got_args) == 0) args_ok++;
+            }
+        }
+
+        // Utterances are natural language; expected commands are not
+        classified += nlp_is_natural_language(item->text) == 1;
+        samples++;
+        if (strcmp(item->expected, "-") != 0) {
+            classified += nlp_is_natural_language(item->expected) == 0;
+            samples++;
+        }
+    }
+
+    metrics[M_EXACT].value = 100.0 * exact / item_count;
+    metrics[M_COMMAND].value = 100.0 * command_ok / item_count;
+    metrics[M_ARGUMENTS].value = with_args ? 100.0 * args_ok / with_args : 100.0;
+    metrics[M_CLASSIFY].value = 100.0 * classified / samples;
+}
+
+// Paraphrases whose top intent is not the expected one
+static int check_intents(void) {
+    int misses = 0;
+    for (int i = 0; i < intent_case_count; i++) {
+        const CorpusItem *item = &intent_cases[i];
+        const char *got;
+        NLPIntentGuess guess;
+        NLPResult result;
+        if (strcmp(item->expected, "-") == 0) {
+            // Out of domain: nothing the shell would run
+            result = nlp_translate(item->text);
+            got = result.was_translated && !result.suggest_only ? result.translated : "-";
+        } else {
+            int n = nlp_rank_intents(item->text, &guess, 1);
+            got = n ? guess.command_template : "-";
+        }
+        if (strcmp(got, item->expected) != 0) {
+            printf("  intent miss: %-33s -> %-16s (want %s)\n", item->text, got, item->expected);
+            misses++;
+        }
+    }
+    return misses;
+}
+
+// ============ Latency ============
+
+typedef void (*BenchFn)(const CorpusItem *item);
+
+static void call_translate(const CorpusItem *item) {
+    nlp_cache_clear();
+    NLPResult result = nlp_translate(item->text);
+    (void)result;
+}
+
+static void call_translate_cached(const CorpusItem *item) {
+    NLPResult result = nlp_translate(item->text);
+    (void)result;
+}
+
+static void call_suggest(const CorpusItem *item) {
+    // What the frontend sends mid-word: the first half of the utterance
+    char partial[MAX_LINE];
+    size_t half = strlen(item->text) / 2;
+    snprintf(partial, sizeof(partial), "%.*s", (int)(half ? half : 1), item->text);
+    SuggestionList suggestions;
+    nlp_get_suggestions(partial, &suggestions);
+}
+
+static volatile int classify_sink;
+
+static void call_classify(const CorpusItem *item) {
+    classify_sink += nlp_is_natural_language(item->text);
+}
+
+// Mean ns per call over whole passes of the corpus
+static double measure_latency(BenchFn fn) {
+    for (int i = 0; i < item_count; i++) fn(&items[i]);   // Warm up
+
+    long calls = 0;
+    double start = now_sec(), elapsed;
+    do {
+        for (int i = 0; i < item_count; i++) fn(&items[i]);
+        calls += item_count;
+        elapsed = now_sec() - start;
+    } while (elapsed < MIN_SECONDS);
+    return elapsed / calls * 1e9;
+}
+
+// ============ Baseline ============
+
+static int load_baseline(const char *path, double *values, int *present) {
+    FILE *fp = fopen(path, "r");
+    if (!fp) return -1;
+    char line[256], name[64];
+    double value;
+    while (fgets(line, sizeof(line), fp)) {
+        if (line[0] == '#' || sscanf(line, "%63s %lf", name, &value) != 2) continue;
+        for (int m = 0; m < M_COUNT; m++) {
+            if (strcmp(name, metrics[m].name) == 0) {
+                values[m] = value;
+                present[m] = 1;
+            }
+        }
+    }
+    fclose(fp);
+    return 0;
+}
+
+static int save_baseline(const char *path) {
+    FILE *fp = fopen(path, "w");
+    if (!fp) {
+        perror(path);
+        return -1;
+    }
+    fprintf(fp, "# NLP benchmark baseline (accuracy in %%, latency in ns per call)\n");
+    fprintf(fp, "# Regenerate with: make bench-nlp-baseline\n");
+    for (int m = 0; m < M_COUNT; m++) fprintf(fp, "%s %.2f\n", metrics[m].name, metrics[m].value);
+    fclose(fp);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    int update = 0;
+    const char *intents_path = NULL;
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "--update") == 0) update = 1;
+        else if (strcmp(argv[i], "--intents") == 0 && i + 1 < argc) intents_path = argv[++i];
+        else argc = 0;
+    }
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s <corpus.tsv> <baseline.txt> [--intents <cases.tsv>] [--update]\n",
+                argv[0]);
+        return 2;
+    }
+    item_count = load_corpus(argv[1], items, MAX_ITEMS);
+    if (item_count < 0) return 2;
+    if (intents_path) {
+        intent_case_count = load_corpus(intents_path, intent_cases, MAX_INTENT_CASES);
+        if (intent_case_count < 0) return 2;
+    }
+    if (item_count == 0) {
+        fprintf(stderr, "%s: no labeled utterances\n", argv[1]);
+        return 2;
+    }
+
+    const char *tol_env = getenv("NLP_BENCH_TOLERANCE");
+    double tolerance = tol_env ? atof(tol_env) : DEFAULT_TOLERANCE;
+
+    nlp_init();
+    printf("NLP benchmark: %d labeled utterances\n\n", item_count);
+    measure_accuracy(1);
+    int intent_misses = check_intents();
+    metrics[M_TRANSLATE].value = measure_latency(call_translate);
+    metrics[M_TRANSLATE_CACHED].value = measure_latency(call_translate_cached);
+    metrics[M_SUGGEST].value = measure_latency(call_suggest);
+    metrics[M_CLASSIFY_NS].value = measure_latency(call_classify);
+
+    // Intent cases are pass/fail, and a failing model is no baseline
+    if (intent_misses) {
+        printf("\n%d of %d intent cases missed\n", intent_misses, intent_case_count);
+        return 1;
+    }
+
+    if (update) {
+        if (save_baseline(argv[2]) != 0) return 2;
+        printf("\n");
+        for (int m = 0; m < M_COUNT; m++) printf("%-22s %10.2f\n", metrics[m].name, metrics[m].value);
+        printf("\nBaseline written to %s\n", argv[2]);
+        return 0;
+    }
+
+    double baseline[M_COUNT] = {0};
+    int present[M_COUNT] = {0};
+    if (load_baseline(argv[2], baseline, present) != 0) {
+        fprintf(stderr, "%s: no baseline; create one with --update\n", argv[2]);
+    }
+
+    // Accuracy may not drop at all; latency may grow by the tolerance
+    int regressions = 0;
+    printf("\n%-22s %10s %10s %8s\n", "metric", "current", "baseline", "change");
+    for (int m = 0; m < M_COUNT; m++) {
+        const Metric *metric = &metrics[m];
+        if (!present[m]) {
+            printf("%-22s %10.2f %10s\n", metric->name, metric->value, "-");
+            continue;
+        }
+        int regressed = metric->higher_is_better
+            ? metric->value < baseline[m] - 0.005
+            : metric->value > baseline[m] * (1 + tolerance);
+        double change = baseline[m] ? (metric->value - baseline[m]) / baseline[m] * 100 : 0;
+        printf("%-22s %10.2f %10.2f %+7.1f%%%s\n", metric->name, metric->value, baseline[m],
+               change, regressed ? "  REGRESSION" : "");
+        regressions += regressed;
+    }
+
+    if (regressions) {
+        printf("\n%d regression(s) against %s\n", regressions, argv[2]);
+        return 1;
+    }
+    printf("\nNo regressions (latency tolerance %.0f%%)\n", tolerance * 100);
+    return 0;
+}
@@ -0,0 +1,57 @@
+/**
+ * Aho-Corasick Header - Multi-pattern substring matching
+ * All patterns are found in a single linear scan of the input.
+ * Patterns are sequences of 32-bit symbols: bytes for plain strings, or
+ * token ids when matching whole words.
+ * States and edges are stored in flat arrays so an automaton can be
+ * built once and scanned without further allocation.
+ */
+
+#ifndef AHO_CORASICK_H
+#define AHO_CORASICK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define AC_NO_OUTPUT (-1)
+
+typedef struct {
+    uint32_t first_edge;  // Index of this state's first edge
+    uint32_t edge_count;  // Edges are sorted by character
+    uint32_t fail;        // Longest proper suffix that is also a state
+    uint32_t dict_link;   // Nearest suffix state with an output (0 = none)
+    int32_t output;       // Pattern ending exactly here, AC_NO_OUTPUT if none
+} AcState;
+
+typedef struct {
+    uint32_t ch;
+    uint32_t target;
+} AcEdge;
+
+typedef struct {
+    AcState *states;      // State 0 is the root
+    uint32_t state_count;
+    AcEdge *edges;
+    uint32_t edge_count;
+} AcAutomaton;
+
+// Called for every pattern occurrence; end is the offset just past the match
+typedef void (*AcMatchFn)(int pattern_id, size_t end, void *ctx);
+
+// Build an automaton over count strings; pattern ids are array indices.
+// When two patterns are identical the lower id is reported.
+int ac_build(AcAutomaton *ac, const char *const *patterns, int count);
+
+// Build over symbol sequences; seqs[i] has lens[i] symbols
+int ac_build_seq(AcAutomaton *ac, const uint32_t *const *seqs, const uint32_t *lens, int count);
+
+// Scan len bytes of text, reporting every occurrence of every pattern
+void ac_scan(const AcAutomaton *ac, const char *text, size_t len, AcMatchFn fn, void *ctx);
+
+// Scan a symbol sequence; end offsets are in symbols
+void ac_scan_seq(const AcAutomaton *ac, const uint32_t *syms, size_t len, AcMatchFn fn, void *ctx);
+
+// Release automaton memory
+void ac_free(AcAutomaton *ac);
+
+#endif
@@ -0,0 +1,33 @@
+/**
+ * Arena Allocator Header - Bump allocation for long-lived shell records
+ * Records are carved out of large blocks and released all at once
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+#define ARENA_BLOCK_SIZE 16384
+
+typedef struct ArenaBlock {
+    struct ArenaBlock *next;
+    size_t used;
+    size_t size;
+    char data[];
+} ArenaBlock;
+
+typedef struct {
+    ArenaBlock *head;
+} Arena;
+
+// Initialize an empty arena (no memory is allocated until first use)
+void arena_init(Arena *arena);
+
+// Allocate size bytes, aligned for any record type
+void *arena_alloc(Arena *arena, size_t size);
+
+// Release every block owned by the arena
+void arena_free(Arena *arena);
+
+#endif
@@ -0,0 +1,13 @@
+/**
+ * Builtin Commands Header - Names the shell dispatches itself
+ * One list feeds the shell's completion trie and BK-tree and libnlpterm's,
+ * so a new command only has to be added in src/builtin_commands.c.
+ */
+
+#ifndef BUILTIN_COMMANDS_H
+#define BUILTIN_COMMANDS_H
+
+extern const char *const builtin_commands[];
+extern const int num_builtin_commands;
+
+#endif
@@ -1,6 +1,8 @@
 #ifndef COMMANDS_H
 #define COMMANDS_H
 
+#include <stddef.h>
+
 void do_ls(char **args);
 void do_pwd(char **args);
 void do_mkdir(char **args);
@@ -8,7 +10,8 @@ void do_rmdir(char **args);
 void do_rm(char **args);
 void do_touch(char **args);
 void do_cat(char **args);
-void do_cp(char **args);
+int do_cp(char **args);          // 0 if every source was copied
+int cp_target(char **args, char *target, size_t size);
 void do_mv(char **args);
 void do_echo(char **args);
 
@@ -15,7 +15,9 @@ void do_decrypt(char **args);    // Decrypt file
 
 // File Analysis
 void do_sizeof(char **args);     // Total size of matching files
+void do_dirtree(char **args);    // Tree with bottom-up directory sizes
 void do_age(char **args);        // Find files by age
+void do_ff(char **args);         // Fuzzy find paths in the tree
 void do_freq(char **args);       // Word frequency analysis
 void do_lines(char **args);      // Line/word/char statistics
 
@@ -0,0 +1,51 @@
+/**
+ * Directory Cache Header - In-memory snapshots of recently read directories
+ * Answers "does this path exist, and is it a directory?" and lists entries
+ * from a cached listing, so checking several names costs one check of
+ * their directory instead of a stat per name. Snapshots are invalidated by
+ * inotify where available and by the directory's mtime otherwise.
+ */
+
+#ifndef DIRCACHE_H
+#define DIRCACHE_H
+
+#include <stdint.h>
+#include <time.h>
+
+#define DIRCACHE_MAX_DIRS 32     // Snapshots kept; the least recently used goes
+#define DIRCACHE_RECHECK_MS 100  // A snapshot is trusted this long between checks
+#define DIRCACHE_WATCHED_RECHECK_MS 1000  // mtime recheck under inotify, for
+                                          // changes made by other hosts (NFS)
+
+typedef enum {
+    DIRCACHE_NONE = 0,           // No such entry
+    DIRCACHE_FILE,
+    DIRCACHE_DIR,
+    DIRCACHE_OTHER               // Device, socket, dangling link, ...
+} DirCacheType;
+
+typedef struct {
+    const char *name;
+    DirCacheType type;
+    int64_t size;                // Only filled when listed with want_stat
+    struct timespec mtime;
+} DirCacheItem;
+
+// Listing callback; return nonzero to stop
+typedef int (*DirCacheFn)(const DirCacheItem *item, void *ctx);
+
+// Type of the entry at path; relative paths are resolved against the
+// working directory. Symlinks report their target's type. Thread-safe.
+DirCacheType dircache_lookup(const char *path);
+
+// Call fn for each entry of dir whose name starts with prefix, skipping
+// "." and "..". With want_stat, sizes and mtimes are read on first use and
+// kept until the entry changes. fn runs under the cache lock and must not
+// call back into the cache. Returns the entries passed to fn, or -1 if
+// dir cannot be read.
+int dircache_list(const char *dir, const char *prefix, int want_stat, DirCacheFn fn, void *ctx);
+
+// Drop every snapshot
+void dircache_clear(void);
+
+#endif
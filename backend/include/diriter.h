@@ -0,0 +1,41 @@
+/**
+ * Directory Iterator Header - Entry types without a stat per entry
+ * Wraps readdir so callers get each entry's type from d_type, falling back
+ * to fstatat(dirfd, name, AT_SYMLINK_NOFOLLOW) only on filesystems that
+ * leave it unknown. Metadata and subdirectories are reached relative to the
+ * open directory, so walking never builds a path string.
+ */
+
+#ifndef DIRITER_H
+#define DIRITER_H
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+typedef struct {
+    DIR *dir;
+    int fd;                      // The directory, for *at() calls on entries
+    const char *name;            // Current entry, valid until the next call
+    unsigned char type;          // DT_REG, DT_DIR, DT_LNK, ...; DT_UNKNOWN
+                                 // only if the entry vanished
+    int stat_state;              // 0 = not read, 1 = st valid, -1 = failed
+    struct stat st;
+} DirIter;
+
+// Open path for iteration. Returns 0, or -1 with errno set.
+int diriter_open(DirIter *it, const char *path);
+
+// Open the entry name of the directory dirfd, without following a symlink.
+// This is how walkers descend: no path is built.
+int diriter_openat(DirIter *it, int dirfd, const char *name);
+
+// Advance to the next entry, skipping "." and "..". Returns 1, or 0 at the end.
+int diriter_next(DirIter *it);
+
+// The current entry's lstat-style metadata, read on first call. NULL if
+// the entry is gone.
+const struct stat *diriter_stat(DirIter *it);
+
+void diriter_close(DirIter *it);
+
+#endif
@@ -0,0 +1,75 @@
+/**
+ * Directory List Header - Whole directories read in bulk
+ * getdents64 fills large buffers straight from the kernel and the entries
+ * are indexed in place, so a directory of a few hundred thousand names
+ * costs a handful of system calls and no per-name copy or allocation.
+ * The result is a plain array to sort or filter. A list keeps its buffers
+ * between reads, so reading directory after directory into the same list
+ * allocates nothing once it has seen the largest one.
+ */
+
+#ifndef DIRLIST_H
+#define DIRLIST_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#define DIRLIST_BLOCK_SIZE 65536       // First buffer; later ones double
+#define DIRLIST_MAX_BLOCK (1 << 22)    // Up to this size
+
+typedef struct {
+    const char *name;            // Valid until the list is read again
+    uint64_t ino;
+    unsigned char type;          // DT_REG, DT_DIR, DT_LNK, ...; DT_UNKNOWN
+                                 // only if the entry vanished
+} DirListEntry;
+
+typedef struct DirListBlock DirListBlock;
+
+typedef struct {
+    DirListEntry *entries;       // "." and ".." are left out
+    size_t count;
+    size_t capacity;
+    int fd;                      // The directory, for *at() calls on entries;
+                                 // -1 before the first successful read
+    DirListBlock *blocks;        // getdents64 buffers, kept for the next read
+} DirList;
+
+// Initialize an empty list (no memory is allocated until the first read)
+void dirlist_init(DirList *list);
+
+// Replace the list's contents with the directory at path. The directory
+// stays open in list->fd until the next read or dirlist_free. Returns 0,
+// or -1 with errno set and the list empty.
+int dirlist_read(DirList *list, const char *path);
+
+// The same for the entry name of the directory dirfd, without following
+// a symlink. This is how walkers descend: no path is built.
+int dirlist_readat(DirList *list, int dirfd, const char *name);
+
+// Order the entries; cmp receives two const DirListEntry pointers
+void dirlist_sort(DirList *list, int (*cmp)(const void *, const void *));
+
+// By name, bytewise
+int dirlist_by_name(const void *a, const void *b);
+
+// By inode number: stat-ing a large directory in this order reads each
+// inode table block once on most filesystems
+int dirlist_by_inode(const void *a, const void *b);
+
+// Keep only the entries for which keep returns nonzero, in their order.
+// Returns the new count.
+size_t dirlist_filter(DirList *list, int (*keep)(const DirListEntry *e, void *ctx), void *ctx);
+
+// lstat-style metadata of an entry. Returns 0, or -1 if it is gone.
+int dirlist_stat(const DirList *list, const DirListEntry *e, struct stat *st);
+
+// The DT_* type for a st_mode, for entries whose d_type was unknown
+unsigned char dirlist_mode_type(mode_t mode);
+
+// Close the directory and release every buffer
+void dirlist_free(DirList *list);
+
+#endif
@@ -0,0 +1,43 @@
+/**
+ * File Copy Header - File and tree copies that stay in the kernel
+ * A file is cloned when its filesystem can share extents (FICLONE),
+ * copied with copy_file_range when it can't, and through a large buffer
+ * as a last resort. Only the data regions SEEK_DATA finds are copied, so
+ * holes stay holes. A tree is copied by a pool of threads sharing one
+ * queue of directories and files.
+ */
+
+#ifndef FILECOPY_H
+#define FILECOPY_H
+
+#include <stdint.h>
+
+#define FILECOPY_MIN_THREADS 4       // Copies wait on the disk, not the CPU
+#define FILECOPY_MAX_THREADS 16
+#define FILECOPY_BUFFER_SIZE (1 << 20)
+
+typedef struct {
+    uint64_t files;
+    uint64_t dirs;
+    uint64_t links;              // Symlinks, recreated rather than followed
+    uint64_t bytes;              // Apparent size of the files copied
+    uint64_t cloned;             // Files sharing extents with their source
+    uint64_t errors;
+    int threads;
+    double elapsed_ms;
+} FileCopyStats;
+
+// Both calls add their counts and time to stats.
+
+// Copy the file src to dst, creating or truncating it, and give dst src's
+// permission bits. Returns 0, or with errno set -1 if src could not be
+// read and -2 if dst could not be written.
+int filecopy_file(const char *src, const char *dst, FileCopyStats *stats);
+
+// Copy the directory src and everything below it to dst, which is created
+// if needed. Symlinks are copied as links; other special files are
+// skipped. Errors are reported on stderr prefixed with name, and the rest
+// of the tree is still copied. Returns 0 if everything was copied.
+int filecopy_tree(const char *name, const char *src, const char *dst, FileCopyStats *stats);
+
+#endif
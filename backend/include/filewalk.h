@@ -0,0 +1,66 @@
+/**
+ * File Walk Header - Parallel content scans over files and directory trees
+ * The regular files under a set of paths are collected by a parallel walk,
+ * sorted, and handed to a scan function on a pool of threads. Large files
+ * are mapped and small ones read whole, so a scan always sees a file as
+ * one buffer. Each file's output is held until every file before it has
+ * been printed, so results come out in the same order on any number of
+ * threads. Workers stay within a window of files ahead of the one being
+ * printed, so one slow file holds back a bounded amount of output.
+ */
+
+#ifndef FILEWALK_H
+#define FILEWALK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define FILEWALK_MAX_THREADS 16
+#define FILEWALK_BINARY_PROBE 8192    // Leading bytes checked for a NUL
+#define FILEWALK_MMAP_MIN (1 << 20)   // Files this large are mapped, not read
+#define FILEWALK_WINDOW 256           // Files scanned ahead of the printed one
+
+// Text a scan wants printed for its file
+typedef struct {
+    char *data;
+    size_t len;
+    size_t cap;
+} FileWalkOutput;
+
+void filewalk_append(FileWalkOutput *out, const char *s, size_t len);
+void filewalk_printf(FileWalkOutput *out, const char *fmt, ...)
+    __attribute__((format(printf, 2, 3)));
+
+// Newlines in [p, end), for line numbers counted only up to each match
+long filewalk_count_lines(const char *p, const char *end);
+
+// Scan one file's contents, which are not NUL-terminated. Runs on a worker
+// thread, so it may only write to out. Returns the file's match count.
+typedef long (*FileScanFn)(const char *path, const char *data, size_t len,
+                           FileWalkOutput *out, void *ctx);
+
+typedef struct {
+    const char *name;            // Prefix for error messages
+    int recurse;                 // Descend into directories; without it a
+                                 // directory argument is reported and skipped
+    FileScanFn scan;
+    void *ctx;
+} FileWalk;
+
+typedef struct {
+    uint64_t files;              // Scanned
+    uint64_t binary;             // Skipped for a NUL in their first bytes
+    uint64_t bytes;              // Scanned
+    int threads;
+    double elapsed_ms;
+} FileWalkStats;
+
+// Scan the files named in paths and, with recurse, every regular file
+// below the named directories. Hidden entries and symlinks met during the
+// walk are skipped. Files are scanned in argument order, and below each
+// directory in path order. Small files are read to EOF whatever size they
+// report, so /proc entries and FIFOs work. Returns the total of the scan
+// results.
+long filewalk_run(const FileWalk *walk, char **paths, int count, FileWalkStats *stats);
+
+#endif
@@ -1,8 +1,11 @@
 #ifndef HISTORY_H
 #define HISTORY_H
 
+#include "arena.h"
+#include "strpool.h"
+
 typedef struct HistoryNode {
-    char *command;
+    StrId command;  // Interned in the global string pool
     struct HistoryNode *next;
     struct HistoryNode *prev;
 } HistoryNode;
@@ -12,7 +15,8 @@ typedef struct {
     HistoryNode *tail;
     int count;
     int capacity;
-    char **array; // Dynamic array for fast access by index
+    StrId *array; // Dynamic array for fast access by index
+    Arena nodes;  // Backing storage for HistoryNode records
 } History;
 
 History *init_history(int capacity);
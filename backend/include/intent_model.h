@@ -0,0 +1,53 @@
+/**
+ * Intent Model Header - Naive Bayes intent classifier over hashed features
+ * Words, word pairs and word prefixes are hashed into a fixed number of
+ * buckets. Training stores, per bucket, only the intents that were seen
+ * with it, so scoring touches just the input's own feature rows.
+ */
+
+#ifndef INTENT_MODEL_H
+#define INTENT_MODEL_H
+
+#include <stdint.h>
+
+#define INTENT_FEATURE_BITS 12    // 4096 feature buckets
+#define INTENT_TOP_K 3
+
+// One labeled training example
+typedef struct {
+    const char *text;
+    int intent;
+} IntentExample;
+
+// Sparse per-bucket entry: how much more likely the feature is under intent
+typedef struct {
+    uint32_t intent;
+    float boost;
+} IntentWeight;
+
+typedef struct {
+    int intent_count;        // Priors are uniform over these
+    double *unseen;          // Per intent: log P(feature) for an unseen feature
+    uint32_t *row_start;     // Bucket b's weights are [row_start[b], row_start[b + 1])
+    IntentWeight *weights;
+} IntentModel;
+
+typedef struct {
+    int intent;
+    double probability;      // Posterior over all intents
+} IntentScore;
+
+// Train from labeled examples; returns 1 on success
+int intent_model_train(IntentModel *model, const IntentExample *examples, int count, int intent_count);
+
+// Best intents for input, most likely first. Returns how many were written
+// (0 when no input feature was seen in training).
+int intent_model_predict(const IntentModel *model, const char *input, IntentScore *out, int max);
+
+// Share (0..1) of the input's words, fillers aside, that training saw.
+// A word hashed into a bucket another word filled counts as seen.
+double intent_model_coverage(const IntentModel *model, const char *input);
+
+void intent_model_free(IntentModel *model);
+
+#endif
@@ -1,13 +1,15 @@
 #ifndef MACROS_H
 #define MACROS_H
 
+#include "strpool.h"
+
 typedef struct MacroStep {
-    char *command;
+    StrId command;  // Interned in the macros' pool
     struct MacroStep *next;
 } MacroStep;
 
 typedef struct Macro {
-    char *name;
+    StrId name;
     MacroStep *head;
     MacroStep *tail;
     struct Macro *next;
@@ -19,6 +21,7 @@ void add_macro_step(const char *command);
 void end_recording_macro();
 int run_macro(const char *name);
 Macro *find_macro(const char *name);
+const char *macro_string(StrId id);  // Text of a macro name or step
 void free_macros();
 
 #endif
@@ -0,0 +1,27 @@
+/**
+ * N-gram Predictor Header - Next-command prediction from history
+ * A Markov model over executed commands: the previous one or two
+ * commands predict what the user is likely to run next
+ */
+
+#ifndef NGRAM_H
+#define NGRAM_H
+
+#include "strpool.h"
+
+#define NGRAM_CANDIDATES 4  // Next-command candidates kept per context
+
+// Reset the model and forget the current context
+void ngram_init(void);
+
+// Train on an executed command and advance the context
+void ngram_observe(const char *cmd);
+
+// Predict next commands for the current context, best first.
+// Fills up to max ids and returns how many were written.
+int ngram_predict(StrId *out, int max);
+
+// Release model memory
+void ngram_free(void);
+
+#endif
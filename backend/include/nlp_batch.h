@@ -0,0 +1,42 @@
+/**
+ * NLP Batch Header - Translate a file of utterances across worker threads
+ * Used to replay logged phrases against a pattern pack in one process,
+ * with per-item latency and a throughput/percentile summary.
+ */
+
+#ifndef NLP_BATCH_H
+#define NLP_BATCH_H
+
+#define NLP_BATCH_MAX_THREADS 64
+
+typedef struct {
+    const char *text;            // Points into the batch's file buffer
+    char *command;               // Translation, NULL if none
+    double confidence;
+    double latency_us;
+} NLPBatchItem;
+
+typedef struct {
+    NLPBatchItem *items;
+    int count;
+    char *text;                  // File contents, one utterance per line
+
+    // Filled in by nlp_batch_run()
+    int threads;
+    int translated;
+    double wall_ms;
+    double per_second;
+    double p50_us;
+    double p99_us;
+} NLPBatch;
+
+// Read utterances from path, skipping blank and '#' lines.
+// Returns 0 on success, -1 with errno set.
+int nlp_batch_load(const char *path, NLPBatch *batch);
+
+// Translate every item with up to threads workers (0 = one per CPU)
+void nlp_batch_run(NLPBatch *batch, int threads);
+
+void nlp_batch_free(NLPBatch *batch);
+
+#endif
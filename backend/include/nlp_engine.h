@@ -6,9 +6,12 @@
 #ifndef NLP_ENGINE_H
 #define NLP_ENGINE_H
 
+#include <stddef.h>
+
 #define MAX_SUGGESTIONS 10
 #define MAX_SUGGESTION_LEN 256
 #define MAX_PATTERN_LEN 512
+#define NLP_MAX_STEPS 8      // Commands in one multi-step request
 
 // Suggestion structure
 typedef struct {
@@ -23,21 +26,70 @@ typedef struct {
     char translated[MAX_PATTERN_LEN];
     int was_translated;
     char explanation[MAX_PATTERN_LEN];
+    double confidence;  // 0..1, share of the input's pattern words explained
+    char argument[MAX_SUGGESTION_LEN];  // Last argument filled into the command
+    int suggest_only;   // Offer the command but do not run it: a model guess,
+                        // or a file argument that names nothing on disk
 } NLPResult;
 
+// One statistical intent guess
+typedef struct {
+    char command_template[MAX_SUGGESTION_LEN];
+    char explanation[MAX_SUGGESTION_LEN];
+    double probability;
+} NLPIntentGuess;
+
+// Translation cache counters (shown by "stats")
+typedef struct {
+    unsigned long hits;
+    unsigned long misses;
+    unsigned long evictions;
+    int entries;
+    int capacity;
+} NLPCacheStats;
+
 // Initialize NLP engine
 void nlp_init(void);
 
+// Load the pattern pack from path instead of $NLP_PATTERN_PACK or the
+// executable's data/ directory. Call before nlp_init().
+void nlp_set_pack_path(const char *path);
+
 // Translate natural language to shell command
 NLPResult nlp_translate(const char *input);
 
+// Translate a request that may chain commands ("create folder build and
+// go to it") into up to max steps, in order. Later steps may say "it" for
+// the previous step's argument. Returns the step count; a request that
+// does not split into translatable clauses comes back as one step, the
+// same as nlp_translate().
+int nlp_translate_sequence(const char *input, NLPResult *steps, int max);
+
+// Most likely intents for input from the statistical model (at most 3),
+// best first. Works for phrasings no pattern lists; returns the count.
+int nlp_rank_intents(const char *input, NLPIntentGuess *out, int max);
+
+// Read or reset the translation cache
+void nlp_cache_get_stats(NLPCacheStats *stats);
+void nlp_cache_clear(void);
+
 // Get command suggestions based on partial input (for intellisense)
 void nlp_get_suggestions(const char *partial, SuggestionList *suggestions);
 
-// Get the best suggestion for autocomplete
-const char* nlp_get_best_suggestion(const char *partial);
+// Append whole phrases completing partial ("show fi" -> "show files"),
+// most used first, until suggestions is full. One-word phrases already
+// in the list are skipped.
+void nlp_complete_phrases(const char *partial, SuggestionList *suggestions);
+
+// Copy the best autocomplete suggestion into best; returns 0 if there is none
+int nlp_get_best_suggestion(const char *partial, char *best, size_t size);
+
+// Confidence (0..1) that input is natural language rather than a command.
+// One pass over the input, cheap enough to run on every keystroke.
+double nlp_classify(const char *input);
 
-// Check if input looks like natural language
+// nlp_classify() at or above the threshold
+#define NLP_NL_THRESHOLD 0.5
 int nlp_is_natural_language(const char *input);
 
 // Get command description/help
@@ -0,0 +1,183 @@
+/**
+ * NLP Pattern Pack Header - Compiled phrase tables for the NLP engine
+ * A pack is one flat image holding the string pool, the word vocabulary
+ * with its inverted index, the synonym table and the phrase automaton.
+ * All references are
+ * offsets or indices, so a pack file can be mmap'd and used in place.
+ */
+
+#ifndef NLP_PACK_H
+#define NLP_PACK_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "aho_corasick.h"
+
+#define NLP_PACK_MAGIC "NLPPACK1"
+#define NLP_PACK_VERSION 2
+#define NLP_MAX_TOKEN_LEN 64
+#define NLP_MAX_PHRASE_TOKENS 16  // Phrase word positions fit a 32-bit mask
+
+// One intent before compilation: every phrase that means command_template
+typedef struct {
+    const char *const *phrases;
+    int phrase_count;
+    const char *command_template;
+    const char *explanation;
+} NLPIntentDef;
+
+// A word and the canonical form it normalizes to ("dirs" -> "folder").
+// Covers both synonyms and inflections, so phrases need only one form.
+typedef struct {
+    const char *word;
+    const char *canonical;
+} NLPSynonymDef;
+
+// A parsed pattern source file; every string points into text
+typedef struct {
+    NLPIntentDef *intents;
+    int intent_count;
+    const char **phrases;
+    NLPSynonymDef *synonyms;
+    int synonym_count;
+    char *text;
+} NLPSource;
+
+// Input token: normalized text plus its span in the original input
+typedef struct {
+    char text[NLP_MAX_TOKEN_LEN];
+    int start;
+    int len;
+} NLPToken;
+
+// ============ Image Layout ============
+// Section offsets are bytes from the start of the image, 8-byte aligned.
+// String fields are offsets into the string pool.
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t size;                // Total image bytes
+    uint32_t intent_count;
+    uint32_t phrase_count;
+    uint32_t word_count;          // Including the reserved id 0
+    uint32_t slot_count;          // Word hash slots (power of two)
+    uint32_t token_count;         // Phrase words, also the posting count
+    uint32_t state_count;
+    uint32_t edge_count;
+    uint32_t strings_size;
+    uint32_t off_intents;
+    uint32_t off_phrases;
+    uint32_t off_tokens;
+    uint32_t off_words;
+    uint32_t off_slots;
+    uint32_t off_postings;
+    uint32_t off_states;
+    uint32_t off_edges;
+    uint32_t off_strings;
+    uint32_t synonym_count;
+    uint32_t synonym_slot_count;  // Perfect hash slots (power of two, or 0)
+    uint32_t synonym_bucket_count;
+    uint32_t off_synonyms;
+    uint32_t off_synonym_seeds;   // One hash seed per bucket
+    uint32_t reserved;
+} NLPPackHeader;
+
+typedef struct {
+    uint32_t template_str;
+    uint32_t explanation_str;
+    uint32_t first_phrase;
+    uint32_t phrase_count;
+} NLPPackIntent;
+
+typedef struct {
+    double weight;                // Sum of its word weights
+    uint32_t text_str;
+    uint32_t intent;
+    uint32_t first_token;         // Index into the phrase token array
+    uint32_t token_count;
+} NLPPackPhrase;
+
+typedef struct {
+    double weight;                // Inverse intent frequency
+    uint32_t text_str;
+    uint32_t first_posting;
+    uint32_t posting_count;
+    uint32_t reserved;
+} NLPPackWord;
+
+// Synonym slot; empty slots have word_str == NLP_PACK_NO_STRING
+typedef struct {
+    uint32_t word_str;
+    uint32_t canonical_str;
+} NLPPackSynonym;
+
+#define NLP_PACK_NO_STRING UINT32_MAX
+
+// A phrase word occurrence: which phrase, and where in it
+typedef struct {
+    uint32_t phrase;
+    uint32_t pos;
+} NLPPosting;
+
+// A loaded pack: typed views into one image
+typedef struct {
+    void *image;
+    size_t size;
+    int mapped;                   // 1 = mmap'd file, 0 = heap image
+    const NLPPackHeader *header;
+    const NLPPackIntent *intents;
+    const NLPPackPhrase *phrases;
+    const uint32_t *tokens;
+    const NLPPackWord *words;     // Word id 0 means "not a pattern word"
+    const uint32_t *slots;
+    const NLPPosting *postings;
+    const NLPPackSynonym *synonyms;
+    const uint32_t *synonym_seeds;
+    const char *strings;
+    AcAutomaton automaton;        // Exact word runs over word ids
+} NLPPack;
+
+// Split on whitespace into normalized words; returns the number written
+int nlp_tokenize(const char *input, NLPToken *tokens, int max);
+
+// Singular of a regular plural ("files" -> "file", "directories" ->
+// "directory", "processes" -> "process") into out, NLP_MAX_TOKEN_LEN
+// bytes. Returns 0, with out empty, for words under four letters and
+// -ss, -us, -is endings ("class", "status", "this").
+int nlp_stem(const char *word, char *out);
+
+// Compile intents and synonyms into a heap image; NULL on error. Phrases
+// are normalized through the synonyms, and phrases of one intent that
+// normalize to the same words are stored once.
+NLPPack *nlp_pack_compile(const NLPIntentDef *defs, int count,
+                          const NLPSynonymDef *synonyms, int synonym_count);
+
+// Parse a text pattern source. Returns 0 on success, -1 if the file is
+// missing (errno set) or malformed (message on stderr).
+int nlp_pack_read_source(const char *path, NLPSource *src);
+void nlp_pack_free_source(NLPSource *src);
+
+// Compile a text pattern source into a pack file (replaced atomically).
+// Returns 0 on success, -1 on error with a message on stderr.
+int nlp_pack_compile_file(const char *source_path, const char *pack_path);
+
+// Map and validate a pack file; NULL if missing or malformed
+NLPPack *nlp_pack_open(const char *path);
+
+// Word id for a normalized word, 0 if it is not in the pack
+uint32_t nlp_pack_lookup(const NLPPack *pack, const char *word);
+
+// Canonical form of a normalized word, or the word itself if it has none
+const char *nlp_pack_canonical(const NLPPack *pack, const char *word);
+
+// Replace each token's text with its canonical form
+void nlp_pack_normalize(const NLPPack *pack, NLPToken *tokens, int count);
+
+// String pool access
+const char *nlp_pack_string(const NLPPack *pack, uint32_t offset);
+
+// Unmap or free a pack
+void nlp_pack_free(NLPPack *pack);
+
+#endif
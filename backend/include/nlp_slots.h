@@ -0,0 +1,63 @@
+/**
+ * NLP Slot Filling Header - Arguments for translated commands
+ * Splits a request into candidate arguments, keeping quoted strings and
+ * backslash-escaped spaces together, and fills each %s of a command
+ * template with the best-ranked candidate. Candidates rank higher when
+ * they exist on disk with the type the command expects, look like paths,
+ * are quoted, or follow "called"/"named"; pattern words rank lowest.
+ */
+
+#ifndef NLP_SLOTS_H
+#define NLP_SLOTS_H
+
+#include <stddef.h>
+#include <limits.h>
+#include "nlp_pack.h"
+
+#define NLP_MAX_SLOTS 2
+#define NLP_SLOT_LEN 256
+#define NLP_SLOT_MAX_WORDS 64
+
+typedef struct {
+    char text[NLP_SLOT_LEN];     // Unquoted and unescaped
+    char word[NLP_MAX_TOKEN_LEN];  // Normalized text, "" when quoted
+    int start, end;              // Span in the input
+    int quoted;
+    int stop;                    // Grammar word ("the", "to", ...)
+    int pattern;                 // Pack word: an argument only if it exists
+    int marked;                  // Follows "called" or "named"
+    int type;                    // DirCacheType, -1 until looked up
+} NLPSlotWord;
+
+// One request, lexed on first use and shared by every template tried
+// against it, so ranking several intents lexes and stats only once
+typedef struct {
+    const NLPPack *pack;
+    const char *input;
+    NLPSlotWord words[NLP_SLOT_MAX_WORDS];
+    int count;                   // -1 until lexed
+    char cwd[PATH_MAX];          // "" until a relative word is looked up
+    int missing;                 // Last fill put a word naming nothing on
+                                 // disk into a file or directory slot
+} NLPSlotInput;
+
+void nlp_slot_input_init(NLPSlotInput *in, const NLPPack *pack, const char *input);
+
+// Fill the %s slots of command_template from the request. Returns the
+// number of slots in the template when all were filled, else 0, and sets
+// in->missing. Values are unquoted; pass them through nlp_shell_quote()
+// before use.
+int nlp_fill_slots(NLPSlotInput *in, const char *command_template,
+                   char out[NLP_MAX_SLOTS][NLP_SLOT_LEN]);
+
+// A request that opens with a copy or move verb and names an explicit
+// source (quoted or path-like) before "to", "into" or "as" and a
+// destination after it: "copy 'my report.txt' to backup". Returns the
+// command template it asks for ("cp %s %s") with both slots filled, or
+// NULL. Such a request outranks any phrase its destination matches.
+const char *nlp_fill_transfer(NLPSlotInput *in, char out[NLP_MAX_SLOTS][NLP_SLOT_LEN]);
+
+// Quote arg for the shell's parser if it holds spaces or quotes
+void nlp_shell_quote(const char *arg, char *out, size_t size);
+
+#endif
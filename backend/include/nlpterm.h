@@ -0,0 +1,78 @@
+/**
+ * libnlpterm Header - In-process C API for the shell's engines
+ * Lets a frontend call the NLP engine, suggestion engine, command trie,
+ * BK-tree and system monitor directly instead of over the shell's pipe.
+ *
+ * The API is stable: only nlpterm_* symbols are exported, arguments are
+ * plain C types, and results go into caller buffers. Every function may
+ * be called from any thread. Lists are returned '|'-separated, the same
+ * format as the SUGGESTIONS: reply.
+ */
+
+#ifndef NLPTERM_H
+#define NLPTERM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define NLPTERM_API_VERSION 2
+
+#ifdef NLPTERM_BUILD
+#define NLPTERM_API __attribute__((visibility("default")))
+#else
+#define NLPTERM_API
+#endif
+
+// System snapshot. Set size to sizeof(NLPTermSysInfo) before the call;
+// later versions only append fields.
+typedef struct {
+    uint32_t size;
+    int32_t num_cores;
+    double cpu_percent;
+    uint64_t mem_total_bytes;
+    uint64_t mem_used_bytes;
+    double mem_percent;
+    uint64_t uptime_seconds;
+} NLPTermSysInfo;
+
+// API version the library was built with (NLPTERM_API_VERSION)
+NLPTERM_API int nlpterm_version(void);
+
+// Load the engines. pack_path names the NLP pattern pack; NULL uses
+// $NLP_PATTERN_PACK or the built-in phrases. Returns 0 on success.
+// Later calls do nothing.
+NLPTERM_API int nlpterm_init(const char *pack_path);
+
+// Translate natural language. Returns 1 and fills command (and, if not
+// NULL, explanation and confidence) when input was translated, else 0.
+// Returns 2 for a translation to offer but not run: a guess, or a file
+// argument that does not exist.
+NLPTERM_API int nlpterm_translate(const char *input, char *command, size_t command_size,
+                                  char *explanation, size_t explanation_size, double *confidence);
+
+// Confidence (0..1) that input is natural language
+NLPTERM_API double nlpterm_classify(const char *input);
+
+// Command suggestions for a partial command line, then whole phrases
+// completing it ("show fi" -> "show files"); an empty partial gives
+// predictions of the next command. Returns the number written to out.
+NLPTERM_API int nlpterm_suggest(const char *partial, char *out, size_t size);
+
+// Argument suggestions for cmd (paths for cd, cat, ...). Relative paths
+// are completed against cwd, or the process directory if cwd is NULL.
+NLPTERM_API int nlpterm_suggest_context(const char *cmd, const char *partial, const char *cwd,
+                                        char *out, size_t size);
+
+// Built-in commands starting with prefix, in order
+NLPTERM_API int nlpterm_complete(const char *prefix, char *out, size_t size);
+
+// Built-in commands within max_distance edits of word
+NLPTERM_API int nlpterm_correct(const char *word, int max_distance, char *out, size_t size);
+
+// Record an executed command for history-based suggestions
+NLPTERM_API void nlpterm_add_history(const char *command);
+
+// Fill info; returns 0 on success, -1 if info->size is too small
+NLPTERM_API int nlpterm_sysinfo(NLPTermSysInfo *info);
+
+#endif
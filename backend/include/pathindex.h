@@ -0,0 +1,49 @@
+/**
+ * Path Index Header - Fuzzy file finding across a whole directory tree
+ * A parallel walk records every path under the working directory in one
+ * flat array, which fuzzy queries scan with a character-set prefilter.
+ * The index is saved under ~/.nlp_paths and refreshed incrementally: a
+ * directory whose mtime has not moved keeps its old listing, so a refresh
+ * costs one stat per directory instead of a full walk.
+ */
+
+#ifndef PATHINDEX_H
+#define PATHINDEX_H
+
+#include <stdint.h>
+
+#define PATHINDEX_PATH_MAX 1024       // Longer relative paths are not indexed
+#define PATHINDEX_MAX_ENTRIES 2000000 // The walk stops descending past this
+#define PATHINDEX_MAX_THREADS 16
+#define PATHINDEX_REFRESH_MS 2000     // An older index is refreshed before use
+#define PATHINDEX_DIR ".nlp_paths"    // Under $HOME; $NLP_PATH_INDEX_DIR overrides,
+                                      // set but empty disables saving
+
+typedef struct {
+    char path[PATHINDEX_PATH_MAX];    // Relative to the working directory
+    int is_dir;
+    int score;
+} PathMatch;
+
+typedef struct {
+    uint32_t paths;
+    uint32_t dirs;
+    uint32_t dirs_read;               // Listings read by the last refresh; the
+                                      // other directories were unchanged
+    int threads;
+    int truncated;                    // PATHINDEX_MAX_ENTRIES was reached
+    double refresh_ms;
+} PathIndexStats;
+
+// Up to max paths under the working directory matching query as a
+// subsequence, best first. Hidden entries and other filesystems are not
+// indexed. Lowercase queries ignore case. With wait, a missing or stale
+// index is built or refreshed first. Without it, whatever index is loaded
+// answers and a refresh starts in the background, so a caller on the
+// keystroke path never blocks on a walk. Returns the number of matches.
+int pathindex_find(const char *query, int dirs_only, int wait, PathMatch *out, int max);
+
+// Size of the loaded index and the cost of its last refresh
+void pathindex_stats(PathIndexStats *stats);
+
+#endif
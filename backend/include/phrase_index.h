@@ -0,0 +1,58 @@
+/**
+ * Phrase Index Header - Prefix completion over the pattern phrases
+ * A character trie over every phrase where each node keeps its best
+ * PHRASE_INDEX_TOP completions, most used first. Completing a prefix is a
+ * walk down the trie plus a copy of that list, so the cost depends on the
+ * typed length rather than on the number of phrases.
+ */
+
+#ifndef PHRASE_INDEX_H
+#define PHRASE_INDEX_H
+
+#include <stdint.h>
+#include "arena.h"
+
+#define PHRASE_INDEX_TOP 10      // Completions kept per node
+
+typedef struct {
+    uint32_t first_edge;
+    uint32_t edge_count;         // Edges are sorted by character
+    uint32_t parent;
+    uint32_t top_count;
+} PhraseNode;
+
+typedef struct {
+    unsigned char ch;
+    uint32_t target;
+} PhraseEdge;
+
+typedef struct {
+    PhraseNode *nodes;           // Node 0 is the root
+    uint32_t node_count;
+    PhraseEdge *edges;
+    uint32_t *top;               // Node n's list is top[n * PHRASE_INDEX_TOP], best first
+    int phrase_count;
+    const char **texts;          // Per phrase, copied into the arena
+    uint32_t *lengths;
+    uint32_t *uses;              // Per phrase: times it was used
+    uint32_t *leaf;              // Per phrase: its node, 0 for a duplicate
+    Arena arena;
+} PhraseIndex;
+
+// Build over count phrases; phrase ids are array indices. Of two identical
+// phrases only the lower id is indexed. Returns 1 on success.
+int phrase_index_build(PhraseIndex *index, const char *const *phrases, int count);
+
+// Up to max phrase ids starting with prefix, most used first (ties go to
+// the shorter phrase). Returns how many were written.
+int phrase_index_complete(const PhraseIndex *index, const char *prefix, uint32_t *out, int max);
+
+// Count one use of a phrase, moving it up the lists it is in
+void phrase_index_use(PhraseIndex *index, uint32_t phrase);
+
+// Text of a phrase as indexed
+const char *phrase_index_text(const PhraseIndex *index, uint32_t phrase);
+
+void phrase_index_free(PhraseIndex *index);
+
+#endif
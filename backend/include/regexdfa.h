@@ -0,0 +1,64 @@
+/**
+ * Regex DFA Header - Extended regular expressions without backtracking
+ * A pattern is parsed, turned into a Thompson NFA and then into a complete
+ * DFA before any input is seen, so matching a line is one table lookup per
+ * byte whatever the pattern, and a compiled pattern can be shared by any
+ * number of threads. The longest string every match must contain is kept
+ * for a memmem prefilter.
+ *
+ * Syntax is POSIX ERE as in grep -E: . [] [^] [:class:] * + ? {m,n} | ()
+ * ^ $, plus \d \w \s and their negations. Backreferences and word
+ * boundaries need more than a DFA and are rejected.
+ */
+
+#ifndef REGEXDFA_H
+#define REGEXDFA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define REGEXDFA_ICASE 1              // Letters match either case
+#define REGEXDFA_FIXED 2              // The pattern is a plain string
+
+#define REGEXDFA_MAX_STATES 4096      // Patterns needing more DFA states fail
+#define REGEXDFA_MAX_REPEAT 255       // Largest bound in {m,n}
+#define REGEXDFA_LITERAL_MAX 64
+
+// Kinds of stop state
+#define REGEXDFA_ACCEPT 1             // The line matches
+#define REGEXDFA_DEAD 2               // The rest of the line cannot match
+#define REGEXDFA_NEWLINE 3            // The line ending at the '\n' just read
+                                      // matched at its EOL
+
+typedef struct {
+    int32_t *trans;                   // Row offset + symbol -> row offset
+    uint8_t *stop;                    // Per state (row / symbol_count): 0 or
+                                      // a REGEXDFA_* stop kind
+    int32_t stop_row;                 // Rows from here on are stop states
+    uint32_t state_count;
+    uint32_t symbol_count;            // Byte classes, then BOL and EOL
+    uint16_t byte_class[256];
+    int32_t start;                    // Row at the beginning of a line
+    int32_t idle_row;                 // Live row most bytes loop on, or -1
+    uint8_t idle_skip[256];           // Bytes that leave idle_row in place
+    char literal[REGEXDFA_LITERAL_MAX];
+    size_t literal_len;               // 0 if no string is required
+    int literal_only;                 // The pattern is exactly literal
+} RegexDfa;
+
+// Compile pattern; flags are REGEXDFA_*. Returns 0, or -1 with *error set
+// to a static description.
+int regexdfa_compile(RegexDfa *re, const char *pattern, int flags, const char **error);
+
+// Nonzero if some part of the line matches. The line excludes its newline;
+// ^ and $ match at its ends.
+int regexdfa_match_line(const RegexDfa *re, const char *line, size_t len);
+
+// Scan a buffer of whole lines starting at data for the first line that
+// matches, as one pass of the DFA with newlines in the table. Returns the
+// start of that line, or NULL.
+const char *regexdfa_find_line(const RegexDfa *re, const char *data, const char *end);
+
+void regexdfa_free(RegexDfa *re);
+
+#endif
@@ -0,0 +1,49 @@
+/**
+ * String Pool Header - Interned command strings
+ * Each distinct string is stored once and referred to by a 32-bit id
+ */
+
+#ifndef STRPOOL_H
+#define STRPOOL_H
+
+#include <stdint.h>
+#include "arena.h"
+
+typedef uint32_t StrId;
+
+#define STR_NONE 0  // Id 0 is reserved for "no string"
+
+// A pool owned by one structure, so its strings go when that structure does.
+// A zero-filled pool is empty and is set up by its first intern.
+typedef struct {
+    Arena arena;                // String bytes
+    struct PoolEntry *entries;  // Indexed by id, entries[0] unused
+    uint32_t entry_count;
+    uint32_t entry_capacity;
+    StrId *slots;               // Hash table of ids, STR_NONE = empty
+    uint32_t slot_count;
+} StrPool;
+
+// Per-pool versions of the calls below
+void strpool_init_in(StrPool *pool);
+StrId strpool_intern_in(StrPool *pool, const char *s);
+const char *strpool_get_in(const StrPool *pool, StrId id);
+uint32_t strpool_count_in(const StrPool *pool);
+void strpool_free_in(StrPool *pool);  // One arena free; the pool can be reused
+
+// Initialize the global string pool
+void strpool_init(void);
+
+// Intern a string, returning its id (STR_NONE for NULL)
+StrId strpool_intern(const char *s);
+
+// Look up an id; returns NULL for STR_NONE or unknown ids
+const char *strpool_get(StrId id);
+
+// Number of distinct strings currently interned
+uint32_t strpool_count(void);
+
+// Release all interned strings at once
+void strpool_free(void);
+
+#endif
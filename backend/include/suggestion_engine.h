@@ -28,8 +28,19 @@ void suggestion_get_commands(const char *prefix, SuggestionList *out);
 // Get suggestions based on command context (e.g., after "cd" suggest directories)
 void suggestion_get_contextual(const char *cmd, const char *partial_arg, SuggestionList *out);
 
-// Get file/directory suggestions for path completion
-void suggestion_get_paths(const char *partial_path, int dirs_only, SuggestionList *out);
+// What a path argument should name: PATH_DIRS lists directories only,
+// PATH_FILES ranks files above directories
+typedef enum {
+    PATH_ANY = 0,
+    PATH_DIRS = 1,
+    PATH_FILES = 2
+} PathKind;
+
+// Get file/directory suggestions for path completion, best first. Every
+// entry is scored: exact prefix, prefix ignoring case, substring,
+// subsequence, then a typo in the prefix; paths used by recent commands
+// rank higher.
+void suggestion_get_paths(const char *partial_path, int kind, SuggestionList *out);
 
 // Add command to history for better suggestions
 void suggestion_add_to_history(const char *cmd);
@@ -37,6 +48,9 @@ void suggestion_add_to_history(const char *cmd);
 // Get suggestions from command history
 void suggestion_get_from_history(const char *prefix, SuggestionList *out);
 
+// Predict the next command from recent history (zero-prefix suggestions)
+void suggestion_get_predictions(SuggestionList *out);
+
 // Get command info
 CommandInfo* suggestion_get_command_info(const char *cmd);
 
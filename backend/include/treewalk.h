@@ -0,0 +1,66 @@
+/**
+ * Tree Walk Header - Parallel directory trees with totals
+ * A pool of threads reads a tree into memory, each worker taking
+ * directories from its own deque and stealing from the others when it
+ * runs dry. Every directory's children are sorted as soon as it is read,
+ * and its size and counts are added up from its children the moment the
+ * last of its subdirectories finishes. The caller can print the tree in
+ * order while the walk is still running: it waits on each directory only
+ * until that directory is listed, or done if it needs the totals.
+ */
+
+#ifndef TREEWALK_H
+#define TREEWALK_H
+
+#include <stdint.h>
+#include <limits.h>
+
+#define TREEWALK_MAX_THREADS 16
+#define TREEWALK_MAX_DEPTH (PATH_MAX / 2)  // Deeper directories don't fit in a
+                                           // path and are marked unreadable
+
+// How far a directory has got
+#define TREE_QUEUED 0
+#define TREE_LISTED 1            // children are filled in and sorted
+#define TREE_DONE 2              // size, files and dirs cover everything below
+
+typedef struct TreeNode TreeNode;
+
+struct TreeNode {
+    const char *name;            // The path given, for the root
+    TreeNode *parent;
+    TreeNode *children;          // Directories first, then by name, ignoring case
+    uint32_t child_count;
+    uint32_t pending;            // Subdirectories not yet done (walker only)
+    uint16_t depth;              // 0 for the root, 1 for its entries
+    unsigned char type;          // DT_DIR, DT_REG, DT_LNK, ...
+    unsigned char error;         // The directory could not be read
+    unsigned char state;         // TREE_*; directories only
+    uint64_t size;               // A file's size; a directory's total, once done
+    uint64_t files;              // Files and directories below, once done
+    uint64_t dirs;
+};
+
+typedef struct {
+    int max_depth;               // Read directories down to this depth; -1
+                                 // for all. Deeper ones are left empty.
+    int sizes;                   // lstat every entry for sizes
+} TreeWalkOptions;
+
+typedef struct TreeWalk TreeWalk;
+
+// Start walking the directory at path in the background. Hidden entries
+// are skipped and symlinks are not followed. Returns NULL with errno set
+// if path is not a readable directory.
+TreeWalk *treewalk_start(const char *path, const TreeWalkOptions *options);
+
+// The root is a directory node named after the path
+TreeNode *treewalk_root(TreeWalk *walk);
+
+// Block until dir reaches state (TREE_LISTED or TREE_DONE)
+void treewalk_wait(TreeWalk *walk, TreeNode *dir, int state);
+
+// Wait for the walk to end and free every node
+void treewalk_finish(TreeWalk *walk);
+
+#endif
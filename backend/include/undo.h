@@ -1,27 +1,34 @@
 #ifndef UNDO_H
 #define UNDO_H
 
+#include "arena.h"
+#include "strpool.h"
+
 typedef enum {
     UNDO_MKDIR,
     UNDO_RMDIR,
     UNDO_TOUCH,
     UNDO_RM,
     UNDO_CP,
+    UNDO_CP_DIR,       // cp -r: target is the copied tree
     UNDO_MV,
     UNDO_UNKNOWN
 } UndoType;
 
 typedef struct UndoNode {
-    char *command;
+    StrId command;
     UndoType type;
-    char *target;      // File/dir that was affected
-    char *backup_path; // For files that were deleted/modified
+    StrId target;      // File/dir that was affected
+    StrId backup_path; // For files that were deleted/modified
     struct UndoNode *next;
 } UndoNode;
 
 typedef struct {
     UndoNode *top;
     int count;
+    Arena nodes;          // Backing storage for UndoNode records
+    UndoNode *free_nodes; // Recycled nodes from popped/trimmed entries
+    StrPool strings;      // Commands and paths of the entries, interned
 } UndoStack;
 
 UndoStack *init_undo_stack();
@@ -0,0 +1,213 @@
+/**
+ * Aho-Corasick Implementation
+ * Build: insert patterns into a pointer trie, flatten it breadth-first so
+ * each state's edges are contiguous and sorted, then compute failure and
+ * dictionary-suffix links in BFS order.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "aho_corasick.h"
+
+// ============ Build-time Trie ============
+
+typedef struct BuildNode {
+    uint32_t ch;
+    int32_t output;
+    struct BuildNode *child;    // First child (kept sorted by ch)
+    struct BuildNode *sibling;
+    uint32_t index;             // State number after flattening
+} BuildNode;
+
+static BuildNode *build_node(uint32_t ch) {
+    BuildNode *n = calloc(1, sizeof(BuildNode));
+    if (n) {
+        n->ch = ch;
+        n->output = AC_NO_OUTPUT;
+    }
+    return n;
+}
+
+// Find or create the child for ch, counting newly created nodes
+static BuildNode *build_child(BuildNode *parent, uint32_t ch, uint32_t *node_count) {
+    BuildNode **link = &parent->child;
+    while (*link && (*link)->ch < ch) link = &(*link)->sibling;
+    if (*link && (*link)->ch == ch) return *link;
+
+    BuildNode *n = build_node(ch);
+    if (!n) return NULL;
+    n->sibling = *link;
+    *link = n;
+    (*node_count)++;
+    return n;
+}
+
+static void build_free(BuildNode *n) {
+    while (n) {
+        BuildNode *next = n->sibling;
+        build_free(n->child);
+        free(n);
+        n = next;
+    }
+}
+
+// ============ Transitions ============
+
+// Binary search the sorted edge list of a state
+static int ac_goto(const AcAutomaton *ac, uint32_t state, uint32_t ch, uint32_t *target) {
+    const AcState *s = &ac->states[state];
+    uint32_t lo = s->first_edge, hi = s->first_edge + s->edge_count;
+    while (lo < hi) {
+        uint32_t mid = (lo + hi) / 2;
+        if (ac->edges[mid].ch == ch) {
+            *target = ac->edges[mid].target;
+            return 1;
+        }
+        if (ac->edges[mid].ch < ch) lo = mid + 1;
+        else hi = mid;
+    }
+    return 0;
+}
+
+// ============ Public API ============
+
+int ac_build_seq(AcAutomaton *ac, const uint32_t *const *seqs, const uint32_t *lens, int count) {
+    memset(ac, 0, sizeof(*ac));
+
+    BuildNode *root = build_node(0);
+    if (!root) return 0;
+
+    uint32_t node_count = 1;
+    for (int p = 0; p < count; p++) {
+        BuildNode *cur = root;
+        for (uint32_t i = 0; i < lens[p] && cur; i++) {
+            cur = build_child(cur, seqs[p][i], &node_count);
+        }
+        if (!cur) {
+            build_free(root);
+            return 0;
+        }
+        if (cur != root && cur->output == AC_NO_OUTPUT) cur->output = p;
+    }
+
+    ac->states = calloc(node_count, sizeof(AcState));
+    ac->edges = malloc(sizeof(AcEdge) * (node_count > 1 ? node_count - 1 : 1));
+    BuildNode **queue = malloc(sizeof(BuildNode *) * node_count);
+    if (!ac->states || !ac->edges || !queue) {
+        free(queue);
+        build_free(root);
+        ac_free(ac);
+        return 0;
+    }
+
+    // Flatten breadth-first: children of a node get consecutive indices
+    uint32_t head = 0, tail = 0;
+    root->index = 0;
+    queue[tail++] = root;
+    while (head < tail) {
+        BuildNode *n = queue[head++];
+        AcState *s = &ac->states[n->index];
+        s->output = n->output;
+        s->first_edge = ac->edge_count;
+        for (BuildNode *k = n->child; k; k = k->sibling) {
+            k->index = tail;
+            queue[tail++] = k;
+            ac->edges[ac->edge_count].ch = k->ch;
+            ac->edges[ac->edge_count].target = k->index;
+            ac->edge_count++;
+            s->edge_count++;
+        }
+    }
+    ac->state_count = tail;
+    free(queue);
+    build_free(root);
+
+    // Failure links in BFS order (state numbering is already BFS order)
+    for (uint32_t s = 0; s < ac->state_count; s++) {
+        AcState *st = &ac->states[s];
+        for (uint32_t e = st->first_edge; e < st->first_edge + st->edge_count; e++) {
+            uint32_t t = ac->edges[e].target;
+            uint32_t ch = ac->edges[e].ch;
+            uint32_t fail = 0;
+            if (s != 0) {
+                uint32_t f = st->fail;
+                while (1) {
+                    uint32_t next;
+                    if (ac_goto(ac, f, ch, &next)) { fail = next; break; }
+                    if (f == 0) break;
+                    f = ac->states[f].fail;
+                }
+            }
+            ac->states[t].fail = fail;
+            ac->states[t].dict_link = ac->states[fail].output != AC_NO_OUTPUT
+                ? fail : ac->states[fail].dict_link;
+        }
+    }
+    return 1;
+}
+
+int ac_build(AcAutomaton *ac, const char *const *patterns, int count) {
+    // Widen each string to one symbol per byte
+    uint32_t **seqs = malloc(sizeof(uint32_t *) * (count ? count : 1));
+    uint32_t *lens = malloc(sizeof(uint32_t) * (count ? count : 1));
+    int ok = seqs && lens;
+    int built = 0;
+    for (; ok && built < count; built++) {
+        lens[built] = strlen(patterns[built]);
+        seqs[built] = malloc(sizeof(uint32_t) * (lens[built] ? lens[built] : 1));
+        if (!seqs[built]) { ok = 0; break; }
+        for (uint32_t i = 0; i < lens[built]; i++) {
+            seqs[built][i] = (unsigned char)patterns[built][i];
+        }
+    }
+
+    if (ok) ok = ac_build_seq(ac, (const uint32_t *const *)seqs, lens, count);
+
+    for (int i = 0; i < built; i++) free(seqs[i]);
+    free(seqs);
+    free(lens);
+    return ok;
+}
+
+// Advance one symbol, following failure links on mismatch
+static uint32_t ac_step(const AcAutomaton *ac, uint32_t state, uint32_t ch) {
+    uint32_t next;
+    while (!ac_goto(ac, state, ch, &next)) {
+        if (state == 0) return 0;
+        state = ac->states[state].fail;
+    }
+    return next;
+}
+
+// Report the state's own pattern, then every suffix pattern
+static void ac_report(const AcAutomaton *ac, uint32_t state, size_t end, AcMatchFn fn, void *ctx) {
+    for (uint32_t s = state; s != 0; s = ac->states[s].dict_link) {
+        if (ac->states[s].output != AC_NO_OUTPUT) fn(ac->states[s].output, end, ctx);
+    }
+}
+
+void ac_scan(const AcAutomaton *ac, const char *text, size_t len, AcMatchFn fn, void *ctx) {
+    if (!ac->states) return;
+
+    uint32_t state = 0;
+    for (size_t i = 0; i < len; i++) {
+        state = ac_step(ac, state, (unsigned char)text[i]);
+        ac_report(ac, state, i + 1, fn, ctx);
+    }
+}
+
+void ac_scan_seq(const AcAutomaton *ac, const uint32_t *syms, size_t len, AcMatchFn fn, void *ctx) {
+    if (!ac->states) return;
+
+    uint32_t state = 0;
+    for (size_t i = 0; i < len; i++) {
+        state = ac_step(ac, state, syms[i]);
+        ac_report(ac, state, i + 1, fn, ctx);
+    }
+}
+
+void ac_free(AcAutomaton *ac) {
+    free(ac->states);
+    free(ac->edges);
+    memset(ac, 0, sizeof(*ac));
+}
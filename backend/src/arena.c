@@ -0,0 +1,44 @@
+/**
+ * Arena Allocator Implementation
+ * Blocks are chained newest-first; allocation bumps within the head block
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include "arena.h"
+
+#define ARENA_ALIGN (sizeof(void *) > sizeof(double) ? sizeof(void *) : sizeof(double))
+
+void arena_init(Arena *arena) {
+    arena->head = NULL;
+}
+
+void *arena_alloc(Arena *arena, size_t size) {
+    size = (size + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+
+    ArenaBlock *block = arena->head;
+    if (!block || block->size - block->used < size) {
+        // Oversized requests get a dedicated block
+        size_t block_size = size > ARENA_BLOCK_SIZE ? size : ARENA_BLOCK_SIZE;
+        block = malloc(sizeof(ArenaBlock) + block_size);
+        if (!block) return NULL;
+        block->used = 0;
+        block->size = block_size;
+        block->next = arena->head;
+        arena->head = block;
+    }
+
+    void *ptr = block->data + block->used;
+    block->used += size;
+    return ptr;
+}
+
+void arena_free(Arena *arena) {
+    ArenaBlock *block = arena->head;
+    while (block) {
+        ArenaBlock *next = block->next;
+        free(block);
+        block = next;
+    }
+    arena->head = NULL;
+}
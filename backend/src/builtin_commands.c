@@ -0,0 +1,16 @@
+/**
+ * Builtin Commands - The command names used for completion and correction
+ */
+
+#include "builtin_commands.h"
+
+const char *const builtin_commands[] = {
+    "ls", "pwd", "cd", "mkdir", "rmdir", "touch", "rm", "cat", "cp", "mv",
+    "echo", "tree", "search", "backup", "compare", "stats", "sysmon",
+    "bookmark", "recent", "bulk_rename", "help", "history", "exit", "clear",
+    "fileinfo", "hexdump", "duplicate", "encrypt", "decrypt", "sizeof", "dirtree",
+    "age", "ff", "freq", "lines", "quicknote", "calc", "head", "tail", "wc",
+    "grep", "sort", "uniq", "rev", "date", "whoami", "hostname", "uptime",
+    "df", "ps", "kill", "undo", "macro", "teach"
+};
+const int num_builtin_commands = sizeof(builtin_commands) / sizeof(builtin_commands[0]);
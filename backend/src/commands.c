@@ -9,10 +9,19 @@
 #include <errno.h>
 #include <time.h>
 #include <sys/statvfs.h>
+#include <sys/sendfile.h>
+#include <limits.h>
 
 #include "commands.h"
+#include "diriter.h"
+#include "dirlist.h"
+#include "filewalk.h"
+#include "filecopy.h"
+#include "treewalk.h"
 
 #define BUFFER_SIZE 4096
+#define COPY_BUFFER_SIZE (1 << 17)   // Read/write fallback when the kernel can't copy
+#define COPY_CHUNK (1 << 30)         // Largest single sendfile/splice request
 #define BOOKMARK_FILE ".shell_bookmarks"
 #define MAX_BOOKMARKS 50
 
@@ -30,35 +39,33 @@ void do_pwd(char **args) {
     }
 }
 
-// Implementation of 'ls' using opendir/readdir system calls
+// Implementation of 'ls': one bulk read, sorted by name, and an fstatat
+// per entry for its size (a symlink's target's, like stat)
 void do_ls(char **args) {
     char *path = ".";
     if (args[1] != NULL) {
         path = args[1];
     }
 
-    DIR *d;
-    struct dirent *dir;
-    struct stat file_stat;
-    char full_path[1024];
-
-    d = opendir(path);
-    if (d) {
+    DirList list;
+    dirlist_init(&list);
+    if (dirlist_read(&list, path) == 0) {
+        dirlist_sort(&list, dirlist_by_name);
         printf("Name\t\tSize\n");
         printf("----\t\t----\n");
-        while ((dir = readdir(d)) != NULL) {
-            snprintf(full_path, sizeof(full_path), "%s/%s", path, dir->d_name);
-            
-            if (stat(full_path, &file_stat) == 0) {
-                printf("%-15s\t%ld bytes\n", dir->d_name, file_stat.st_size);
+        for (size_t i = 0; i < list.count; i++) {
+            const DirListEntry *e = &list.entries[i];
+            struct stat file_stat;
+            if (fstatat(list.fd, e->name, &file_stat, 0) == 0) {
+                printf("%-15s\t%ld bytes\n", e->name, file_stat.st_size);
             } else {
-                printf("%s\n", dir->d_name);
+                printf("%s\n", e->name);
             }
         }
-        closedir(d);
     } else {
         perror("ls");
     }
+    dirlist_free(&list);
 }
 
 // Implementation of 'mkdir' using mkdir system call
@@ -115,27 +122,96 @@ void do_touch(char **args) {
     }
 }
 
-// Implementation of 'cat' using open/read/write system calls
+// ============ Stream Copy ============
+
+// write() until all of buf is out, across partial writes and signals
+static int write_all(int fd, const char *buf, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, buf, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        buf += n;
+        len -= n;
+    }
+    return 0;
+}
+
+// Copy in to out without the data passing through user space: sendfile
+// from a regular file, splice when either end is a pipe. Returns 0 at EOF,
+// -1 with errno set on error, or 1 if the kernel can't do it for this pair
+// (a terminal, an O_APPEND file, /proc). Both calls move the file offset,
+// so a fallback carries on from wherever this stopped.
+static int copy_in_kernel(int in, int out, mode_t in_mode, mode_t out_mode) {
+    int use_splice = !S_ISREG(in_mode);
+    if (use_splice && !S_ISFIFO(in_mode) && !S_ISFIFO(out_mode)) return 1;
+    for (;;) {
+        ssize_t n = use_splice ? splice(in, NULL, out, NULL, COPY_CHUNK, SPLICE_F_MOVE | SPLICE_F_MORE)
+                               : sendfile(out, in, NULL, COPY_CHUNK);
+        if (n > 0) continue;
+        if (n == 0) return 0;
+        if (errno == EINTR) continue;
+        if (errno == EINVAL || errno == ENOSYS) return 1;
+        return -1;
+    }
+}
+
+// The fallback: large reads into one buffer, allocated on first use
+static int copy_buffered(int in, int out, char **buffer) {
+    if (!*buffer && !(*buffer = malloc(COPY_BUFFER_SIZE))) return -1;
+    for (;;) {
+        ssize_t n = read(in, *buffer, COPY_BUFFER_SIZE);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        if (n == 0) return 0;
+        if (write_all(out, *buffer, n) < 0) return -1;
+    }
+}
+
+// Implementation of 'cat': each file goes to stdout in the kernel when it
+// can, and through a 128 KB buffer when it can't
 void do_cat(char **args) {
     if (args[1] == NULL) {
         fprintf(stderr, "cat: missing operand\n");
         return;
     }
-    
-    int fd = open(args[1], O_RDONLY);
-    if (fd < 0) {
-        perror("cat");
-        return;
-    }
-    
-    char buffer[BUFFER_SIZE];
-    ssize_t bytes_read;
-    
-    while ((bytes_read = read(fd, buffer, sizeof(buffer))) > 0) {
-        write(STDOUT_FILENO, buffer, bytes_read);
+    fflush(stdout);
+
+    struct stat out_st;
+    if (fstat(STDOUT_FILENO, &out_st) < 0) memset(&out_st, 0, sizeof(out_st));
+    char *buffer = NULL;
+    for (int i = 1; args[i] != NULL; i++) {
+        int fd = open(args[i], O_RDONLY);
+        if (fd < 0) {
+            fprintf(stderr, "cat: %s: %s\n", args[i], strerror(errno));
+            continue;
+        }
+        struct stat st;
+        int rc = fstat(fd, &st);
+        if (rc == 0 && S_ISDIR(st.st_mode)) {
+            fprintf(stderr, "cat: %s: Is a directory\n", args[i]);
+        } else if (rc == 0 && S_ISREG(st.st_mode) && S_ISREG(out_st.st_mode) &&
+                   st.st_dev == out_st.st_dev && st.st_ino == out_st.st_ino) {
+            // Appending a file to itself would never reach EOF
+            fprintf(stderr, "cat: %s: input file is output file\n", args[i]);
+        } else {
+            rc = rc == 0 ? copy_in_kernel(fd, STDOUT_FILENO, st.st_mode, out_st.st_mode) : 1;
+            if (rc == 1) rc = copy_buffered(fd, STDOUT_FILENO, &buffer);
+            if (rc < 0) {
+                int err = errno;
+                fprintf(stderr, "cat: %s: %s\n", args[i], strerror(err));
+                if (err == EPIPE) {
+                    close(fd);
+                    break;
+                }
+            }
+        }
+        close(fd);
     }
-    
-    close(fd);
+    free(buffer);
 }
 
 void do_echo(char **args) {
@@ -148,40 +224,152 @@ void do_echo(char **args) {
     write(STDOUT_FILENO, "\n", 1);
 }
 
-// Implementation of 'cp' using open/read/write system calls
-void do_cp(char **args) {
-    if (args[1] == NULL || args[2] == NULL) {
-        fprintf(stderr, "cp: missing source or destination\n");
-        return;
-    }
+// The last component of path, ignoring trailing slashes
+static const char *base_name(const char *path, char *buf, size_t size) {
+    snprintf(buf, size, "%s", path);
+    size_t len = strlen(buf);
+    while (len > 1 && buf[len - 1] == '/') buf[--len] = '\0';
+    char *slash = strrchr(buf, '/');
+    return slash && slash[1] ? slash + 1 : buf;
+}
 
-    int src_fd = open(args[1], O_RDONLY);
-    if (src_fd < 0) {
-        perror("cp: source");
-        return;
-    }
+// Whether target is the directory src or lies below it, where a tree copy
+// would overwrite its own source or never end
+static int inside_tree(const char *src, const char *target) {
+    char real_src[PATH_MAX], real[PATH_MAX], parent[PATH_MAX];
+    if (!realpath(src, real_src)) return 0;
+    if (realpath(target, real) && strcmp(real, real_src) == 0) return 1;
+    snprintf(parent, sizeof(parent), "%s", target);
+    size_t len = strlen(parent);
+    while (len > 1 && parent[len - 1] == '/') parent[--len] = '\0';
+    char *slash = strrchr(parent, '/');
+    if (!slash) snprintf(parent, sizeof(parent), ".");
+    else if (slash == parent) parent[1] = '\0';
+    else *slash = '\0';
+    if (!realpath(parent, real)) return 0;
+    size_t n = strlen(real_src);
+    return strncmp(real, real_src, n) == 0 && (real[n] == '\0' || real[n] == '/' || n == 1);
+}
 
-    int dest_fd = open(args[2], O_WRONLY | O_CREAT | O_TRUNC, 0644);
-    if (dest_fd < 0) {
-        perror("cp: destination");
-        close(src_fd);
-        return;
-    }
+// Where cp puts src: dst itself, or dst/<name of src> when dst is a
+// directory. Returns the snprintf length.
+static int cp_path(const char *src, const char *dst, int into_dir, char *target, size_t size) {
+    char base[PATH_MAX];
+    if (!into_dir) return snprintf(target, size, "%s", dst);
+    return snprintf(target, size, "%s%s%s", dst, dst[strlen(dst) - 1] == '/' ? "" : "/",
+                    base_name(src, base, sizeof(base)));
+}
 
-    char buffer[BUFFER_SIZE];
-    ssize_t bytes_read;
-    
-    while ((bytes_read = read(src_fd, buffer, sizeof(buffer))) > 0) {
-        if (write(dest_fd, buffer, bytes_read) != bytes_read) {
-            perror("cp: write error");
-            break;
+// The path "cp [-r] <source> <destination>" copies to, so the caller can
+// check beforehand whether it exists. Returns 0, or -1 for other forms.
+int cp_target(char **args, char *target, size_t size) {
+    char *operands[2];
+    int count = 0;
+    for (int i = 1; args[i] != NULL; i++) {
+        if (args[i][0] == '-' && args[i][1]) continue;
+        if (count == 2) return -1;
+        operands[count++] = args[i];
+    }
+    if (count != 2) return -1;
+    struct stat st;
+    int into_dir = stat(operands[1], &st) == 0 && S_ISDIR(st.st_mode);
+    int len = cp_path(operands[0], operands[1], into_dir, target, size);
+    return len < 0 || (size_t)len >= size ? -1 : 0;
+}
+
+// Implementation of 'cp': files are cloned or copied in the kernel, holes
+// and permission bits are kept, and -r copies trees on a pool of threads
+// (see filecopy.h). With several sources the target must be a directory.
+// Returns 0 if every source was copied, -1 otherwise.
+int do_cp(char **args) {
+    int recurse = 0, count = 0;
+    char *operands[64];
+    for (int i = 1; args[i] != NULL; i++) {
+        if (strcmp(args[i], "-r") == 0 || strcmp(args[i], "-R") == 0 || strcmp(args[i], "--recursive") == 0) {
+            recurse = 1;
+        } else if (args[i][0] == '-' && args[i][1]) {
+            fprintf(stderr, "cp: unknown option '%s'\n", args[i]);
+            return -1;
+        } else if (count < 64) {
+            operands[count++] = args[i];
         }
     }
+    if (count < 2) {
+        fprintf(stderr, "Usage: cp [-r] <source>... <destination>\n");
+        return -1;
+    }
+
+    const char *dst = operands[count - 1];
+    struct stat dst_st;
+    int into_dir = stat(dst, &dst_st) == 0 && S_ISDIR(dst_st.st_mode);
+    if (count > 2 && !into_dir) {
+        fprintf(stderr, "cp: target '%s' is not a directory\n", dst);
+        return -1;
+    }
+
+    FileCopyStats stats;
+    memset(&stats, 0, sizeof(stats));
+    int copied = 0;
+    for (int i = 0; i < count - 1; i++) {
+        const char *src = operands[i];
+        char target[PATH_MAX];
+        int len = cp_path(src, dst, into_dir, target, sizeof(target));
+        // A truncated target would copy to some other path
+        if (len < 0 || (size_t)len >= sizeof(target)) {
+            fprintf(stderr, "cp: %s: %s\n", src, strerror(ENAMETOOLONG));
+            stats.errors++;
+            continue;
+        }
 
-    printf("Copied '%s' to '%s'.\n", args[1], args[2]);
-
-    close(src_fd);
-    close(dest_fd);
+        struct stat st, target_st;
+        if (stat(src, &st) != 0) {
+            fprintf(stderr, "cp: %s: %s\n", src, strerror(errno));
+            stats.errors++;
+            continue;
+        }
+        if (S_ISDIR(st.st_mode)) {
+            if (!recurse) {
+                fprintf(stderr, "cp: -r not specified; omitting directory '%s'\n", src);
+                stats.errors++;
+                continue;
+            }
+            if (inside_tree(src, target)) {
+                fprintf(stderr, "cp: cannot copy '%s' into itself\n", src);
+                stats.errors++;
+                continue;
+            }
+            filecopy_tree("cp", src, target, &stats);
+        } else {
+            if (stat(target, &target_st) == 0 && target_st.st_dev == st.st_dev && target_st.st_ino == st.st_ino) {
+                fprintf(stderr, "cp: '%s' and '%s' are the same file\n", src, target);
+                stats.errors++;
+                continue;
+            }
+            int rc = filecopy_file(src, target, &stats);
+            if (rc < 0) {
+                fprintf(stderr, "cp: %s: %s\n", rc == -1 ? src : target, strerror(errno));
+                stats.errors++;
+                continue;
+            }
+        }
+        copied++;
+    }
+    if (!copied) return -1;
+
+    double mb = stats.bytes / (1024.0 * 1024.0);
+    if (count == 2) printf("Copied '%s' to '%s' (", operands[0], dst);
+    else printf("Copied %d item%s to '%s' (", copied, copied == 1 ? "" : "s", dst);
+    if (stats.dirs) {
+        printf("%llu file%s, %llu director%s, ", (unsigned long long)stats.files, stats.files == 1 ? "" : "s",
+               (unsigned long long)stats.dirs, stats.dirs == 1 ? "y" : "ies");
+    }
+    printf("%.1f MB in %.0f ms", mb, stats.elapsed_ms);
+    if (stats.elapsed_ms >= 1) printf(", %.1f MB/s", mb * 1000.0 / stats.elapsed_ms);
+    if (stats.cloned) printf(", %llu reflinked", (unsigned long long)stats.cloned);
+    if (stats.threads > 1) printf(", %d threads", stats.threads);
+    if (stats.errors) printf(", %llu error%s", (unsigned long long)stats.errors, stats.errors == 1 ? "" : "s");
+    printf(").\n");
+    return stats.errors ? -1 : 0;
 }
 
 // Implementation of 'mv' using rename system call
@@ -200,87 +388,46 @@ void do_mv(char **args) {
 
 // ============ CUSTOM COMMANDS ============
 
-// Structure to hold directory entries for sorting
-typedef struct {
-    char name[256];
-    int is_dir;
-} TreeEntry;
+#define TREE_FLUSH_SIZE 65536
 
-// Compare function for sorting entries (directories first, then alphabetically)
-static int compare_entries(const void *a, const void *b) {
-    const TreeEntry *ea = (const TreeEntry *)a;
-    const TreeEntry *eb = (const TreeEntry *)b;
-    
-    // Directories come first
-    if (ea->is_dir && !eb->is_dir) return -1;
-    if (!ea->is_dir && eb->is_dir) return 1;
-    
-    return strcasecmp(ea->name, eb->name);
+// Write out buffered lines once there are enough of them
+static void tree_flush(FileWalkOutput *out, size_t threshold) {
+    if (out->len < threshold) return;
+    fwrite(out->data, 1, out->len, stdout);
+    out->len = 0;
 }
 
-// Helper function for tree - clean tree visualization
-static int print_tree_recursive(const char *path, const char *prefix, int *file_count, int *dir_count, int max_depth, int current_depth) {
-    if (current_depth > max_depth) return 0;
-    
-    DIR *d = opendir(path);
-    if (!d) return 0;
-    
-    struct dirent *dir;
-    struct stat file_stat;
-    char full_path[1024];
-    
-    // Collect and sort entries
-    TreeEntry entries[500];
-    int count = 0;
-    
-    while ((dir = readdir(d)) != NULL && count < 500) {
-        if (strcmp(dir->d_name, ".") == 0 || strcmp(dir->d_name, "..") == 0)
-            continue;
-        if (dir->d_name[0] == '.') continue;  // Skip hidden files
-        
-        snprintf(full_path, sizeof(full_path), "%s/%s", path, dir->d_name);
-        strncpy(entries[count].name, dir->d_name, 255);
-        entries[count].name[255] = '\0';
-        
-        if (stat(full_path, &file_stat) == 0) {
-            entries[count].is_dir = S_ISDIR(file_stat.st_mode);
-        } else {
-            entries[count].is_dir = 0;
-        }
-        count++;
-    }
-    closedir(d);
-    
-    // Sort entries
-    qsort(entries, count, sizeof(TreeEntry), compare_entries);
-    
-    // Print entries with tree structure
-    for (int i = 0; i < count; i++) {
-        int is_last = (i == count - 1);
-        
-        snprintf(full_path, sizeof(full_path), "%s/%s", path, entries[i].name);
-        
+// Helper function for tree - clean tree visualization. Prints each
+// directory's entries as soon as the walk has listed it, so output starts
+// while deeper levels are still being read. prefix has room for four
+// bytes per level.
+static void print_tree_recursive(TreeWalk *walk, TreeNode *dir, char *prefix, size_t prefix_len,
+                                 FileWalkOutput *out, int *file_count, int *dir_count) {
+    treewalk_wait(walk, dir, TREE_LISTED);
+    for (uint32_t i = 0; i < dir->child_count; i++) {
+        TreeNode *e = &dir->children[i];
+        int is_last = (i == dir->child_count - 1);
+
         // Print the branch
-        printf("%s%s", prefix, is_last ? "+-- " : "|-- ");
-        
-        if (entries[i].is_dir) {
+        filewalk_printf(out, "%s%s%s%s\n", prefix, is_last ? "+-- " : "|-- ", e->name,
+                        e->type == DT_DIR ? "/" : "");
+        tree_flush(out, TREE_FLUSH_SIZE);
+
+        if (e->type == DT_DIR) {
             (*dir_count)++;
-            printf("%s/\n", entries[i].name);
-            
             // Recurse with updated prefix
-            char new_prefix[512];
-            snprintf(new_prefix, sizeof(new_prefix), "%s%s", prefix, 
-                    is_last ? "    " : "|   ");
-            print_tree_recursive(full_path, new_prefix, file_count, dir_count, max_depth, current_depth + 1);
+            memcpy(prefix + prefix_len, is_last ? "    " : "|   ", 5);
+            print_tree_recursive(walk, e, prefix, prefix_len + 4, out, file_count, dir_count);
+            prefix[prefix_len] = '\0';
         } else {
             (*file_count)++;
-            printf("%s\n", entries[i].name);
         }
     }
-    
-    return count;
 }
 
+// Implementation of 'tree': levels are read in parallel (see treewalk.h)
+// down to the depth limit, hidden entries are skipped, directories come
+// first and each level is sorted by name
 void do_tree(char **args) {
     char *path = ".";
     int max_depth = 4;
@@ -293,13 +440,70 @@ void do_tree(char **args) {
         }
     }
     
+    TreeWalkOptions options = {max_depth, 0};
+    TreeWalk *walk = treewalk_start(path, &options);
+    if (!walk) {
+        fprintf(stderr, "tree: %s: %s\n", path, strerror(errno));
+        return;
+    }
+
+    // Directories past the depth limit, or too deep for a path, are left
+    // empty, so the prefix needs at most one level more than that
+    size_t levels = max_depth < TREEWALK_MAX_DEPTH ? max_depth : TREEWALK_MAX_DEPTH;
+    char *prefix = calloc((levels + 1) * 4 + 1, 1);
+    if (!prefix) {
+        fprintf(stderr, "tree: out of memory\n");
+        treewalk_finish(walk);
+        return;
+    }
     int file_count = 0, dir_count = 0;
-    
+    FileWalkOutput out = {NULL, 0, 0};
     printf("\n%s\n", path);
-    print_tree_recursive(path, "", &file_count, &dir_count, max_depth, 0);
+    print_tree_recursive(walk, treewalk_root(walk), prefix, 0, &out, &file_count, &dir_count);
+    tree_flush(&out, 1);
+    free(out.data);
+    free(prefix);
+    treewalk_finish(walk);
     printf("\n%d directories, %d files\n\n", dir_count, file_count);
 }
 
+#define SEARCH_LINE_MAX 512   // Longer matching lines are cut
+
+// memmem finds each occurrence; the line around it is only then located,
+// and line numbers are counted up to it lazily
+static long search_file(const char *path, const char *data, size_t len, FileWalkOutput *out, void *ctx) {
+    const char *pattern = ctx;
+    size_t pattern_len = strlen(pattern);
+    const char *p = data, *end = data + len;
+    const char *counted = data;
+    long line_num = 1, found = 0;
+
+    const char *hit;
+    while (p < end && (hit = memmem(p, end - p, pattern, pattern_len)) != NULL) {
+        const char *line = memrchr(p, '\n', hit - p);
+        line = line ? line + 1 : p;
+        const char *line_end = memchr(hit + pattern_len, '\n', end - hit - pattern_len);
+        if (!line_end) line_end = end;
+        line_num += filewalk_count_lines(counted, line);
+        counted = line;
+
+        // A long line is shown as a window around the match
+        const char *from = line, *to = line_end;
+        if (to > from && to[-1] == '\r') to--;
+        if (to - from > SEARCH_LINE_MAX) {
+            if (hit - from > SEARCH_LINE_MAX / 2) from = hit - SEARCH_LINE_MAX / 2;
+            if (to - from > SEARCH_LINE_MAX) to = from + SEARCH_LINE_MAX;
+        }
+        filewalk_printf(out, "%s:%ld: %s%.*s%s\n", path, line_num, from > line ? "..." : "",
+                        (int)(to - from), from, to < line_end && *to != '\r' ? "..." : "");
+        found++;
+        p = line_end + 1;
+    }
+    return found;
+}
+
+// Implementation of 'search': a literal scan of every file below the given
+// paths (default: the working directory), binaries skipped
 void do_search(char **args) {
     if (args[1] == NULL) {
         fprintf(stderr, "search: missing pattern\n");
@@ -307,54 +511,21 @@ void do_search(char **args) {
     }
     
     char *pattern = args[1];
-    DIR *d = opendir(".");
-    if (!d) {
-        perror("search");
-        return;
-    }
-    
-    struct dirent *dir;
-    char buffer[BUFFER_SIZE];
-    int found = 0;
+    char *here[] = {".", NULL};
+    char **paths = args[2] ? args + 2 : here;
+    int count = 0;
+    while (paths[count]) count++;
     
     printf("Searching for '%s'...\n", pattern);
+    fflush(stdout);
     
-    while ((dir = readdir(d)) != NULL) {
-        if (dir->d_name[0] == '.') continue;
-        
-        int fd = open(dir->d_name, O_RDONLY);
-        if (fd < 0) continue;
-        
-        ssize_t bytes_read;
-        int line_num = 1;
-        int pos = 0;
-        
-        while ((bytes_read = read(fd, buffer + pos, 1)) > 0) {
-            if (buffer[pos] == '\n') {
-                buffer[pos] = '\0';
-                if (strstr(buffer, pattern) != NULL) {
-                    printf("%s:%d: %s\n", dir->d_name, line_num, buffer);
-                    found++;
-                }
-                line_num++;
-                pos = 0;
-            } else {
-                pos++;
-                if (pos >= BUFFER_SIZE - 1) {
-                    buffer[pos] = '\0';
-                    if (strstr(buffer, pattern) != NULL) {
-                        printf("%s:%d: %s...\n", dir->d_name, line_num, buffer);
-                        found++;
-                    }
-                    pos = 0;
-                }
-            }
-        }
-        close(fd);
-    }
-    closedir(d);
+    FileWalk walk = {"search", 1, search_file, pattern};
+    FileWalkStats stats;
+    long found = filewalk_run(&walk, paths, count, &stats);
     
-    printf("Found %d matches.\n", found);
+    printf("Found %ld match%s in %llu file%s (%.1f MB, %llu binary skipped, %.0f ms).\n",
+           found, found == 1 ? "" : "es", (unsigned long long)stats.files, stats.files == 1 ? "" : "s",
+           stats.bytes / 1048576.0, (unsigned long long)stats.binary, stats.elapsed_ms);
 }
 
 void do_backup(char **args) {
@@ -524,29 +695,29 @@ void do_bookmark(char **args) {
 
 void do_recent(char **args) {
     (void)args;  // Unused parameter
-    DIR *d = opendir(".");
-    if (!d) {
+    DirIter it;
+    if (diriter_open(&it, ".") != 0) {
         perror("recent");
         return;
     }
     
-    struct dirent *dir;
-    struct stat file_stat;
     time_t now = time(NULL);
     
     printf("=== Recently Modified Files (last 24 hours) ===\n");
     
-    while ((dir = readdir(d)) != NULL) {
-        if (dir->d_name[0] == '.') continue;
+    while (diriter_next(&it)) {
+        if (it.name[0] == '.') continue;
         
-        if (stat(dir->d_name, &file_stat) == 0) {
+        // A symlink counts by its target's mtime
+        struct stat file_stat;
+        if (fstatat(it.fd, it.name, &file_stat, 0) == 0) {
             double diff = difftime(now, file_stat.st_mtime);
             if (diff < 86400) { // 24 hours
-                printf("%s (%.0f seconds ago)\n", dir->d_name, diff);
+                printf("%s (%.0f seconds ago)\n", it.name, diff);
             }
         }
     }
-    closedir(d);
+    diriter_close(&it);
 }
 
 void do_bulk_rename(char **args) {
@@ -20,12 +20,18 @@
 #include <signal.h>
 #include <stdint.h>
 #include "custom_commands.h"
+#include "diriter.h"
+#include "dirlist.h"
+#include "pathindex.h"
+#include "filewalk.h"
+#include "regexdfa.h"
+#include "treewalk.h"
 
 #define BUFFER_SIZE 4096
 
-// Hash function
-static unsigned long file_hash(const char *filepath) {
-    int fd = open(filepath, O_RDONLY);
+// Hash function; filepath is relative to dirfd (AT_FDCWD for the cwd)
+static unsigned long file_hash(int dirfd, const char *filepath) {
+    int fd = openat(dirfd, filepath, O_RDONLY | O_CLOEXEC);
     if (fd < 0) return 0;
     unsigned long hash = 5381;
     char buf[4096];
@@ -59,7 +65,7 @@ void do_fileinfo(char **args) {
     printf("Mode: %o\n", st.st_mode & 0777);
     printf("Modified: %s", ctime(&st.st_mtime));
     printf("Inode: %lu\n", st.st_ino);
-    if (S_ISREG(st.st_mode)) printf("Hash: %lx\n", file_hash(args[1]));
+    if (S_ISREG(st.st_mode)) printf("Hash: %lx\n", file_hash(AT_FDCWD, args[1]));
     printf("\n");
 }
 
@@ -92,32 +98,35 @@ void do_hexdump(char **args) {
 // duplicate - find duplicate files
 void do_duplicate(char **args) {
     const char *dir = args[1] ? args[1] : ".";
-    DIR *d = opendir(dir);
-    if (!d) { perror("duplicate"); return; }
+    DirIter it;
+    if (diriter_open(&it, dir) != 0) { perror("duplicate"); return; }
     
+    // Names are kept bare and files opened relative to the directory;
+    // the "dir/" prefix is only added when a duplicate is printed
     struct { char name[256]; unsigned long hash; } files[500];
     int count = 0;
-    struct dirent *ent;
     
-    while ((ent = readdir(d)) && count < 500) {
-        if (ent->d_name[0] == '.') continue;
-        char path[512];
-        snprintf(path, sizeof(path), "%s/%s", dir, ent->d_name);
+    while (count < 500 && diriter_next(&it)) {
+        if (it.name[0] == '.') continue;
+        // A symlink to a regular file counts as that file
         struct stat st;
-        if (stat(path, &st) == 0 && S_ISREG(st.st_mode)) {
-            strncpy(files[count].name, path, 255);
-            files[count].hash = file_hash(path);
-            count++;
+        if (it.type != DT_REG && (it.type != DT_LNK || fstatat(it.fd, it.name, &st, 0) != 0 ||
+                                  !S_ISREG(st.st_mode))) {
+            continue;
         }
+        strncpy(files[count].name, it.name, 255);
+        files[count].name[255] = '\0';
+        files[count].hash = file_hash(it.fd, it.name);
+        count++;
     }
-    closedir(d);
+    diriter_close(&it);
     
     printf("Checking %d files for duplicates...\n", count);
     int found = 0;
     for (int i = 0; i < count; i++) {
         for (int j = i + 1; j < count; j++) {
             if (files[i].hash == files[j].hash && files[i].hash != 0) {
-                printf("DUPLICATE: %s <-> %s\n", files[i].name, files[j].name);
+                printf("DUPLICATE: %s/%s <-> %s/%s\n", dir, files[i].name, dir, files[j].name);
                 found++;
             }
         }
@@ -165,31 +174,164 @@ void do_decrypt(char **args) {
     printf("(XOR decryption same as encryption)\n");
 }
 
-// sizeof - total size of files matching pattern
+// sizeof - total size of files matching pattern; symlinks are resolved
+// when stat-ed and count only if they lead to a regular file
+static int sizeof_match(const DirListEntry *e, void *pattern) {
+    const char *p = pattern;
+    return (e->type == DT_REG || e->type == DT_LNK) && (p[0] == '*' || strstr(e->name, p + 1));
+}
+
 void do_sizeof(char **args) {
     const char *pattern = args[1] ? args[1] : "*";
-    DIR *d = opendir(".");
-    if (!d) return;
+    DirList list;
+    dirlist_init(&list);
+    if (dirlist_read(&list, ".") != 0) {
+        dirlist_free(&list);
+        return;
+    }
     
     long long total = 0;
     int count = 0;
-    struct dirent *ent;
     
-    while ((ent = readdir(d))) {
-        if (pattern[0] == '*' || strstr(ent->d_name, pattern + 1)) {
-            struct stat st;
-            if (stat(ent->d_name, &st) == 0 && S_ISREG(st.st_mode)) {
-                total += st.st_size;
-                count++;
-            }
+    dirlist_filter(&list, sizeof_match, (void *)pattern);
+    dirlist_sort(&list, dirlist_by_inode);
+    for (size_t i = 0; i < list.count; i++) {
+        struct stat st;
+        if (fstatat(list.fd, list.entries[i].name, &st, 0) == 0 && S_ISREG(st.st_mode)) {
+            total += st.st_size;
+            count++;
         }
     }
-    closedir(d);
+    dirlist_free(&list);
     
     char sz[32]; format_size(total, sz, sizeof(sz));
     printf("%d files, total: %s\n", count, sz);
 }
 
+// dirtree - directory tree with sizes, totalled bottom-up by a parallel walk
+#define DIRTREE_DEPTH 3            // Levels shown unless -d says otherwise
+
+typedef struct {
+    TreeWalk *walk;
+    uint64_t min_size;
+    int max_depth;                 // 0 for no limit
+    FileWalkOutput out;
+    char *prefix;                  // Four bytes per level shown
+} DirTreePrint;
+
+// "512", "10K", "1.5M", "2G"; -1 if malformed
+static long long parse_size(const char *s) {
+    char *end;
+    double v = strtod(s, &end);
+    if (end == s || v < 0) return -1;
+    switch (toupper((unsigned char)*end)) {
+        case 'K': v *= 1024.0; end++; break;
+        case 'M': v *= 1024.0 * 1024; end++; break;
+        case 'G': v *= 1024.0 * 1024 * 1024; end++; break;
+        case 'T': v *= 1024.0 * 1024 * 1024 * 1024; end++; break;
+    }
+    if (toupper((unsigned char)*end) == 'B') end++;
+    return *end ? -1 : (long long)v;
+}
+
+// A directory's size is its whole subtree, so it is waited for here
+static int dirtree_shown(DirTreePrint *p, TreeNode *e) {
+    if (e->type == DT_DIR) treewalk_wait(p->walk, e, TREE_DONE);
+    return e->size >= p->min_size;
+}
+
+static void dirtree_print(DirTreePrint *p, TreeNode *dir, size_t prefix_len) {
+    // With a size filter the closing branch goes on the last entry shown,
+    // which means looking ahead
+    uint32_t last = dir->child_count;
+    if (p->min_size) {
+        while (last > 0 && !dirtree_shown(p, &dir->children[last - 1])) last--;
+    }
+    for (uint32_t i = 0; i < last; i++) {
+        TreeNode *e = &dir->children[i];
+        if (!dirtree_shown(p, e)) continue;
+        const char *branch = i == last - 1 ? "+-- " : "|-- ";
+        char sz[32];
+        format_size(e->size, sz, sizeof(sz));
+        if (e->type != DT_DIR) {
+            filewalk_printf(&p->out, "%s%s%s  (%s)\n", p->prefix, branch, e->name, sz);
+        } else if (e->error) {
+            filewalk_printf(&p->out, "%s%s%s/  (unreadable)\n", p->prefix, branch, e->name);
+        } else {
+            filewalk_printf(&p->out, "%s%s%s/  (%s, %llu files)\n", p->prefix, branch, e->name, sz,
+                            (unsigned long long)e->files);
+        }
+        if (p->out.len >= 65536) {
+            fwrite(p->out.data, 1, p->out.len, stdout);
+            p->out.len = 0;
+        }
+        if (e->type == DT_DIR && (!p->max_depth || e->depth < p->max_depth)) {
+            memcpy(p->prefix + prefix_len, i == last - 1 ? "    " : "|   ", 5);
+            dirtree_print(p, e, prefix_len + 4);
+            p->prefix[prefix_len] = '\0';
+        }
+    }
+}
+
+void do_dirtree(char **args) {
+    const char *path = ".";
+    long long min_size = 0;
+    int max_depth = DIRTREE_DEPTH;
+    for (int i = 1; args[i]; i++) {
+        if (strcmp(args[i], "-s") == 0 && args[i + 1]) {
+            min_size = parse_size(args[++i]);
+            if (min_size < 0) {
+                fprintf(stderr, "dirtree: bad size '%s' (try 500K, 10M, 1G)\n", args[i]);
+                return;
+            }
+        } else if (strcmp(args[i], "-d") == 0 && args[i + 1]) {
+            max_depth = atoi(args[++i]);
+            if (max_depth < 0) max_depth = DIRTREE_DEPTH;
+        } else if (args[i][0] == '-') {
+            fprintf(stderr, "Usage: dirtree [path] [-s min_size] [-d depth]\n");
+            return;
+        } else {
+            path = args[i];
+        }
+    }
+
+    TreeWalkOptions options = {-1, 1};
+    TreeWalk *walk = treewalk_start(path, &options);
+    if (!walk) {
+        fprintf(stderr, "dirtree: %s: %s\n", path, strerror(errno));
+        return;
+    }
+    DirTreePrint p;
+    memset(&p, 0, sizeof(p));
+    p.walk = walk;
+    p.min_size = min_size;
+    p.max_depth = max_depth;
+    // Directories too deep for a path are unreadable, so this bounds an
+    // unlimited walk too
+    size_t levels = max_depth && max_depth < TREEWALK_MAX_DEPTH ? max_depth : TREEWALK_MAX_DEPTH;
+    p.prefix = calloc((levels + 1) * 4 + 1, 1);
+    if (!p.prefix) {
+        fprintf(stderr, "dirtree: out of memory\n");
+        treewalk_finish(walk);
+        return;
+    }
+
+    TreeNode *root = treewalk_root(walk);
+    printf("\n%s\n", path);
+    treewalk_wait(walk, root, TREE_LISTED);
+    dirtree_print(&p, root, 0);
+    if (p.out.len) fwrite(p.out.data, 1, p.out.len, stdout);
+    free(p.out.data);
+    free(p.prefix);
+
+    treewalk_wait(walk, root, TREE_DONE);
+    char sz[32];
+    format_size(root->size, sz, sizeof(sz));
+    printf("\n%llu directories, %llu files, %s\n\n", (unsigned long long)root->dirs,
+           (unsigned long long)root->files, sz);
+    treewalk_finish(walk);
+}
+
 // age - find files by age
 void do_age(char **args) {
     if (!args[1]) { fprintf(stderr, "Usage: age <days> [older|newer]\n"); return; }
@@ -197,18 +339,49 @@ void do_age(char **args) {
     int older = !args[2] || args[2][0] != 'n';
     time_t cutoff = time(NULL) - days * 86400;
     
-    DIR *d = opendir(".");
-    if (!d) return;
-    struct dirent *ent;
+    DirIter it;
+    if (diriter_open(&it, ".") != 0) return;
     
-    while ((ent = readdir(d))) {
+    while (diriter_next(&it)) {
         struct stat st;
-        if (stat(ent->d_name, &st) == 0) {
+        if (fstatat(it.fd, it.name, &st, 0) == 0) {
             int match = older ? (st.st_mtime < cutoff) : (st.st_mtime > cutoff);
-            if (match) printf("%s\n", ent->d_name);
+            if (match) printf("%s\n", it.name);
         }
     }
-    closedir(d);
+    diriter_close(&it);
+}
+
+// ff - fuzzy find paths anywhere below the working directory
+void do_ff(char **args) {
+    int max = 20, dirs_only = 0;
+    const char *query = NULL;
+    for (int i = 1; args[i]; i++) {
+        if (strcmp(args[i], "-n") == 0 && args[i + 1]) max = atoi(args[++i]);
+        else if (strcmp(args[i], "-d") == 0) dirs_only = 1;
+        else query = args[i];
+    }
+    if (!query) { fprintf(stderr, "Usage: ff [-n count] [-d] <query>\n"); return; }
+    if (max < 1) max = 20;
+    if (max > 1000) max = 1000;
+    
+    PathMatch *matches = malloc(sizeof(PathMatch) * max);
+    if (!matches) { fprintf(stderr, "ff: memory allocation failed\n"); return; }
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    int found = pathindex_find(query, dirs_only, 1, matches, max);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    
+    for (int i = 0; i < found; i++)
+        printf("%s%s\n", matches[i].path, matches[i].is_dir ? "/" : "");
+    
+    PathIndexStats st;
+    pathindex_stats(&st);
+    double ms = (t1.tv_sec - t0.tv_sec) * 1e3 + (t1.tv_nsec - t0.tv_nsec) / 1e6;
+    printf("%d match%s in %u path%s (%.1f ms; last refresh read %u of %u directories in %.1f ms on %d thread%s)%s\n",
+           found, found == 1 ? "" : "es", st.paths, st.paths == 1 ? "" : "s", ms, st.dirs_read, st.dirs,
+           st.refresh_ms, st.threads, st.threads == 1 ? "" : "s", st.truncated ? " [index truncated]" : "");
+    free(matches);
 }
 
 // freq - word frequency
@@ -394,18 +567,215 @@ void do_tail(char **args) {
 void do_wc(char **args) { do_lines(args); }
 
 // grep - simple search
+#define GREP_CONTEXT_MAX 100000
+#define GREP_MAX_OPERANDS 64       // The shell splits a line into at most 64 words
+
+typedef struct {
+    RegexDfa re;
+    int invert;
+    int count_only;
+    int line_numbers;
+    int show_names;
+    long before, after;          // Context lines
+} GrepOptions;
+
+// The literal rules out most lines with one memmem; the DFA confirms
+static int grep_line_matches(const GrepOptions *g, const char *line, size_t len) {
+    const RegexDfa *re = &g->re;
+    if (re->literal_len && !memmem(line, len, re->literal, re->literal_len)) return 0;
+    return re->literal_only || regexdfa_match_line(re, line, len);
+}
+
+// sep is ':' for a matching line and '-' for context, as in GNU grep
+static void grep_print(FileWalkOutput *out, const GrepOptions *g, const char *path, long num, char sep,
+                       const char *line, size_t len) {
+    if (g->show_names) filewalk_printf(out, "%s%c", path, sep);
+    if (g->line_numbers) filewalk_printf(out, "%ld%c", num, sep);
+    filewalk_append(out, line, len);
+    filewalk_append(out, "\n", 1);
+}
+
+// Plain matching jumps from one literal hit to the next, or without a
+// literal runs the DFA over the whole buffer, so lines that cannot match
+// are never looked at one by one
+static long grep_jump(const GrepOptions *g, const char *path, const char *data, size_t len,
+                      FileWalkOutput *out) {
+    const RegexDfa *re = &g->re;
+    const char *p = data, *end = data + len, *counted = data;
+    long num = 1, matches = 0;
+    while (p < end) {
+        const char *line, *line_end;
+        int matched = 1;
+        if (re->literal_len) {
+            const char *hit = memmem(p, end - p, re->literal, re->literal_len);
+            if (!hit) break;
+            line = memrchr(p, '\n', hit - p);
+            line = line ? line + 1 : p;
+            line_end = memchr(hit, '\n', end - hit);
+            if (!line_end) line_end = end;
+            matched = re->literal_only || regexdfa_match_line(re, line, line_end - line);
+        } else {
+            line = regexdfa_find_line(re, p, end);
+            if (!line) break;
+            line_end = memchr(line, '\n', end - line);
+            if (!line_end) line_end = end;
+        }
+        if (matched) {
+            matches++;
+            if (!g->count_only) {
+                if (g->line_numbers) {
+                    num += filewalk_count_lines(counted, line);
+                    counted = line;
+                }
+                grep_print(out, g, path, num, ':', line, line_end - line);
+            }
+        }
+        p = line_end + 1;
+    }
+    return matches;
+}
+
+// -v and context need every line; the last `before` lines are kept in a
+// ring until a match prints them
+static long grep_lines(const GrepOptions *g, const char *path, const char *data, size_t len,
+                       FileWalkOutput *out) {
+    typedef struct { const char *line; size_t len; } Held;
+    Held *ring = g->before ? malloc(sizeof(Held) * g->before) : NULL;
+    if (g->before && !ring) return 0;
+    const char *p = data, *end = data + len;
+    long num = 0, matches = 0, last_printed = 0, after_left = 0;
+    while (p < end) {
+        const char *line_end = memchr(p, '\n', end - p);
+        if (!line_end) line_end = end;
+        size_t line_len = line_end - p;
+        num++;
+        if (grep_line_matches(g, p, line_len) != g->invert) {
+            matches++;
+            if (!g->count_only) {
+                long first = num - g->before;
+                if (first <= last_printed) first = last_printed + 1;
+                if (first < 1) first = 1;
+                if ((g->before || g->after) && last_printed && first > last_printed + 1) {
+                    filewalk_append(out, "--\n", 3);
+                }
+                for (long k = first; k < num; k++) {
+                    const Held *h = &ring[k % g->before];
+                    grep_print(out, g, path, k, '-', h->line, h->len);
+                }
+                grep_print(out, g, path, num, ':', p, line_len);
+                last_printed = num;
+                after_left = g->after;
+            }
+        } else if (after_left > 0) {
+            grep_print(out, g, path, num, '-', p, line_len);
+            last_printed = num;
+            after_left--;
+        }
+        if (ring) {
+            ring[num % g->before].line = p;
+            ring[num % g->before].len = line_len;
+        }
+        p = line_end + 1;
+    }
+    free(ring);
+    return matches;
+}
+
+static long grep_file(const char *path, const char *data, size_t len, FileWalkOutput *out, void *ctx) {
+    const GrepOptions *g = ctx;
+    long matches = g->invert || g->before || g->after ? grep_lines(g, path, data, len, out)
+                                                      : grep_jump(g, path, data, len, out);
+    if (g->count_only) {
+        if (g->show_names) filewalk_printf(out, "%s:%ld\n", path, matches);
+        else filewalk_printf(out, "%ld\n", matches);
+    }
+    return matches;
+}
+
+// Value of -A/-B/-C: the rest of the flag word or the next argument
+static int grep_context_arg(char **args, int *i, const char *rest, long *value) {
+    const char *v = *rest ? rest : args[*i + 1];
+    if (!*rest && v) (*i)++;
+    char *end;
+    long n = v ? strtol(v, &end, 10) : -1;
+    if (!v || *end || n < 0) return -1;
+    *value = n > GREP_CONTEXT_MAX ? GREP_CONTEXT_MAX : n;
+    return 0;
+}
+
+// grep - regular expression search over files and directory trees.
+// Options may come anywhere before "--", as in GNU grep: grep 'pat' -r dir.
 void do_grep(char **args) {
-    if (!args[1] || !args[2]) { fprintf(stderr, "Usage: grep <pattern> <file>\n"); return; }
-    FILE *fp = fopen(args[2], "r");
-    if (!fp) { perror("grep"); return; }
-    
-    char line[1024];
-    int n = 1;
-    while (fgets(line, sizeof(line), fp)) {
-        if (strstr(line, args[1])) printf("%d: %s", n, line);
-        n++;
+    GrepOptions g;
+    memset(&g, 0, sizeof(g));
+    int flags = 0, recurse = 0, options = 1;
+    const char *pattern = NULL;
+    const char *usage = "Usage: grep [-i] [-v] [-c] [-n] [-r] [-F] [-A n] [-B n] [-C n] <pattern> [file...]\n";
+
+    // Operands in order, with the options taken out
+    char *operands[GREP_MAX_OPERANDS];
+    int count = 0;
+    for (int i = 1; args[i]; i++) {
+        if (!options || args[i][0] != '-' || !args[i][1]) {
+            if (count < GREP_MAX_OPERANDS - 1) operands[count++] = args[i];
+            continue;
+        }
+        if (strcmp(args[i], "--") == 0) {
+            options = 0;
+            continue;
+        }
+        for (const char *f = args[i] + 1; *f; f++) {
+            long n;
+            switch (*f) {
+            case 'i': flags |= REGEXDFA_ICASE; break;
+            case 'F': flags |= REGEXDFA_FIXED; break;
+            case 'E': break;   // Extended syntax is the only syntax
+            case 'v': g.invert = 1; break;
+            case 'c': g.count_only = 1; break;
+            case 'n': g.line_numbers = 1; break;
+            case 'r': case 'R': recurse = 1; break;
+            case 'e':
+                pattern = f[1] ? f + 1 : args[i + 1];
+                if (!pattern) { fprintf(stderr, "%s", usage); return; }
+                if (!f[1]) i++;
+                f += strlen(f) - 1;
+                break;
+            case 'A': case 'B': case 'C':
+                if (grep_context_arg(args, &i, f + 1, &n) != 0) {
+                    fprintf(stderr, "grep: invalid context length\n");
+                    return;
+                }
+                if (*f != 'B') g.after = n;
+                if (*f != 'A') g.before = n;
+                f += strlen(f) - 1;
+                break;
+            default:
+                fprintf(stderr, "grep: unknown option -%c\n%s", *f, usage);
+                return;
+            }
+        }
     }
-    fclose(fp);
+    operands[count] = NULL;
+    int first = 0;
+    if (!pattern) pattern = count ? operands[first++] : NULL;
+    if (!pattern || (first == count && !recurse)) {
+        fprintf(stderr, "%s", usage);
+        return;
+    }
+
+    const char *error;
+    if (regexdfa_compile(&g.re, pattern, flags, &error) != 0) {
+        fprintf(stderr, "grep: %s\n", error);
+        return;
+    }
+    char *here[] = {".", NULL};
+    char **paths = first < count ? operands + first : here;
+    int path_count = first < count ? count - first : 1;
+    g.show_names = recurse || path_count > 1;
+
+    FileWalk walk = {"grep", recurse, grep_file, &g};
+    filewalk_run(&walk, paths, path_count, NULL);
+    regexdfa_free(&g.re);
 }
 
 // sort - sort file lines
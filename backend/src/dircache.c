@@ -0,0 +1,378 @@
+/**
+ * Directory Cache Implementation - Snapshot, validate, look up
+ * Each snapshot holds a directory's bulk-read listing with an
+ * open-addressing index over its names. An inotify watch marks it stale when
+ * an entry is added, removed or renamed, and forgets an entry's size and
+ * mtime when the entry is written. Without inotify, and now and then even
+ * with it, one stat of the directory decides: a different inode or mtime
+ * means a rescan.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/inotify.h>
+#include "dircache.h"
+#include "dirlist.h"
+
+#define WATCH_EVENTS (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_MODIFY | \
+                      IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR)
+
+typedef struct {
+    const char *name;
+    uint32_t hash;
+    DirCacheType type;
+    int stat_valid;              // size and mtime are current
+    int64_t size;
+    struct timespec mtime;
+} DirCacheEntry;
+
+typedef struct {
+    char path[PATH_MAX];         // Absolute; "" = unused
+    uint32_t path_hash;
+    int wd;                      // inotify watch, -1 if none
+    int stale;                   // An event said the listing changed
+    dev_t dev;
+    ino_t ino;
+    struct timespec mtime;
+    int racy;                    // Changed too close to the scan to trust mtime
+    double checked_ms;           // When the mtime was last compared
+    DirList list;                // Names and the open directory, for fstatat
+                                 // on entries; kept across rescans
+    DirCacheEntry *entries;
+    uint32_t entry_count;
+    uint32_t *slots;             // Entry index + 1, 0 = empty
+    uint32_t slot_count;         // Power of two
+    uint64_t last_used;
+} DirSnapshot;
+
+static DirSnapshot snapshots[DIRCACHE_MAX_DIRS];
+static int snapshots_ready = 0;
+static uint64_t use_clock = 0;
+static int notify_fd = -1;       // -2 once inotify turned out unavailable
+static double drained_ms = 0;
+static pthread_mutex_t cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static uint32_t hash_name(const char *s) {
+    uint32_t h = 2166136261u;
+    while (*s) {
+        h ^= (unsigned char)*s++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static DirCacheType mode_type(mode_t mode) {
+    if (S_ISDIR(mode)) return DIRCACHE_DIR;
+    if (S_ISREG(mode)) return DIRCACHE_FILE;
+    return DIRCACHE_OTHER;
+}
+
+// Zeroed statics would read as fd 0 and watch 0
+static void snapshots_init(void) {
+    if (snapshots_ready) return;
+    for (int i = 0; i < DIRCACHE_MAX_DIRS; i++) {
+        dirlist_init(&snapshots[i].list);
+        snapshots[i].wd = -1;
+    }
+    snapshots_ready = 1;
+}
+
+static DirCacheEntry *snapshot_find(const DirSnapshot *s, const char *name, uint32_t hash) {
+    uint32_t slot = hash & (s->slot_count - 1);
+    while (s->slots[slot]) {
+        DirCacheEntry *e = &s->entries[s->slots[slot] - 1];
+        if (e->hash == hash && strcmp(e->name, name) == 0) return e;
+        slot = (slot + 1) & (s->slot_count - 1);
+    }
+    return NULL;
+}
+
+// Drop the watch unless another snapshot of the same inode shares it
+static void unwatch(DirSnapshot *s) {
+    if (s->wd < 0) return;
+    int shared = 0;
+    for (int i = 0; i < DIRCACHE_MAX_DIRS && !shared; i++) {
+        shared = &snapshots[i] != s && snapshots[i].path[0] && snapshots[i].wd == s->wd;
+    }
+    if (!shared && notify_fd >= 0) inotify_rm_watch(notify_fd, s->wd);
+    s->wd = -1;
+}
+
+// Forget the listing but keep its buffers for a rescan
+static void snapshot_reset(DirSnapshot *s) {
+    unwatch(s);
+    free(s->entries);
+    free(s->slots);
+    s->entries = NULL;
+    s->slots = NULL;
+    s->entry_count = s->slot_count = 0;
+    s->path[0] = '\0';
+}
+
+static void snapshot_release(DirSnapshot *s) {
+    snapshot_reset(s);
+    dirlist_free(&s->list);
+}
+
+// ============ Change Notification ============
+
+static void mark_watch(int wd, const struct inotify_event *ev) {
+    for (int i = 0; i < DIRCACHE_MAX_DIRS; i++) {
+        DirSnapshot *s = &snapshots[i];
+        if (!s->path[0] || (wd >= 0 && s->wd != wd)) continue;
+        // A write to an entry only dates its size and mtime
+        if (ev && ev->len && (ev->mask & (IN_MODIFY | IN_ATTRIB))) {
+            DirCacheEntry *e = snapshot_find(s, ev->name, hash_name(ev->name));
+            if (e) e->stat_valid = 0;
+            continue;
+        }
+        s->stale = 1;
+        if (ev && (ev->mask & IN_IGNORED)) s->wd = -1;  // The watch is gone
+    }
+}
+
+// Apply queued events; one read covers every watched directory
+static void drain_events(void) {
+    if (notify_fd < 0) return;
+    char buf[8192] __attribute__((aligned(__alignof__(struct inotify_event))));
+    ssize_t n;
+    while ((n = read(notify_fd, buf, sizeof(buf))) > 0) {
+        for (char *p = buf; p < buf + n;) {
+            const struct inotify_event *ev = (const struct inotify_event *)p;
+            if (ev->mask & IN_Q_OVERFLOW) mark_watch(-1, NULL);
+            else mark_watch(ev->wd, ev);
+            p += sizeof(struct inotify_event) + ev->len;
+        }
+    }
+}
+
+static int add_watch(const char *path) {
+    if (notify_fd == -1) {
+        notify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (notify_fd < 0) notify_fd = -2;
+    }
+    return notify_fd >= 0 ? inotify_add_watch(notify_fd, path, WATCH_EVENTS) : -1;
+}
+
+// ============ Scanning ============
+
+// Read the directory into s; d_type gives most types without a stat
+static int snapshot_scan(DirSnapshot *s, const char *path, const struct stat *st) {
+    // A rescan reuses the listing's buffers; another directory starts over
+    if (strcmp(s->path, path) != 0) snapshot_release(s);
+    else snapshot_reset(s);
+    // Watching before reading leaves no gap for a change to slip through
+    s->wd = add_watch(path);
+    s->stale = 0;
+    if (dirlist_read(&s->list, path) != 0) {
+        snapshot_release(s);
+        return -1;
+    }
+
+    s->entries = malloc(sizeof(DirCacheEntry) * (s->list.count ? s->list.count : 1));
+    if (!s->entries) {
+        snapshot_release(s);
+        return -1;
+    }
+    for (size_t i = 0; i < s->list.count; i++) {
+        const DirListEntry *de = &s->list.entries[i];
+        DirCacheEntry *e = &s->entries[s->entry_count++];
+        e->name = de->name;
+        e->hash = hash_name(de->name);
+        e->stat_valid = 0;
+        e->size = 0;
+        e->mtime.tv_sec = e->mtime.tv_nsec = 0;
+        e->type = de->type == DT_DIR ? DIRCACHE_DIR
+                : de->type == DT_REG ? DIRCACHE_FILE
+                : DIRCACHE_OTHER;
+        // Links report their target
+        struct stat est;
+        if (de->type == DT_LNK && fstatat(s->list.fd, de->name, &est, 0) == 0) {
+            e->type = mode_type(est.st_mode);
+            e->size = est.st_size;
+            e->mtime = est.st_mtim;
+            e->stat_valid = 1;
+        }
+    }
+
+    s->slot_count = 16;
+    while (s->slot_count < s->entry_count * 2) s->slot_count *= 2;
+    s->slots = calloc(s->slot_count, sizeof(uint32_t));
+    if (!s->slots) {
+        snapshot_release(s);
+        return -1;
+    }
+    for (uint32_t i = 0; i < s->entry_count; i++) {
+        uint32_t slot = s->entries[i].hash & (s->slot_count - 1);
+        while (s->slots[slot]) slot = (slot + 1) & (s->slot_count - 1);
+        s->slots[slot] = i + 1;
+    }
+
+    snprintf(s->path, sizeof(s->path), "%s", path);
+    s->path_hash = hash_name(path);
+    s->dev = st->st_dev;
+    s->ino = st->st_ino;
+    s->mtime = st->st_mtim;
+    // An entry added in the same clock tick as the scan may not move the
+    // mtime, so a very recent mtime is rechecked by rescanning. A watch
+    // sees such changes itself.
+    s->racy = s->wd < 0 && time(NULL) - st->st_mtim.tv_sec < 2;
+    return 0;
+}
+
+// Current snapshot of an absolute directory path, scanning if needed
+static DirSnapshot *snapshot_get(const char *path) {
+    snapshots_init();
+    double now = now_ms();
+    if (now - drained_ms >= DIRCACHE_RECHECK_MS) {
+        drain_events();
+        drained_ms = now;
+    }
+
+    uint32_t path_hash = hash_name(path);
+    DirSnapshot *found = NULL, *victim = &snapshots[0];
+    for (int i = 0; i < DIRCACHE_MAX_DIRS; i++) {
+        DirSnapshot *s = &snapshots[i];
+        if (s->path[0] && s->path_hash == path_hash && strcmp(s->path, path) == 0) {
+            found = s;
+            break;
+        }
+        if (!s->path[0] || (victim->path[0] && s->last_used < victim->last_used)) victim = s;
+    }
+
+    double trust = found && found->wd >= 0 ? DIRCACHE_WATCHED_RECHECK_MS : DIRCACHE_RECHECK_MS;
+    if (found && !found->stale && now - found->checked_ms < trust) {
+        found->last_used = ++use_clock;
+        return found;
+    }
+
+    struct stat st;
+    if (stat(path, &st) != 0 || !S_ISDIR(st.st_mode)) {
+        if (found) snapshot_release(found);
+        return NULL;
+    }
+    if (!found || found->stale || found->racy || found->dev != st.st_dev ||
+        found->ino != st.st_ino || found->mtime.tv_sec != st.st_mtim.tv_sec ||
+        found->mtime.tv_nsec != st.st_mtim.tv_nsec) {
+        if (!found) found = victim;
+        if (snapshot_scan(found, path, &st) != 0) return NULL;
+    } else if (found->wd < 0) {
+        // Unwatched, writes to entries go unseen, so their stats expire
+        for (uint32_t i = 0; i < found->entry_count; i++) found->entries[i].stat_valid = 0;
+    }
+    found->checked_ms = now;
+    found->last_used = ++use_clock;
+    return found;
+}
+
+// ============ Lookup ============
+
+// The first dir_len bytes of path as an absolute directory in out
+// (PATH_MAX bytes); dir_len 0 means the working directory
+static int absolute_dir(const char *path, size_t dir_len, char *out) {
+    if (path[0] == '/') {
+        size_t n = dir_len ? dir_len : 1;
+        memcpy(out, path, n);
+        out[n] = '\0';
+        return 0;
+    }
+    if (!getcwd(out, PATH_MAX)) return -1;
+    if (dir_len) {
+        size_t n = strlen(out);
+        if (n + 1 + dir_len >= PATH_MAX) return -1;
+        out[n] = '/';
+        memcpy(out + n + 1, path, dir_len);
+        out[n + 1 + dir_len] = '\0';
+    }
+    return 0;
+}
+
+DirCacheType dircache_lookup(const char *path) {
+    if (!path || !*path) return DIRCACHE_NONE;
+
+    // Split into an absolute directory and a name, ignoring trailing '/'
+    char dir[PATH_MAX], name[NAME_MAX + 1];
+    size_t len = strlen(path);
+    while (len > 1 && path[len - 1] == '/') len--;
+    const char *slash = memrchr(path, '/', len);
+    if (slash == path && len == 1) return DIRCACHE_DIR;  // "/"
+
+    const char *base = slash ? slash + 1 : path;
+    size_t base_len = len - (base - path);
+    if (base_len == 0 || base_len > NAME_MAX) return DIRCACHE_NONE;
+    memcpy(name, base, base_len);
+    name[base_len] = '\0';
+    if (absolute_dir(path, slash ? (size_t)(slash - path) : 0, dir) != 0) return DIRCACHE_NONE;
+
+    DirCacheType type = DIRCACHE_NONE;
+    pthread_mutex_lock(&cache_lock);
+    DirSnapshot *s = snapshot_get(dir);
+    if (s) {
+        const DirCacheEntry *e = snapshot_find(s, name, hash_name(name));
+        if (e) type = e->type;
+    }
+    pthread_mutex_unlock(&cache_lock);
+    return type;
+}
+
+int dircache_list(const char *dir, const char *prefix, int want_stat, DirCacheFn fn, void *ctx) {
+    char abs[PATH_MAX];
+    size_t len = dir ? strlen(dir) : 0;
+    while (len > 1 && dir[len - 1] == '/') len--;
+    if (len >= PATH_MAX) return -1;
+    if (len == 1 && dir[0] == '.') len = 0;
+    if (absolute_dir(len ? dir : ".", len, abs) != 0) return -1;
+    size_t prefix_len = prefix ? strlen(prefix) : 0;
+
+    pthread_mutex_lock(&cache_lock);
+    DirSnapshot *s = snapshot_get(abs);
+    if (!s) {
+        pthread_mutex_unlock(&cache_lock);
+        return -1;
+    }
+    int listed = 0;
+    for (uint32_t i = 0; i < s->entry_count; i++) {
+        DirCacheEntry *e = &s->entries[i];
+        if (e->name[0] == '.' && (!e->name[1] || (e->name[1] == '.' && !e->name[2]))) continue;
+        if (prefix_len && strncmp(e->name, prefix, prefix_len) != 0) continue;
+        if (want_stat && !e->stat_valid) {
+            struct stat st;
+            if (fstatat(s->list.fd, e->name, &st, 0) == 0) {
+                e->size = st.st_size;
+                e->mtime = st.st_mtim;
+            } else {
+                e->size = 0;
+                e->mtime.tv_sec = e->mtime.tv_nsec = 0;
+            }
+            e->stat_valid = 1;
+        }
+        DirCacheItem item = {e->name, e->type, e->size, e->mtime};
+        listed++;
+        if (fn(&item, ctx)) break;
+    }
+    pthread_mutex_unlock(&cache_lock);
+    return listed;
+}
+
+void dircache_clear(void) {
+    pthread_mutex_lock(&cache_lock);
+    snapshots_init();
+    for (int i = 0; i < DIRCACHE_MAX_DIRS; i++) {
+        if (snapshots[i].path[0]) snapshot_release(&snapshots[i]);
+    }
+    pthread_mutex_unlock(&cache_lock);
+}
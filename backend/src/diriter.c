@@ -0,0 +1,65 @@
+/**
+ * Directory Iterator Implementation
+ * The directory is opened as an fd first and handed to fdopendir, so the
+ * same fd serves readdir and every fstatat/openat on its entries.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "diriter.h"
+#include "dirlist.h"
+
+static int iter_from_fd(DirIter *it, int fd) {
+    memset(it, 0, sizeof(DirIter));
+    it->fd = -1;
+    if (fd < 0) return -1;
+    it->dir = fdopendir(fd);
+    if (!it->dir) {
+        close(fd);
+        return -1;
+    }
+    it->fd = fd;
+    return 0;
+}
+
+int diriter_open(DirIter *it, const char *path) {
+    return iter_from_fd(it, open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+}
+
+int diriter_openat(DirIter *it, int dirfd, const char *name) {
+    return iter_from_fd(it, openat(dirfd, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC));
+}
+
+int diriter_next(DirIter *it) {
+    if (!it->dir) return 0;
+    struct dirent *de;
+    while ((de = readdir(it->dir)) != NULL) {
+        const char *n = de->d_name;
+        if (n[0] == '.' && (!n[1] || (n[1] == '.' && !n[2]))) continue;
+        it->name = n;
+        it->type = de->d_type;
+        it->stat_state = 0;
+        // Only filesystems without d_type (some XFS, older NFS) pay a stat here
+        if (it->type == DT_UNKNOWN && diriter_stat(it)) it->type = dirlist_mode_type(it->st.st_mode);
+        return 1;
+    }
+    it->name = NULL;
+    return 0;
+}
+
+const struct stat *diriter_stat(DirIter *it) {
+    if (!it->name) return NULL;
+    if (it->stat_state == 0) {
+        it->stat_state = fstatat(it->fd, it->name, &it->st, AT_SYMLINK_NOFOLLOW) == 0 ? 1 : -1;
+    }
+    return it->stat_state == 1 ? &it->st : NULL;
+}
+
+void diriter_close(DirIter *it) {
+    if (it->dir) closedir(it->dir);  // Also closes fd
+    it->dir = NULL;
+    it->fd = -1;
+    it->name = NULL;
+}
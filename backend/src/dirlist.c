@@ -0,0 +1,156 @@
+/**
+ * Directory List Implementation
+ * Each getdents64 call gets the free tail of the current buffer, which is
+ * left as the kernel wrote it; entries point at the names inside its
+ * records. A nearly full buffer is followed by one twice its size.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include "dirlist.h"
+
+#define MIN_READ 32768           // Less room than this moves on to the next buffer
+
+struct DirListBlock {
+    DirListBlock *next;
+    size_t size;
+    char data[] __attribute__((aligned(__alignof__(struct dirent64))));
+};
+
+void dirlist_init(DirList *list) {
+    memset(list, 0, sizeof(DirList));
+    list->fd = -1;
+}
+
+static int push_entry(DirList *list, const struct dirent64 *d) {
+    if (list->count == list->capacity) {
+        size_t cap = list->capacity ? list->capacity * 2 : 256;
+        DirListEntry *grown = realloc(list->entries, sizeof(DirListEntry) * cap);
+        if (!grown) return -1;
+        list->entries = grown;
+        list->capacity = cap;
+    }
+    DirListEntry *e = &list->entries[list->count++];
+    e->name = d->d_name;
+    e->ino = d->d_ino;
+    e->type = d->d_type;
+    return 0;
+}
+
+static int read_fd(DirList *list, int fd) {
+    if (list->fd >= 0) close(list->fd);
+    list->fd = -1;
+    list->count = 0;
+    if (fd < 0) return -1;
+
+    DirListBlock *block = NULL;
+    DirListBlock **next = &list->blocks;
+    size_t used = 0;
+    for (;;) {
+        if (!block || block->size - used < MIN_READ) {
+            if (!*next) {
+                size_t size = block ? block->size * 2 : DIRLIST_BLOCK_SIZE;
+                if (size > DIRLIST_MAX_BLOCK) size = DIRLIST_MAX_BLOCK;
+                DirListBlock *fresh = malloc(sizeof(DirListBlock) + size);
+                if (!fresh) {
+                    errno = ENOMEM;
+                    goto fail;
+                }
+                fresh->next = NULL;
+                fresh->size = size;
+                *next = fresh;
+            }
+            block = *next;
+            next = &block->next;
+            used = 0;
+        }
+
+        ssize_t n = getdents64(fd, block->data + used, block->size - used);
+        if (n < 0) goto fail;
+        if (n == 0) break;
+        for (ssize_t off = 0; off < n;) {
+            const struct dirent64 *d = (const struct dirent64 *)(block->data + used + off);
+            off += d->d_reclen;
+            const char *name = d->d_name;
+            if (name[0] == '.' && (!name[1] || (name[1] == '.' && !name[2]))) continue;
+            if (push_entry(list, d) != 0) {
+                errno = ENOMEM;
+                goto fail;
+            }
+        }
+        used += n;
+    }
+    list->fd = fd;
+
+    // Only filesystems without d_type (some XFS, older NFS) pay a stat here
+    for (size_t i = 0; i < list->count; i++) {
+        DirListEntry *e = &list->entries[i];
+        struct stat st;
+        if (e->type != DT_UNKNOWN || dirlist_stat(list, e, &st) != 0) continue;
+        e->type = dirlist_mode_type(st.st_mode);
+    }
+    return 0;
+
+fail:;
+    int saved = errno;
+    close(fd);
+    list->count = 0;
+    errno = saved;
+    return -1;
+}
+
+int dirlist_read(DirList *list, const char *path) {
+    return read_fd(list, open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+}
+
+int dirlist_readat(DirList *list, int dirfd, const char *name) {
+    return read_fd(list, openat(dirfd, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC));
+}
+
+void dirlist_sort(DirList *list, int (*cmp)(const void *, const void *)) {
+    if (list->count > 1) qsort(list->entries, list->count, sizeof(DirListEntry), cmp);
+}
+
+int dirlist_by_name(const void *a, const void *b) {
+    return strcmp(((const DirListEntry *)a)->name, ((const DirListEntry *)b)->name);
+}
+
+int dirlist_by_inode(const void *a, const void *b) {
+    uint64_t ia = ((const DirListEntry *)a)->ino;
+    uint64_t ib = ((const DirListEntry *)b)->ino;
+    return ia < ib ? -1 : ia > ib;
+}
+
+size_t dirlist_filter(DirList *list, int (*keep)(const DirListEntry *e, void *ctx), void *ctx) {
+    size_t kept = 0;
+    for (size_t i = 0; i < list->count; i++) {
+        if (keep(&list->entries[i], ctx)) list->entries[kept++] = list->entries[i];
+    }
+    list->count = kept;
+    return kept;
+}
+
+int dirlist_stat(const DirList *list, const DirListEntry *e, struct stat *st) {
+    return fstatat(list->fd, e->name, st, AT_SYMLINK_NOFOLLOW);
+}
+
+unsigned char dirlist_mode_type(mode_t m) {
+    return S_ISDIR(m) ? DT_DIR : S_ISREG(m) ? DT_REG : S_ISLNK(m) ? DT_LNK
+         : S_ISFIFO(m) ? DT_FIFO : S_ISSOCK(m) ? DT_SOCK
+         : S_ISCHR(m) ? DT_CHR : DT_BLK;
+}
+
+void dirlist_free(DirList *list) {
+    if (list->fd >= 0) close(list->fd);
+    while (list->blocks) {
+        DirListBlock *next = list->blocks->next;
+        free(list->blocks);
+        list->blocks = next;
+    }
+    free(list->entries);
+    dirlist_init(list);
+}
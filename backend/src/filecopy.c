@@ -0,0 +1,488 @@
+/**
+ * File Copy Implementation
+ * One file: FICLONE, then copy_file_range over each data region, then
+ * pread/pwrite once the kernel has refused. Trees: workers pop tasks from
+ * a shared stack. A directory task reads its directory in bulk, creates
+ * the subdirectories and queues them along with its files, so even one
+ * huge directory is spread over every worker.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <linux/fs.h>
+#include "filecopy.h"
+#include "dirlist.h"
+#include "arena.h"
+
+#define COPY_CHUNK (1 << 30)          // Largest single copy_file_range request
+#define TASK_BATCH 256                // Tasks queued per lock
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static int thread_count(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    if (n < FILECOPY_MIN_THREADS) n = FILECOPY_MIN_THREADS;
+    return n > FILECOPY_MAX_THREADS ? FILECOPY_MAX_THREADS : (int)n;
+}
+
+static void add_stats(FileCopyStats *to, const FileCopyStats *from) {
+    to->files += from->files;
+    to->dirs += from->dirs;
+    to->links += from->links;
+    to->bytes += from->bytes;
+    to->cloned += from->cloned;
+    to->errors += from->errors;
+}
+
+// ============ One File ============
+
+typedef struct {
+    char *buffer;                     // Allocated on first use
+    int kernel;                       // copy_file_range is still worth trying
+} CopyState;
+
+static int write_all(int fd, const char *buf, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, buf, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        buf += n;
+        len -= n;
+    }
+    return 0;
+}
+
+static int pwrite_all(int fd, const char *buf, size_t len, off_t pos) {
+    while (len > 0) {
+        ssize_t n = pwrite(fd, buf, len, pos);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        buf += n;
+        len -= n;
+        pos += n;
+    }
+    return 0;
+}
+
+// Copy [start, end) of in to the same offsets of out. Returns 0 (early if
+// the source has shrunk), -1 for a read error, -2 for a write error.
+static int copy_range(int in, int out, off_t start, off_t end, CopyState *cs) {
+    off_t pos = start;
+    while (pos < end) {
+        size_t want = end - pos > COPY_CHUNK ? COPY_CHUNK : (size_t)(end - pos);
+        if (cs->kernel) {
+            loff_t in_off = pos, out_off = pos;
+            ssize_t n = copy_file_range(in, &in_off, out, &out_off, want, 0);
+            if (n > 0) {
+                pos += n;
+                continue;
+            }
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0 && errno != EXDEV && errno != EINVAL && errno != ENOSYS && errno != EOPNOTSUPP) return -2;
+            // Refused, or 0 from a pseudo-file that reports a size it doesn't
+            // have: the buffer decides
+            cs->kernel = 0;
+        }
+        if (!cs->buffer && !(cs->buffer = malloc(FILECOPY_BUFFER_SIZE))) return -2;
+        ssize_t n = pread(in, cs->buffer, want < FILECOPY_BUFFER_SIZE ? want : FILECOPY_BUFFER_SIZE, pos);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) return -1;
+        if (n == 0) return 0;
+        if (pwrite_all(out, cs->buffer, n, pos) < 0) return -2;
+        pos += n;
+    }
+    return 0;
+}
+
+// Files without a size to go by (/proc, FIFOs) are read to EOF
+static int copy_stream(int in, int out, CopyState *cs, off_t *copied) {
+    if (!cs->buffer && !(cs->buffer = malloc(FILECOPY_BUFFER_SIZE))) return -2;
+    for (;;) {
+        ssize_t n = read(in, cs->buffer, FILECOPY_BUFFER_SIZE);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) return -1;
+        if (n == 0) return 0;
+        if (write_all(out, cs->buffer, n) < 0) return -2;
+        *copied += n;
+    }
+}
+
+static int copy_data(int in, int out, const struct stat *st, CopyState *cs, off_t *copied, int *cloned) {
+    if (ioctl(out, FICLONE, in) == 0) {
+        *copied = st->st_size;
+        *cloned = 1;
+        return 0;
+    }
+    if (!S_ISREG(st->st_mode) || st->st_size == 0) return copy_stream(in, out, cs, copied);
+
+    // Fewer allocated blocks than bytes means there are holes to skip
+    off_t size = st->st_size, pos = 0;
+    int sparse = (off_t)st->st_blocks * 512 < size;
+    while (pos < size) {
+        off_t data = pos, hole = size;
+        if (sparse) {
+            data = lseek(in, pos, SEEK_DATA);
+            if (data < 0 && errno == ENXIO) break;       // Only a hole is left
+            if (data < 0) {
+                sparse = 0;
+                data = pos;
+            } else if ((hole = lseek(in, data, SEEK_HOLE)) < 0 || hole > size) {
+                hole = size;
+            }
+        }
+        int rc = copy_range(in, out, data, hole, cs);
+        if (rc < 0) return rc;
+        pos = hole;
+    }
+    *copied = size;
+    return ftruncate(out, size) == 0 ? 0 : -2;          // Covers a trailing hole
+}
+
+static int copy_one(const char *src, const char *dst, CopyState *cs, FileCopyStats *stats) {
+    int in = open(src, O_RDONLY | O_CLOEXEC);
+    if (in < 0) return -1;
+    struct stat st;
+    int rc = fstat(in, &st);
+    if (rc == 0 && S_ISDIR(st.st_mode)) {
+        rc = -1;
+        errno = EISDIR;
+    }
+    if (rc < 0) {
+        int err = errno;
+        close(in);
+        errno = err;
+        return -1;
+    }
+    int out = open(dst, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (out < 0) {
+        int err = errno;
+        close(in);
+        errno = err;
+        return -2;
+    }
+    off_t copied = 0;
+    int cloned = 0;
+    rc = copy_data(in, out, &st, cs, &copied, &cloned);
+    if (rc == 0 && fchmod(out, st.st_mode & 07777) < 0) rc = -2;
+    int err = errno;
+    if (close(out) < 0 && rc == 0) {
+        rc = -2;
+        err = errno;
+    }
+    close(in);
+    if (rc < 0) {
+        errno = err;
+        return rc;
+    }
+    stats->files++;
+    stats->bytes += copied;
+    stats->cloned += cloned;
+    return 0;
+}
+
+// ============ Trees ============
+
+typedef struct {
+    const char *src;
+    const char *dst;
+    unsigned char type;               // DT_DIR or DT_REG
+} CopyTask;
+
+typedef struct {
+    const char *path;
+    mode_t mode;
+} DirMode;
+
+typedef struct {
+    const char *name;
+    mode_t umask;
+    CopyTask *stack;
+    size_t count, cap;
+    int active;                       // Workers running a task
+    int failed;                       // Out of memory: tasks were dropped
+    DirMode *modes;                   // Directories that must lose owner
+    size_t mode_count, mode_cap;      // access once they are filled
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+} CopyQueue;
+
+typedef struct {
+    CopyQueue *queue;
+    Arena arena;                      // Paths of the tasks this worker queued
+    DirList list;
+    CopyState state;
+    FileCopyStats stats;
+} CopyWorker;
+
+static void queue_push(CopyQueue *q, const CopyTask *tasks, size_t count) {
+    pthread_mutex_lock(&q->lock);
+    if (q->count + count > q->cap) {
+        size_t cap = q->cap * 2 > q->count + count ? q->cap * 2 : q->count + count;
+        CopyTask *grown = realloc(q->stack, sizeof(CopyTask) * cap);
+        if (grown) {
+            q->stack = grown;
+            q->cap = cap;
+        }
+    }
+    if (q->count + count <= q->cap) {
+        memcpy(q->stack + q->count, tasks, sizeof(CopyTask) * count);
+        q->count += count;
+    } else {
+        q->failed = 1;
+    }
+    pthread_cond_broadcast(&q->wake);
+    pthread_mutex_unlock(&q->lock);
+}
+
+// "dir/name", without a leading "./" for the working directory
+static char *join_path(Arena *arena, const char *dir, const char *name) {
+    size_t dir_len = strcmp(dir, ".") == 0 ? 0 : strlen(dir);
+    int slash = dir_len && dir[dir_len - 1] != '/';
+    size_t name_len = strlen(name);
+    char *path = arena_alloc(arena, dir_len + slash + name_len + 1);
+    if (!path) return NULL;
+    memcpy(path, dir, dir_len);
+    if (slash) path[dir_len] = '/';
+    memcpy(path + dir_len + slash, name, name_len + 1);
+    return path;
+}
+
+static void report(CopyWorker *w, const char *path, int err) {
+    fprintf(stderr, "%s: %s: %s\n", w->queue->name, path, strerror(err));
+    w->stats.errors++;
+}
+
+// A new directory stays writable while it is filled; its real mode is set
+// now if that keeps owner access, or after the whole tree otherwise. An
+// existing directory is merged into and keeps its mode.
+static int make_dir(CopyQueue *q, const char *path, mode_t mode) {
+    mode &= 07777;
+    if (mkdir(path, mode | S_IRWXU) < 0) {
+        int err = errno;
+        struct stat st;
+        if (err == EEXIST && stat(path, &st) == 0 && S_ISDIR(st.st_mode)) return 0;
+        errno = err == EEXIST ? ENOTDIR : err;
+        return -1;
+    }
+    if (((mode | S_IRWXU) & ~q->umask) == mode) return 0;
+    if ((mode & S_IRWXU) == S_IRWXU) return chmod(path, mode);
+
+    pthread_mutex_lock(&q->lock);
+    if (q->mode_count == q->mode_cap) {
+        size_t cap = q->mode_cap ? q->mode_cap * 2 : 16;
+        DirMode *grown = realloc(q->modes, sizeof(DirMode) * cap);
+        if (grown) {
+            q->modes = grown;
+            q->mode_cap = cap;
+        }
+    }
+    if (q->mode_count < q->mode_cap) {
+        q->modes[q->mode_count].path = path;
+        q->modes[q->mode_count].mode = mode;
+        q->mode_count++;
+    }
+    pthread_mutex_unlock(&q->lock);
+    return 0;
+}
+
+static void copy_link(CopyWorker *w, const DirListEntry *e, const char *dst) {
+    char target[4096];
+    ssize_t n = readlinkat(w->list.fd, e->name, target, sizeof(target) - 1);
+    if (n < 0) {
+        report(w, dst, errno);
+        return;
+    }
+    target[n] = '\0';
+    if (symlink(target, dst) < 0 && (errno != EEXIST || unlink(dst) < 0 || symlink(target, dst) < 0)) {
+        report(w, dst, errno);
+        return;
+    }
+    w->stats.links++;
+}
+
+static void copy_dir(CopyWorker *w, const CopyTask *task) {
+    CopyQueue *q = w->queue;
+    if (dirlist_read(&w->list, task->src) != 0) {
+        report(w, task->src, errno);
+        return;
+    }
+    CopyTask batch[TASK_BATCH];
+    size_t pending = 0;
+    for (size_t i = 0; i < w->list.count; i++) {
+        const DirListEntry *e = &w->list.entries[i];
+        if (e->type == DT_UNKNOWN) continue;             // Gone since the read
+        if (e->type != DT_DIR && e->type != DT_REG && e->type != DT_LNK) {
+            fprintf(stderr, "%s: %s/%s: skipping special file\n", q->name, task->src, e->name);
+            continue;
+        }
+        char *dst = join_path(&w->arena, task->dst, e->name);
+        char *src = e->type == DT_LNK ? NULL : join_path(&w->arena, task->src, e->name);
+        if (!dst || (e->type != DT_LNK && !src)) {
+            pthread_mutex_lock(&q->lock);
+            q->failed = 1;
+            pthread_mutex_unlock(&q->lock);
+            break;
+        }
+        if (e->type == DT_LNK) {
+            copy_link(w, e, dst);
+            continue;
+        }
+        if (e->type == DT_DIR) {
+            struct stat st;
+            if (dirlist_stat(&w->list, e, &st) != 0 || make_dir(q, dst, st.st_mode) != 0) {
+                report(w, dst, errno);
+                continue;
+            }
+            w->stats.dirs++;
+        }
+        batch[pending].src = src;
+        batch[pending].dst = dst;
+        batch[pending].type = e->type;
+        if (++pending == TASK_BATCH) {
+            queue_push(q, batch, pending);
+            pending = 0;
+        }
+    }
+    if (pending) queue_push(q, batch, pending);
+}
+
+static void *copy_worker(void *arg) {
+    CopyWorker *w = arg;
+    CopyQueue *q = w->queue;
+    for (;;) {
+        pthread_mutex_lock(&q->lock);
+        while (q->count == 0 && q->active > 0) pthread_cond_wait(&q->wake, &q->lock);
+        if (q->count == 0) {
+            // Nothing queued and nobody left to queue more
+            pthread_cond_broadcast(&q->wake);
+            pthread_mutex_unlock(&q->lock);
+            return NULL;
+        }
+        CopyTask task = q->stack[--q->count];
+        q->active++;
+        pthread_mutex_unlock(&q->lock);
+
+        if (task.type == DT_DIR) {
+            copy_dir(w, &task);
+        } else {
+            int rc = copy_one(task.src, task.dst, &w->state, &w->stats);
+            if (rc < 0) report(w, rc == -1 ? task.src : task.dst, errno);
+        }
+
+        pthread_mutex_lock(&q->lock);
+        q->active--;
+        if (q->count == 0 && q->active == 0) pthread_cond_broadcast(&q->wake);
+        pthread_mutex_unlock(&q->lock);
+    }
+}
+
+// Deepest first, so each parent is still writable while its children change
+static int compare_depth(const void *a, const void *b) {
+    size_t la = strlen(((const DirMode *)a)->path), lb = strlen(((const DirMode *)b)->path);
+    return la < lb ? 1 : la > lb ? -1 : 0;
+}
+
+// ============ Public API ============
+
+int filecopy_file(const char *src, const char *dst, FileCopyStats *stats) {
+    double t0 = now_ms();
+    CopyState cs = {NULL, 1};
+    int rc = copy_one(src, dst, &cs, stats);
+    int err = errno;
+    free(cs.buffer);
+    if (stats->threads < 1) stats->threads = 1;
+    stats->elapsed_ms += now_ms() - t0;
+    errno = err;
+    return rc;
+}
+
+int filecopy_tree(const char *name, const char *src, const char *dst, FileCopyStats *stats) {
+    double t0 = now_ms();
+    uint64_t errors = stats->errors;
+    struct stat st;
+    if (stat(src, &st) != 0) {
+        fprintf(stderr, "%s: %s: %s\n", name, src, strerror(errno));
+        stats->errors++;
+        return -1;
+    }
+
+    CopyQueue q;
+    memset(&q, 0, sizeof(q));
+    q.name = name;
+    q.umask = umask(0);
+    umask(q.umask);
+    pthread_mutex_init(&q.lock, NULL);
+    pthread_cond_init(&q.wake, NULL);
+    int threads = thread_count();
+    CopyWorker *workers = calloc(threads, sizeof(CopyWorker));
+    if (!workers || make_dir(&q, dst, st.st_mode) != 0) {
+        fprintf(stderr, "%s: %s: %s\n", name, dst, workers ? strerror(errno) : "out of memory");
+        stats->errors++;
+        free(workers);
+        free(q.modes);
+        pthread_mutex_destroy(&q.lock);
+        pthread_cond_destroy(&q.wake);
+        return -1;
+    }
+    stats->dirs++;
+    for (int i = 0; i < threads; i++) {
+        workers[i].queue = &q;
+        arena_init(&workers[i].arena);
+        dirlist_init(&workers[i].list);
+        workers[i].state.kernel = 1;
+    }
+    CopyTask root = {src, dst, DT_DIR};
+    queue_push(&q, &root, 1);
+
+    pthread_t tids[FILECOPY_MAX_THREADS];
+    int started = 0;
+    for (int i = 1; i < threads; i++) {
+        if (pthread_create(&tids[started], NULL, copy_worker, &workers[i]) == 0) started++;
+    }
+    copy_worker(&workers[0]);
+    for (int i = 0; i < started; i++) pthread_join(tids[i], NULL);
+
+    if (q.mode_count) qsort(q.modes, q.mode_count, sizeof(DirMode), compare_depth);
+    for (size_t i = 0; i < q.mode_count; i++) {
+        if (chmod(q.modes[i].path, q.modes[i].mode) != 0) {
+            fprintf(stderr, "%s: %s: %s\n", name, q.modes[i].path, strerror(errno));
+            stats->errors++;
+        }
+    }
+    if (q.failed) {
+        fprintf(stderr, "%s: out of memory, some files were not copied\n", name);
+        stats->errors++;
+    }
+
+    for (int i = 0; i < threads; i++) {
+        add_stats(stats, &workers[i].stats);
+        arena_free(&workers[i].arena);
+        dirlist_free(&workers[i].list);
+        free(workers[i].state.buffer);
+    }
+    free(workers);
+    free(q.stack);
+    free(q.modes);
+    pthread_mutex_destroy(&q.lock);
+    pthread_cond_destroy(&q.wake);
+
+    if (stats->threads < started + 1) stats->threads = started + 1;
+    stats->elapsed_ms += now_ms() - t0;
+    return stats->errors == errors ? 0 : -1;
+}
@@ -0,0 +1,465 @@
+/**
+ * File Walk Implementation
+ * Collection: workers pop directories from a shared stack, read each one
+ * in bulk and record its files in their own arenas. Scanning: workers
+ * claim files by index and mark each result done; the calling thread
+ * prints results strictly in index order as they complete. A worker
+ * waits before claiming a file more than FILEWALK_WINDOW past the one
+ * being printed, so finished results waiting behind a slow file stay
+ * bounded.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "filewalk.h"
+#include "dirlist.h"
+#include "arena.h"
+
+#define READ_CHUNK 65536
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static int thread_count(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    if (n < 1) n = 1;
+    return n > FILEWALK_MAX_THREADS ? FILEWALK_MAX_THREADS : (int)n;
+}
+
+// ============ Output ============
+
+static int output_reserve(FileWalkOutput *out, size_t extra) {
+    if (out->len + extra <= out->cap) return 0;
+    size_t cap = out->cap ? out->cap : 256;
+    while (cap < out->len + extra) cap *= 2;
+    char *grown = realloc(out->data, cap);
+    if (!grown) return -1;
+    out->data = grown;
+    out->cap = cap;
+    return 0;
+}
+
+void filewalk_append(FileWalkOutput *out, const char *s, size_t len) {
+    if (output_reserve(out, len) != 0) return;
+    memcpy(out->data + out->len, s, len);
+    out->len += len;
+}
+
+void filewalk_printf(FileWalkOutput *out, const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(out->data ? out->data + out->len : NULL, out->cap - out->len, fmt, ap);
+    va_end(ap);
+    if (n < 0) return;
+    if (out->len + n < out->cap) {
+        out->len += n;
+        return;
+    }
+    if (output_reserve(out, (size_t)n + 1) != 0) return;
+    va_start(ap, fmt);
+    vsnprintf(out->data + out->len, out->cap - out->len, fmt, ap);
+    va_end(ap);
+    out->len += n;
+}
+
+long filewalk_count_lines(const char *p, const char *end) {
+    long n = 0;
+    while ((p = memchr(p, '\n', end - p)) != NULL) {
+        n++;
+        p++;
+    }
+    return n;
+}
+
+// ============ Collection ============
+
+typedef struct {
+    const char *path;
+    uint32_t root;                    // Argument index, to keep argument order
+} WalkFile;
+
+typedef struct {
+    Arena arena;                      // Paths of files and queued directories
+    DirList list;
+    WalkFile *files;
+    size_t count, cap;
+    int failed;
+} Collector;
+
+typedef struct {
+    WalkFile *stack;                  // Directories waiting to be read
+    size_t count, cap;
+    int active;                       // Workers reading a directory
+    int failed;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+} DirQueue;
+
+typedef struct {
+    DirQueue *queue;
+    Collector out;
+} CollectWorker;
+
+static int add_file(Collector *c, const char *path, uint32_t root) {
+    if (c->count == c->cap) {
+        size_t cap = c->cap ? c->cap * 2 : 256;
+        WalkFile *grown = realloc(c->files, sizeof(WalkFile) * cap);
+        if (!grown) return -1;
+        c->files = grown;
+        c->cap = cap;
+    }
+    c->files[c->count].path = path;
+    c->files[c->count].root = root;
+    c->count++;
+    return 0;
+}
+
+static void queue_push(DirQueue *q, const WalkFile *dirs, size_t count) {
+    pthread_mutex_lock(&q->lock);
+    if (q->count + count > q->cap) {
+        size_t cap = q->cap * 2 > q->count + count ? q->cap * 2 : q->count + count;
+        WalkFile *grown = realloc(q->stack, sizeof(WalkFile) * cap);
+        if (grown) {
+            q->stack = grown;
+            q->cap = cap;
+        }
+    }
+    if (q->count + count <= q->cap) {
+        memcpy(q->stack + q->count, dirs, sizeof(WalkFile) * count);
+        q->count += count;
+    } else {
+        q->failed = 1;
+    }
+    pthread_cond_broadcast(&q->wake);
+    pthread_mutex_unlock(&q->lock);
+}
+
+// "dir/name", without a leading "./" for the working directory
+static char *join_path(Arena *arena, const char *dir, const char *name) {
+    size_t dir_len = strcmp(dir, ".") == 0 ? 0 : strlen(dir);
+    int slash = dir_len && dir[dir_len - 1] != '/';
+    size_t name_len = strlen(name);
+    char *path = arena_alloc(arena, dir_len + slash + name_len + 1);
+    if (!path) return NULL;
+    memcpy(path, dir, dir_len);
+    if (slash) path[dir_len] = '/';
+    memcpy(path + dir_len + slash, name, name_len + 1);
+    return path;
+}
+
+static void visit(DirQueue *q, Collector *c, const WalkFile *dir) {
+    if (dirlist_read(&c->list, dir->path) != 0) return;
+    WalkFile subdirs[256];
+    size_t pending = 0;
+    for (size_t i = 0; i < c->list.count; i++) {
+        const DirListEntry *e = &c->list.entries[i];
+        if (e->name[0] == '.' || (e->type != DT_REG && e->type != DT_DIR)) continue;
+        char *path = join_path(&c->arena, dir->path, e->name);
+        if (!path) {
+            c->failed = 1;
+            break;
+        }
+        if (e->type == DT_REG) {
+            if (add_file(c, path, dir->root) != 0) {
+                c->failed = 1;
+                break;
+            }
+            continue;
+        }
+        subdirs[pending].path = path;
+        subdirs[pending].root = dir->root;
+        if (++pending == 256) {
+            queue_push(q, subdirs, pending);
+            pending = 0;
+        }
+    }
+    if (pending) queue_push(q, subdirs, pending);
+}
+
+static void *collect_worker(void *arg) {
+    CollectWorker *w = arg;
+    DirQueue *q = w->queue;
+    for (;;) {
+        pthread_mutex_lock(&q->lock);
+        while (q->count == 0 && q->active > 0) pthread_cond_wait(&q->wake, &q->lock);
+        if (q->count == 0) {
+            // Nothing queued and nobody left to queue more
+            pthread_cond_broadcast(&q->wake);
+            pthread_mutex_unlock(&q->lock);
+            return NULL;
+        }
+        WalkFile dir = q->stack[--q->count];
+        q->active++;
+        pthread_mutex_unlock(&q->lock);
+
+        visit(q, &w->out, &dir);
+
+        pthread_mutex_lock(&q->lock);
+        q->active--;
+        if (w->out.failed) q->failed = 1;
+        if (q->count == 0 && q->active == 0) pthread_cond_broadcast(&q->wake);
+        pthread_mutex_unlock(&q->lock);
+    }
+}
+
+static int compare_files(const void *a, const void *b) {
+    const WalkFile *fa = a, *fb = b;
+    if (fa->root != fb->root) return fa->root < fb->root ? -1 : 1;
+    return strcmp(fa->path, fb->path);
+}
+
+// ============ Scanning ============
+
+typedef struct {
+    FileWalkOutput out;
+    long result;
+    int done;
+} FileResult;
+
+typedef struct {
+    const FileWalk *walk;
+    const WalkFile *files;
+    size_t count;
+    FileResult *results;
+    size_t next;                      // Next file to claim
+    size_t printing;                  // File the calling thread waits for
+    uint64_t scanned, binary, bytes;
+    pthread_mutex_t lock;
+    pthread_cond_t done;              // A result is ready
+    pthread_cond_t room;              // printing moved on
+} ScanJob;
+
+typedef struct {
+    char *data;
+    size_t cap;
+} ReadBuffer;
+
+// Read fd to EOF into buf; returns the length or -1
+static ssize_t read_all(int fd, ReadBuffer *buf, size_t hint) {
+    size_t len = 0;
+    for (;;) {
+        if (buf->cap - len < READ_CHUNK) {
+            size_t cap = buf->cap ? buf->cap * 2 : READ_CHUNK * 2;
+            while (cap < hint + READ_CHUNK) cap *= 2;
+            char *grown = realloc(buf->data, cap);
+            if (!grown) return -1;
+            buf->data = grown;
+            buf->cap = cap;
+        }
+        ssize_t n = read(fd, buf->data + len, buf->cap - len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) return -1;
+        if (n == 0) return (ssize_t)len;
+        len += n;
+    }
+}
+
+static void scan_file(ScanJob *job, size_t i, ReadBuffer *buf) {
+    const char *path = job->files[i].path;
+    FileResult *r = &job->results[i];
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        filewalk_printf(&r->out, "%s: %s: %s\n", job->walk->name, path, strerror(errno));
+        return;
+    }
+    struct stat st;
+    const char *data = NULL;
+    size_t len = 0;
+    void *map = MAP_FAILED;
+    int regular = fstat(fd, &st) == 0 && S_ISREG(st.st_mode);
+    if (regular && st.st_size >= FILEWALK_MMAP_MIN) {
+        map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED) {
+            madvise(map, st.st_size, MADV_SEQUENTIAL);
+            data = map;
+            len = st.st_size;
+        }
+    }
+    if (!data) {
+        ssize_t n = read_all(fd, buf, regular ? (size_t)st.st_size : 0);
+        if (n >= 0) {
+            data = buf->data;
+            len = n;
+        }
+    }
+    close(fd);
+
+    if (data && memchr(data, '\0', len < FILEWALK_BINARY_PROBE ? len : FILEWALK_BINARY_PROBE)) {
+        __atomic_add_fetch(&job->binary, 1, __ATOMIC_RELAXED);
+    } else if (data) {
+        r->result = job->walk->scan(path, data, len, &r->out, job->walk->ctx);
+        __atomic_add_fetch(&job->scanned, 1, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&job->bytes, len, __ATOMIC_RELAXED);
+    }
+    if (map != MAP_FAILED) munmap(map, st.st_size);
+}
+
+static void *scan_worker(void *arg) {
+    ScanJob *job = arg;
+    ReadBuffer buf = {NULL, 0};
+    pthread_mutex_lock(&job->lock);
+    for (;;) {
+        while (job->next < job->count && job->next >= job->printing + FILEWALK_WINDOW) {
+            pthread_cond_wait(&job->room, &job->lock);
+        }
+        if (job->next >= job->count) break;
+        size_t i = job->next++;
+        pthread_mutex_unlock(&job->lock);
+
+        scan_file(job, i, &buf);
+
+        pthread_mutex_lock(&job->lock);
+        job->results[i].done = 1;
+        if (i == job->printing) pthread_cond_signal(&job->done);
+    }
+    pthread_mutex_unlock(&job->lock);
+    free(buf.data);
+    return NULL;
+}
+
+static void print_result(FileResult *r) {
+    if (r->out.len) fwrite(r->out.data, 1, r->out.len, stdout);
+    free(r->out.data);
+    r->out.data = NULL;
+}
+
+// ============ Public API ============
+
+long filewalk_run(const FileWalk *walk, char **paths, int count, FileWalkStats *stats) {
+    double t0 = now_ms();
+    int threads = thread_count();
+
+    // Arguments: files directly, directories through the walk
+    DirQueue q;
+    memset(&q, 0, sizeof(q));
+    pthread_mutex_init(&q.lock, NULL);
+    pthread_cond_init(&q.wake, NULL);
+    CollectWorker *workers = calloc(threads, sizeof(CollectWorker));
+    if (!workers) {
+        fprintf(stderr, "%s: out of memory\n", walk->name);
+        return 0;
+    }
+    for (int i = 0; i < threads; i++) {
+        workers[i].queue = &q;
+        arena_init(&workers[i].out.arena);
+        dirlist_init(&workers[i].out.list);
+    }
+    for (int i = 0; i < count; i++) {
+        struct stat st;
+        if (stat(paths[i], &st) != 0) {
+            fprintf(stderr, "%s: %s: %s\n", walk->name, paths[i], strerror(errno));
+        } else if (!S_ISDIR(st.st_mode)) {
+            if (add_file(&workers[0].out, paths[i], i) != 0) workers[0].out.failed = 1;
+        } else if (!walk->recurse) {
+            fprintf(stderr, "%s: %s: Is a directory\n", walk->name, paths[i]);
+        } else {
+            WalkFile dir = {paths[i], (uint32_t)i};
+            queue_push(&q, &dir, 1);
+        }
+    }
+
+    pthread_t tids[FILEWALK_MAX_THREADS];
+    int started = 0;
+    if (q.count) {
+        for (int i = 1; i < threads; i++) {
+            if (pthread_create(&tids[started], NULL, collect_worker, &workers[i]) == 0) started++;
+        }
+        collect_worker(&workers[0]);
+        for (int i = 0; i < started; i++) pthread_join(tids[i], NULL);
+    }
+
+    size_t total = 0;
+    int failed = q.failed;
+    for (int i = 0; i < threads; i++) {
+        total += workers[i].out.count;
+        failed |= workers[i].out.failed;
+    }
+    WalkFile *files = malloc(sizeof(WalkFile) * (total ? total : 1));
+    FileResult *results = calloc(total ? total : 1, sizeof(FileResult));
+    if (!files || !results) failed = 1;
+    if (failed) fprintf(stderr, "%s: out of memory, some files were skipped\n", walk->name);
+
+    ScanJob job;
+    memset(&job, 0, sizeof(job));
+    long sum = 0;
+    if (files && results) {
+        size_t n = 0;
+        for (int i = 0; i < threads; i++) {
+            // A worker that found nothing has no array to copy from
+            if (workers[i].out.count == 0) continue;
+            memcpy(files + n, workers[i].out.files, sizeof(WalkFile) * workers[i].out.count);
+            n += workers[i].out.count;
+        }
+        qsort(files, total, sizeof(WalkFile), compare_files);
+
+        job.walk = walk;
+        job.files = files;
+        job.count = total;
+        job.results = results;
+        pthread_mutex_init(&job.lock, NULL);
+        pthread_cond_init(&job.done, NULL);
+        pthread_cond_init(&job.room, NULL);
+
+        // The calling thread prints while the workers scan; with one core
+        // it scans too, one file at a time
+        started = 0;
+        if (threads > 1 && total > 1) {
+            for (int i = 0; i < threads; i++) {
+                if (pthread_create(&tids[started], NULL, scan_worker, &job) == 0) started++;
+            }
+        }
+        ReadBuffer buf = {NULL, 0};
+        for (size_t i = 0; i < total; i++) {
+            if (started) {
+                pthread_mutex_lock(&job.lock);
+                job.printing = i;
+                pthread_cond_broadcast(&job.room);
+                while (!results[i].done) pthread_cond_wait(&job.done, &job.lock);
+                pthread_mutex_unlock(&job.lock);
+            } else {
+                scan_file(&job, i, &buf);
+            }
+            print_result(&results[i]);
+            sum += results[i].result;
+        }
+        for (int i = 0; i < started; i++) pthread_join(tids[i], NULL);
+        free(buf.data);
+        pthread_mutex_destroy(&job.lock);
+        pthread_cond_destroy(&job.done);
+        pthread_cond_destroy(&job.room);
+    }
+    fflush(stdout);
+
+    for (int i = 0; i < threads; i++) {
+        arena_free(&workers[i].out.arena);
+        dirlist_free(&workers[i].out.list);
+        free(workers[i].out.files);
+    }
+    free(workers);
+    free(files);
+    free(results);
+    free(q.stack);
+    pthread_mutex_destroy(&q.lock);
+    pthread_cond_destroy(&q.wake);
+
+    if (stats) {
+        stats->files = job.scanned;
+        stats->binary = job.binary;
+        stats->bytes = job.bytes;
+        stats->threads = started ? started : 1;
+        stats->elapsed_ms = now_ms() - t0;
+    }
+    return sum;
+}
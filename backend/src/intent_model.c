@@ -0,0 +1,213 @@
+/**
+ * Intent Model Implementation - Multinomial naive Bayes with feature hashing
+ * Training counts (bucket, intent) pairs, sorts them into compressed rows,
+ * and stores each as a log-likelihood boost over the intent's unseen-feature
+ * probability. Prediction sums the boosts from the input's rows only, each
+ * weighted by how few intents share the feature.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "intent_model.h"
+#include "nlp_pack.h"
+
+#define BUCKETS (1u << INTENT_FEATURE_BITS)
+#define MAX_FEATURES 192          // Per input: 3 features for each of 64 words
+#define PREFIX_LEN 4              // "listing", "lists" -> "list"
+#define PREFIX_SEED 0x5bd1e995u   // Keeps prefix hashes apart from word hashes
+#define SMOOTHING 1.0             // Laplace smoothing for feature counts
+
+// ============ Features ============
+
+static uint32_t fnv(uint32_t h, const char *s, int len) {
+    for (int i = 0; i < len; i++) {
+        h ^= (unsigned char)s[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// Determiners and fillers say nothing about the intent, and skipping them
+// lets "delete the folder" share the pair "delete folder"
+static int is_filler(const char *w) {
+    static const char *const fillers[] = {
+        "a", "an", "the", "this", "that", "these", "those", "my", "some", "please", "me", NULL
+    };
+    for (int i = 0; fillers[i]; i++) {
+        if (strcmp(w, fillers[i]) == 0) return 1;
+    }
+    return 0;
+}
+
+// Hash words, adjacent word pairs and word prefixes into buckets
+static int extract_features(const char *text, uint32_t *out) {
+    NLPToken tokens[MAX_FEATURES / 3];
+    int n = nlp_tokenize(text, tokens, MAX_FEATURES / 3);
+    int count = 0, kept = 0;
+    uint32_t prev = 0;
+    for (int i = 0; i < n; i++) {
+        const char *w = tokens[i].text;
+        if (is_filler(w)) continue;
+        int len = strlen(w);
+        uint32_t word = fnv(2166136261u, w, len);
+        out[count++] = word & (BUCKETS - 1);
+        if (len > PREFIX_LEN) {
+            out[count++] = fnv(PREFIX_SEED, w, PREFIX_LEN) & (BUCKETS - 1);
+        }
+        if (kept++ > 0) {
+            out[count++] = ((prev * 31u) ^ (word * 0x9e3779b1u)) & (BUCKETS - 1);
+        }
+        prev = word;
+    }
+    return count;
+}
+
+// ============ Training ============
+
+static int compare_keys(const void *a, const void *b) {
+    uint64_t ka = *(const uint64_t *)a, kb = *(const uint64_t *)b;
+    return ka < kb ? -1 : ka > kb;
+}
+
+int intent_model_train(IntentModel *model, const IntentExample *examples, int count, int intent_count) {
+    memset(model, 0, sizeof(*model));
+    if (intent_count <= 0) return 0;
+
+    // Every feature occurrence as a (bucket, intent) key
+    uint64_t *keys = malloc(sizeof(uint64_t) * ((size_t)count * MAX_FEATURES + 1));
+    double *totals = calloc(intent_count, sizeof(double));
+    model->unseen = malloc(sizeof(double) * intent_count);
+    model->row_start = calloc(BUCKETS + 1, sizeof(uint32_t));
+    if (!keys || !totals || !model->unseen || !model->row_start) {
+        free(keys);
+        free(totals);
+        intent_model_free(model);
+        return 0;
+    }
+
+    size_t key_count = 0;
+    for (int i = 0; i < count; i++) {
+        int c = examples[i].intent;
+        if (c < 0 || c >= intent_count) continue;
+        uint32_t features[MAX_FEATURES];
+        int n = extract_features(examples[i].text, features);
+        for (int f = 0; f < n; f++) keys[key_count++] = ((uint64_t)features[f] << 32) | (uint32_t)c;
+        totals[c] += n;
+    }
+    qsort(keys, key_count, sizeof(uint64_t), compare_keys);
+
+    // Collapse runs of equal keys into one weighted entry per (bucket, intent)
+    model->weights = malloc(sizeof(IntentWeight) * (key_count ? key_count : 1));
+    if (!model->weights) {
+        free(keys);
+        free(totals);
+        intent_model_free(model);
+        return 0;
+    }
+    uint32_t entries = 0, vocabulary = 0;
+    for (size_t i = 0; i < key_count;) {
+        size_t j = i;
+        while (j < key_count && keys[j] == keys[i]) j++;
+        uint32_t bucket = keys[i] >> 32;
+        model->weights[entries].intent = (uint32_t)keys[i];
+        model->weights[entries].boost = (float)log((j - i + SMOOTHING) / SMOOTHING);
+        if (model->row_start[bucket + 1]++ == 0) vocabulary++;
+        entries++;
+        i = j;
+    }
+    for (uint32_t b = 0; b < BUCKETS; b++) model->row_start[b + 1] += model->row_start[b];
+
+    // Priors are uniform: an intent with more pack phrases has more
+    // wordings, not more requests. Smoothing spreads over the buckets
+    // training used, so short intents are not drowned in empty buckets.
+    for (int c = 0; c < intent_count; c++) {
+        model->unseen[c] = log(SMOOTHING / (totals[c] + SMOOTHING * vocabulary));
+    }
+    model->intent_count = intent_count;
+
+    free(keys);
+    free(totals);
+    return 1;
+}
+
+// ============ Prediction ============
+
+int intent_model_predict(const IntentModel *model, const char *input, IntentScore *out, int max) {
+    if (!model->intent_count || !input || max <= 0) return 0;
+
+    double stack_scores[256];
+    double *scores = model->intent_count <= 256 ? stack_scores
+                                                : malloc(sizeof(double) * model->intent_count);
+    if (!scores) return 0;
+    for (int c = 0; c < model->intent_count; c++) scores[c] = 0;
+
+    // Features never seen in training carry no evidence either way. The
+    // rest count by inverse intent frequency: "file" or "folder", shared by
+    // many intents, say little about which one is meant.
+    uint32_t features[MAX_FEATURES];
+    int n = extract_features(input, features);
+    int known = 0;
+    double weight_sum = 0;
+    for (int f = 0; f < n; f++) {
+        uint32_t start = model->row_start[features[f]], end = model->row_start[features[f] + 1];
+        if (start == end) continue;
+        double weight = log(1.0 + (double)model->intent_count / (end - start));
+        known++;
+        weight_sum += weight;
+        for (uint32_t e = start; e < end; e++) {
+            scores[model->weights[e].intent] += weight * model->weights[e].boost;
+        }
+    }
+
+    int written = 0;
+    if (known > 0) {
+        double best = -INFINITY;
+        for (int c = 0; c < model->intent_count; c++) {
+            scores[c] += weight_sum * model->unseen[c];
+            if (scores[c] > best) best = scores[c];
+        }
+        double sum = 0;
+        for (int c = 0; c < model->intent_count; c++) {
+            scores[c] = exp(scores[c] - best);
+            sum += scores[c];
+        }
+
+        // Repeated selection; max is small
+        for (; written < max && written < model->intent_count; written++) {
+            int top = -1;
+            for (int c = 0; c < model->intent_count; c++) {
+                if (scores[c] >= 0 && (top < 0 || scores[c] > scores[top])) top = c;
+            }
+            out[written].intent = top;
+            out[written].probability = scores[top] / sum;
+            scores[top] = -1;
+        }
+    }
+
+    if (scores != stack_scores) free(scores);
+    return written;
+}
+
+double intent_model_coverage(const IntentModel *model, const char *input) {
+    if (!model->intent_count || !input) return 0;
+    NLPToken tokens[MAX_FEATURES / 3];
+    int n = nlp_tokenize(input, tokens, MAX_FEATURES / 3);
+    int words = 0, known = 0;
+    for (int i = 0; i < n; i++) {
+        const char *w = tokens[i].text;
+        if (is_filler(w)) continue;
+        uint32_t b = fnv(2166136261u, w, strlen(w)) & (BUCKETS - 1);
+        words++;
+        if (model->row_start[b] != model->row_start[b + 1]) known++;
+    }
+    return words ? (double)known / words : 0;
+}
+
+void intent_model_free(IntentModel *model) {
+    free(model->unseen);
+    free(model->row_start);
+    free(model->weights);
+    memset(model, 0, sizeof(*model));
+}
@@ -2,20 +2,28 @@
 #include <stdlib.h>
 #include <string.h>
 #include "macros.h"
-#include "utils.h"
+#include "arena.h"
 
 // Global state for macros
 static Macro *macro_list = NULL;
 static Macro *current_recording_macro = NULL;
+static Arena macro_arena;       // Backing storage for macros and their steps
+static StrPool macro_strings;   // Names and step commands; steps repeat often
 
 void init_macros() {
     macro_list = NULL;
     current_recording_macro = NULL;
+    arena_init(&macro_arena);
+    strpool_init_in(&macro_strings);
+}
+
+const char *macro_string(StrId id) {
+    return strpool_get_in(&macro_strings, id);
 }
 
 void start_recording_macro(const char *name) {
     if (current_recording_macro) {
-        printf("Error: Already recording macro '%s'.\n", current_recording_macro->name);
+        printf("Error: Already recording macro '%s'.\n", macro_string(current_recording_macro->name));
         return;
     }
     
@@ -25,8 +33,8 @@ void start_recording_macro(const char *name) {
         return;
     }
 
-    Macro *new_macro = malloc(sizeof(Macro));
-    new_macro->name = strdup_custom(name);
+    Macro *new_macro = arena_alloc(&macro_arena, sizeof(Macro));
+    new_macro->name = strpool_intern_in(&macro_strings, name);
     new_macro->head = NULL;
     new_macro->tail = NULL;
     new_macro->next = NULL;
@@ -39,8 +47,8 @@ void add_macro_step(const char *command) {
     if (!current_recording_macro) return;
     
     // Don't record the 'macro end' command itself, handled in main
-    MacroStep *step = malloc(sizeof(MacroStep));
-    step->command = strdup_custom(command);
+    MacroStep *step = arena_alloc(&macro_arena, sizeof(MacroStep));
+    step->command = strpool_intern_in(&macro_strings, command);
     step->next = NULL;
 
     if (current_recording_macro->tail) {
@@ -61,14 +69,14 @@ void end_recording_macro() {
     current_recording_macro->next = macro_list;
     macro_list = current_recording_macro;
     
-    printf("Macro '%s' saved.\n", current_recording_macro->name);
+    printf("Macro '%s' saved.\n", macro_string(current_recording_macro->name));
     current_recording_macro = NULL;
 }
 
 Macro *find_macro(const char *name) {
     Macro *curr = macro_list;
     while (curr) {
-        if (strcmp(curr->name, name) == 0) return curr;
+        if (strcmp(macro_string(curr->name), name) == 0) return curr;
         curr = curr->next;
     }
     return NULL;
@@ -97,18 +105,9 @@ int run_macro(const char *name) {
 }
 
 void free_macros() {
-    Macro *curr = macro_list;
-    while (curr) {
-        Macro *next = curr->next;
-        MacroStep *step = curr->head;
-        while (step) {
-            MacroStep *next_step = step->next;
-            free(step->command);
-            free(step);
-            step = next_step;
-        }
-        free(curr->name);
-        free(curr);
-        curr = next;
-    }
+    // Macros, steps and their strings live in two arenas; release both wholesale
+    arena_free(&macro_arena);
+    strpool_free_in(&macro_strings);
+    macro_list = NULL;
+    current_recording_macro = NULL;
 }
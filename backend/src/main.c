@@ -2,6 +2,8 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <limits.h>
+#include <sys/stat.h>
 
 #ifdef _WIN32
     #include <process.h>
@@ -12,6 +14,7 @@
 #endif
 
 #include "history.h"
+#include "strpool.h"
 #include "utils.h"
 #include "trie.h"
 #include "bktree.h"
@@ -82,6 +85,7 @@ int main() {
     
     setbuf(stdout, NULL); // Disable buffering for IPC
     
+    strpool_init();
     History *history = init_history(10);
     TrieNode *trie = create_node();
     BKTreeNode *bktree = NULL;
@@ -125,6 +129,7 @@ int main() {
     free_bktree(bktree);
     free_undo_stack(undo_stack);
     free_macros();
+    strpool_free();
 
     return 0;
 }
@@ -206,9 +211,9 @@ void execute_line(char *cmd, History *history, TrieNode *trie, BKTreeNode *bktre
                 printf("Running macro '%s'...\n", name);
                 MacroStep *step = m->head;
                 while (step) {
-                    printf(">> %s\n", step->command);
+                    printf(">> %s\n", macro_string(step->command));
                     char step_cmd[MAX_CMD_LEN];
-                    strcpy(step_cmd, step->command);
+                    strcpy(step_cmd, macro_string(step->command));
                     execute_line(step_cmd, history, trie, bktree, undo_stack);
                     step = step->next;
                 }
@@ -291,8 +296,14 @@ void execute_line(char *cmd, History *history, TrieNode *trie, BKTreeNode *bktre
         return; 
     }
     if (strcmp(args[0], "cp") == 0) { 
-        do_cp(args); 
-        if (args[2]) push_undo(undo_stack, cmd, UNDO_CP, args[2], NULL);
+        // Undo removes what a one-source copy created; a copy over an
+        // existing file can't be undone and isn't recorded
+        char target[PATH_MAX];
+        struct stat st;
+        int fresh = cp_target(args, target, sizeof(target)) == 0 && lstat(target, &st) != 0;
+        if (do_cp(args) == 0 && fresh && lstat(target, &st) == 0) {
+            push_undo(undo_stack, cmd, S_ISDIR(st.st_mode) ? UNDO_CP_DIR : UNDO_CP, target, NULL);
+        }
         return; 
     }
     if (strcmp(args[0], "mv") == 0) { 
@@ -11,10 +11,14 @@
 #include <ctype.h>
 #include <sys/wait.h>
 #include <signal.h>
+#include <errno.h>
+#include <limits.h>
+#include <sys/stat.h>
 
 #define PATH_SEP '/'
 
 #include "history.h"
+#include "strpool.h"
 #include "utils.h"
 #include "trie.h"
 #include "bktree.h"
@@ -22,9 +26,12 @@
 #include "macros.h"
 #include "commands.h"
 #include "nlp_engine.h"
+#include "nlp_pack.h"
+#include "nlp_batch.h"
 #include "suggestion_engine.h"
 #include "custom_commands.h"
 #include "sysmon_advanced.h"
+#include "builtin_commands.h"
 
 #define MAX_CMD_LEN 1024
 #define MAX_ARGS 64
@@ -37,7 +44,7 @@ int suggestion_mode = 1;  // Enable real-time suggestions by default
 // Forward declarations
 void execute_line(char *cmd, History *history, TrieNode *trie, BKTreeNode *bktree, UndoStack *undo_stack);
 void show_suggestions(const char *partial);
-void process_nlp_command(const char *input, char *output);
+void run_nlp_request(const char *input, History *history, TrieNode *trie, BKTreeNode *bktree, UndoStack *undo_stack);
 
 // ============ PROMPT AND INPUT ============
 
@@ -61,12 +68,42 @@ void read_command(char *cmd) {
     cmd[strcspn(cmd, "\n")] = 0;
 }
 
+// Frontend queries are answered inline: no prompt, no history entry
+int is_frontend_query(const char *cmd) {
+    return strncmp(cmd, "SUGGEST:", 8) == 0 || strncmp(cmd, "CONTEXT:", 8) == 0 ||
+           strncmp(cmd, "CLASSIFY:", 9) == 0 ||
+           strncmp(cmd, "INTENTS:", 8) == 0 || strncmp(cmd, "NLPBATCH:", 9) == 0;
+}
+
+// Split on spaces in place. '...' and "..." keep spaces in one argument;
+// a ' opens a quote only at the start of a word, so "what's" is one word.
+// A backslash escapes only a space or a quote (never inside '...'), so
+// patterns like a\.b and paths like C:\Users reach commands unchanged.
+// nlp_slots.c lexes requests by the same rules.
 void parse_command(char *cmd, char **args) {
     int i = 0;
-    char *token = strtok(cmd, " ");
-    while (token != NULL && i < MAX_ARGS - 1) {
-        args[i++] = token;
-        token = strtok(NULL, " ");
+    char *src = cmd, *dst = cmd;
+    while (*src && i < MAX_ARGS - 1) {
+        while (*src == ' ') src++;
+        if (!*src) break;
+        args[i++] = dst;
+        char *word = dst;
+        char quote = 0;
+        while (*src && (quote || *src != ' ')) {
+            if (quote && *src == quote) {
+                quote = 0;
+                src++;
+            } else if (!quote && (*src == '"' || (*src == '\'' && dst == word))) {
+                quote = *src++;
+            } else if (*src == '\\' && src[1] && quote != '\'' && strchr(quote ? "\"" : " '\"", src[1])) {
+                src++;
+                *dst++ = *src++;
+            } else {
+                *dst++ = *src++;
+            }
+        }
+        if (*src) src++;
+        *dst++ = '\0';
     }
     args[i] = NULL;
 }
@@ -91,9 +128,16 @@ void show_suggestions(const char *partial) {
 }
 
 // Handle SUGGEST command from frontend
+// An empty prefix asks for next-command predictions (ghost text); otherwise
+// matching commands come first, then phrases completing the input
 void handle_suggest_command(const char *partial) {
     SuggestionList cmd_suggestions;
-    suggestion_get_commands(partial, &cmd_suggestions);
+    if (partial[0] == '\0') {
+        suggestion_get_predictions(&cmd_suggestions);
+    } else {
+        suggestion_get_commands(partial, &cmd_suggestions);
+        nlp_complete_phrases(partial, &cmd_suggestions);
+    }
     
     printf("SUGGESTIONS:");
     for (int i = 0; i < cmd_suggestions.count; i++) {
@@ -120,16 +164,59 @@ void handle_context_suggest(const char *cmd, const char *partial) {
 
 // ============ NLP PROCESSING ============
 
-void process_nlp_command(const char *input, char *output) {
-    NLPResult result = nlp_translate(input);
+// Translate and run a natural-language request. A chained request
+// ("create folder build and go to it") runs its steps in order, like a macro.
+// A translation that is only a suggestion (NLP_SUGGESTED:) is shown, not run.
+void run_nlp_request(const char *input, History *history, TrieNode *trie, BKTreeNode *bktree, UndoStack *undo_stack) {
+    NLPResult steps[NLP_MAX_STEPS];
+    int count = nlp_translate_sequence(input, steps, NLP_MAX_STEPS);
+    int suggest_only = 0;
+    for (int i = 0; i < count; i++) suggest_only |= steps[i].suggest_only;
+    
+    if (count > 1 || steps[0].was_translated) {
+        char commands[MAX_CMD_LEN] = "", explanation[MAX_CMD_LEN] = "";
+        size_t clen = 0, elen = 0;
+        for (int i = 0; i < count; i++) {
+            clen += snprintf(commands + clen, clen < sizeof(commands) ? sizeof(commands) - clen : 0,
+                             "%s%s", i ? "; " : "", steps[i].translated);
+            elen += snprintf(explanation + elen, elen < sizeof(explanation) ? sizeof(explanation) - elen : 0,
+                             "%s%s", i ? ", then " : "", steps[i].explanation);
+        }
+        printf("%s:%s:%s\n", suggest_only ? "NLP_SUGGESTED" : "NLP_TRANSLATED", commands, explanation);
+        fflush(stdout);
+    }
+    if (suggest_only) return;
     
-    if (result.was_translated) {
-        strcpy(output, result.translated);
-        printf("NLP_TRANSLATED:%s:%s\n", result.translated, result.explanation);
-    } else {
-        strcpy(output, result.original);
+    for (int i = 0; i < count; i++) {
+        char step_cmd[MAX_CMD_LEN];
+        snprintf(step_cmd, sizeof(step_cmd), "%s", steps[i].translated);
+        if (count > 1) printf(">> %s\n", step_cmd);
+        execute_line(step_cmd, history, trie, bktree, undo_stack);
     }
+}
+
+// Translate a file of utterances and print one tab-separated line per item
+// (latency in us, command or "-", input), then a summary. prefix tags each
+// line for the frontend; the command line leaves it empty.
+int run_nlp_batch(const char *path, int threads, const char *prefix) {
+    NLPBatch batch;
+    if (nlp_batch_load(path, &batch) != 0) {
+        printf("%snlp-batch: %s: %s\n", prefix, path, strerror(errno));
+        return 1;
+    }
+    nlp_batch_run(&batch, threads);
+    
+    for (int i = 0; i < batch.count; i++) {
+        NLPBatchItem *item = &batch.items[i];
+        printf("%s%.1f\t%s\t%s\n", prefix, item->latency_us,
+               item->command ? item->command : "-", item->text);
+    }
+    printf("%s# %d utterances, %d translated, %d threads, %.1f ms, %.0f/s, p50 %.1f us, p99 %.1f us\n",
+           prefix, batch.count, batch.translated, batch.threads, batch.wall_ms,
+           batch.per_second, batch.p50_us, batch.p99_us);
     fflush(stdout);
+    nlp_batch_free(&batch);
+    return 0;
 }
 
 // ============ HELP SYSTEM ============
@@ -155,8 +242,8 @@ void show_help(char **args) {
     printf("│ rmdir <name>       - Remove empty directory                         │\n");
     printf("│ touch <file>       - Create file                                    │\n");
     printf("│ rm <file>          - Remove file                                    │\n");
-    printf("│ cat <file>         - Display file contents                          │\n");
-    printf("│ cp <src> <dst>     - Copy file                                      │\n");
+    printf("│ cat <file...>      - Display file contents                          │\n");
+    printf("│ cp [-r] <src> <d>  - Copy files or directory trees                  │\n");
     printf("│ mv <src> <dst>     - Move/rename file                               │\n");
     printf("│ echo <text>        - Print text                                     │\n");
     printf("└─────────────────────────────────────────────────────────────────────┘\n\n");
@@ -169,7 +256,7 @@ void show_help(char **args) {
     printf("│ head <file> [n]    - Show first n lines                             │\n");
     printf("│ tail <file> [n]    - Show last n lines                              │\n");
     printf("│ wc <file>          - Word/line/char count                           │\n");
-    printf("│ grep <pat> <file>  - Search pattern in file                         │\n");
+    printf("│ grep [-r] <re> [f] - Regex search (-i -v -c -n -F -A/-B/-C)         │\n");
     printf("│ sort <file> [-r]   - Sort lines                                     │\n");
     printf("│ uniq <file>        - Remove duplicate lines                         │\n");
     printf("│ rev <file>         - Reverse lines                                  │\n");
@@ -182,7 +269,9 @@ void show_help(char **args) {
     printf("│ encrypt <f> <key>  - Encrypt file with XOR cipher                   │\n");
     printf("│ decrypt <f> <key>  - Decrypt file                                   │\n");
     printf("│ sizeof <pattern>   - Total size of matching files                   │\n");
+    printf("│ dirtree [p] [-s N] - Tree with directory sizes (-d depth)           │\n");
     printf("│ age <days> [o|n]   - Find files older/newer than days               │\n");
+    printf("│ ff <query>         - Fuzzy find files anywhere below here           │\n");
     printf("│ freq <file> [n]    - Word frequency analysis                        │\n");
     printf("│ lines <file>       - Detailed line/word/char statistics             │\n");
     printf("│ quicknote          - Quick note taking (add/list/search/clear)      │\n");
@@ -255,10 +344,43 @@ void execute_line(char *cmd, History *history, TrieNode *trie, BKTreeNode *bktre
         return;
     }
     
+    // Live classification while typing: NL_CLASS:<is_nl>:<confidence>
+    if (strncmp(cmd, "CLASSIFY:", 9) == 0) {
+        double confidence = nlp_classify(cmd + 9);
+        printf("NL_CLASS:%d:%.2f\n", confidence >= NLP_NL_THRESHOLD, confidence);
+        return;
+    }
+    
+    // Likeliest intents from the model: INTENTS:<template>=<probability>|...
+    if (strncmp(cmd, "INTENTS:", 8) == 0) {
+        NLPIntentGuess guesses[3];
+        int count = nlp_rank_intents(cmd + 8, guesses, 3);
+        printf("INTENTS:");
+        for (int i = 0; i < count; i++) {
+            printf("%s%s=%.2f", i ? "|" : "", guesses[i].command_template, guesses[i].probability);
+        }
+        printf("\n");
+        return;
+    }
+    
+    // Replay a phrase file: NLP_BATCH:<latency>\t<command>\t<input> per item
+    if (strncmp(cmd, "NLPBATCH:", 9) == 0) {
+        run_nlp_batch(cmd + 9, 0, "NLP_BATCH:");
+        return;
+    }
+    
     if (strncmp(cmd, "NLP:", 4) == 0) {
-        char translated[MAX_CMD_LEN];
-        process_nlp_command(cmd + 4, translated);
-        strcpy(cmd, translated);
+        run_nlp_request(cmd + 4, history, trie, bktree, undo_stack);
+        return;
+    }
+    
+    // Raw line from the frontend; translate it only if it reads as NL
+    if (strncmp(cmd, "AUTO:", 5) == 0) {
+        if (nlp_is_natural_language(cmd + 5)) {
+            run_nlp_request(cmd + 5, history, trie, bktree, undo_stack);
+            return;
+        }
+        memmove(cmd, cmd + 5, strlen(cmd + 5) + 1);
     }
     
     // Empty command
@@ -324,9 +446,9 @@ void execute_line(char *cmd, History *history, TrieNode *trie, BKTreeNode *bktre
                 printf("Running macro '%s'...\n", action + 4);
                 MacroStep *step = m->head;
                 while (step) {
-                    printf(">> %s\n", step->command);
+                    printf(">> %s\n", macro_string(step->command));
                     char step_cmd[MAX_CMD_LEN];
-                    strcpy(step_cmd, step->command);
+                    strcpy(step_cmd, macro_string(step->command));
                     execute_line(step_cmd, history, trie, bktree, undo_stack);
                     step = step->next;
                 }
@@ -413,6 +535,12 @@ void execute_line(char *cmd, History *history, TrieNode *trie, BKTreeNode *bktre
     }
     if (strcmp(args[0], "stats") == 0) { 
         do_stats(args); 
+        NLPCacheStats cache;
+        nlp_cache_get_stats(&cache);
+        unsigned long lookups = cache.hits + cache.misses;
+        printf("NLP cache: %d/%d entries, %lu hits, %lu misses (%.1f%% hit rate), %lu evictions\n",
+               cache.entries, cache.capacity, cache.hits, cache.misses,
+               lookups ? 100.0 * cache.hits / lookups : 0.0, cache.evictions);
         return; 
     }
     if (strcmp(args[0], "bookmark") == 0) { 
@@ -454,8 +582,14 @@ void execute_line(char *cmd, History *history, TrieNode *trie, BKTreeNode *bktre
         return; 
     }
     if (strcmp(args[0], "cp") == 0) { 
-        do_cp(args); 
-        if (args[2]) push_undo(undo_stack, cmd, UNDO_CP, args[2], NULL);
+        // Undo removes what a one-source copy created; a copy over an
+        // existing file can't be undone and isn't recorded
+        char target[PATH_MAX];
+        struct stat st;
+        int fresh = cp_target(args, target, sizeof(target)) == 0 && lstat(target, &st) != 0;
+        if (do_cp(args) == 0 && fresh && lstat(target, &st) == 0) {
+            push_undo(undo_stack, cmd, S_ISDIR(st.st_mode) ? UNDO_CP_DIR : UNDO_CP, target, NULL);
+        }
         if (teaching_mode) explain_command("cp");
         return; 
     }
@@ -495,10 +629,19 @@ void execute_line(char *cmd, History *history, TrieNode *trie, BKTreeNode *bktre
         do_sizeof(args); 
         return; 
     }
+    if (strcmp(args[0], "dirtree") == 0) { 
+        do_dirtree(args); 
+        if (teaching_mode) explain_command("dirtree");
+        return; 
+    }
     if (strcmp(args[0], "age") == 0) { 
         do_age(args); 
         return; 
     }
+    if (strcmp(args[0], "ff") == 0) { 
+        do_ff(args); 
+        return; 
+    }
     if (strcmp(args[0], "freq") == 0) { 
         do_freq(args); 
         return; 
@@ -670,7 +813,28 @@ int main(int argc, char *argv[]) {
     setbuf(stdout, NULL);
     setbuf(stderr, NULL);
     
+    // Build step: compile a pattern source into a pack file
+    if (argc > 1 && strcmp(argv[1], "--compile-patterns") == 0) {
+        if (argc != 4) {
+            fprintf(stderr, "Usage: %s --compile-patterns <source.txt> <output.pack>\n", argv[0]);
+            return 1;
+        }
+        return nlp_pack_compile_file(argv[2], argv[3]) == 0 ? 0 : 1;
+    }
+    
+    // Replay logged phrases: translate a file across worker threads
+    if (argc > 1 && strcmp(argv[1], "--nlp-batch") == 0) {
+        int threads = 0;
+        if (argc == 5 && strcmp(argv[3], "-j") == 0) threads = atoi(argv[4]);
+        if (argc != 3 && !(argc == 5 && threads > 0)) {
+            fprintf(stderr, "Usage: %s --nlp-batch <file> [-j threads]\n", argv[0]);
+            return 1;
+        }
+        return run_nlp_batch(argv[2], threads, "");
+    }
+    
     // Initialize data structures
+    strpool_init();
     History *history = init_history(100);
     TrieNode *trie = create_node();
     BKTreeNode *bktree = NULL;
@@ -682,20 +846,9 @@ int main(int argc, char *argv[]) {
     suggestion_init();
     
     // Populate trie and bktree with all commands
-    const char *commands[] = {
-        "ls", "pwd", "cd", "mkdir", "rmdir", "touch", "rm", "cat", "cp", "mv",
-        "echo", "tree", "search", "backup", "compare", "stats", "sysmon",
-        "bookmark", "recent", "bulk_rename", "help", "history", "exit", "clear",
-        "fileinfo", "hexdump", "duplicate", "encrypt", "decrypt", "sizeof",
-        "age", "freq", "lines", "quicknote", "calc", "head", "tail", "wc",
-        "grep", "sort", "uniq", "rev", "date", "whoami", "hostname", "uptime",
-        "df", "ps", "kill", "undo", "macro", "teach"
-    };
-    int num_commands = sizeof(commands) / sizeof(commands[0]);
-    
-    for (int i = 0; i < num_commands; i++) {
-        insert_trie(trie, commands[i]);
-        insert_bktree(&bktree, commands[i]);
+    for (int i = 0; i < num_builtin_commands; i++) {
+        insert_trie(trie, builtin_commands[i]);
+        insert_bktree(&bktree, builtin_commands[i]);
     }
     
     // Check for batch mode
@@ -708,13 +861,22 @@ int main(int argc, char *argv[]) {
         execute_line(cmd, history, trie, bktree, undo_stack);
     } else {
         // Interactive mode
+        int show_prompt = 1;
         while (1) {
-            type_prompt();
+            if (show_prompt) type_prompt();
             read_command(cmd);
+            show_prompt = 1;
             
             if (strlen(cmd) == 0) continue;
             
-            add_history(history, cmd);
+            if (is_frontend_query(cmd)) {
+                execute_line(cmd, history, trie, bktree, undo_stack);
+                show_prompt = 0;
+                continue;
+            }
+            
+            // History keeps what the user typed, not the routing prefix
+            add_history(history, strncmp(cmd, "AUTO:", 5) == 0 ? cmd + 5 : cmd);
             execute_line(cmd, history, trie, bktree, undo_stack);
         }
     }
@@ -724,6 +886,7 @@ int main(int argc, char *argv[]) {
     free_bktree(bktree);
     free_undo_stack(undo_stack);
     free_macros();
+    strpool_free();
     
     return 0;
 }
@@ -0,0 +1,170 @@
+/**
+ * N-gram Predictor Implementation
+ * Trigram and bigram contexts map to a fixed-size candidate list in an
+ * open-addressing hash table, so each prediction is a constant number of
+ * probes. Candidate lists use space-saving replacement to stay bounded.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "ngram.h"
+
+#define NGRAM_INITIAL_SLOTS 256
+#define NGRAM_EMPTY_KEY 0  // Contexts always contain a non-zero id
+
+typedef struct {
+    StrId next;
+    uint32_t count;
+} NgramCandidate;
+
+typedef struct {
+    uint64_t key;
+    NgramCandidate cand[NGRAM_CANDIDATES];
+} NgramSlot;
+
+typedef struct {
+    NgramSlot *slots;
+    uint32_t size;   // Power of two
+    uint32_t used;
+} NgramTable;
+
+static NgramTable bigrams;   // key = prev1
+static NgramTable trigrams;  // key = prev2 << 32 | prev1
+static StrId prev1 = STR_NONE;
+static StrId prev2 = STR_NONE;
+
+// ============ Hash Table ============
+
+static uint32_t hash_key(uint64_t key) {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    return (uint32_t)key;
+}
+
+static void table_init(NgramTable *t) {
+    t->slots = calloc(NGRAM_INITIAL_SLOTS, sizeof(NgramSlot));
+    t->size = t->slots ? NGRAM_INITIAL_SLOTS : 0;
+    t->used = 0;
+}
+
+static NgramSlot *table_find(NgramTable *t, uint64_t key) {
+    if (!t->size) return NULL;
+    uint32_t i = hash_key(key) & (t->size - 1);
+    while (t->slots[i].key != NGRAM_EMPTY_KEY) {
+        if (t->slots[i].key == key) return &t->slots[i];
+        i = (i + 1) & (t->size - 1);
+    }
+    return NULL;
+}
+
+static void table_grow(NgramTable *t) {
+    uint32_t new_size = t->size * 2;
+    NgramSlot *new_slots = calloc(new_size, sizeof(NgramSlot));
+    if (!new_slots) return;
+
+    for (uint32_t i = 0; i < t->size; i++) {
+        if (t->slots[i].key == NGRAM_EMPTY_KEY) continue;
+        uint32_t j = hash_key(t->slots[i].key) & (new_size - 1);
+        while (new_slots[j].key != NGRAM_EMPTY_KEY) j = (j + 1) & (new_size - 1);
+        new_slots[j] = t->slots[i];
+    }
+    free(t->slots);
+    t->slots = new_slots;
+    t->size = new_size;
+}
+
+static NgramSlot *table_find_or_insert(NgramTable *t, uint64_t key) {
+    NgramSlot *slot = table_find(t, key);
+    if (slot || !t->size) return slot;
+
+    if ((t->used + 1) * 10 > t->size * 7) table_grow(t);
+    uint32_t i = hash_key(key) & (t->size - 1);
+    while (t->slots[i].key != NGRAM_EMPTY_KEY) i = (i + 1) & (t->size - 1);
+    t->slots[i].key = key;
+    t->used++;
+    return &t->slots[i];
+}
+
+// Count one occurrence of next after this context, keeping candidates sorted
+static void slot_record(NgramSlot *slot, StrId next) {
+    NgramCandidate *c = slot->cand;
+    int i;
+    for (i = 0; i < NGRAM_CANDIDATES; i++) {
+        if (c[i].next == next || c[i].next == STR_NONE) break;
+    }
+    if (i == NGRAM_CANDIDATES) {
+        // Space-saving: evict the weakest candidate but inherit its count
+        i = NGRAM_CANDIDATES - 1;
+        c[i].next = next;
+    } else if (c[i].next == STR_NONE) {
+        c[i].next = next;
+    }
+    c[i].count++;
+
+    while (i > 0 && c[i].count > c[i - 1].count) {
+        NgramCandidate tmp = c[i];
+        c[i] = c[i - 1];
+        c[i - 1] = tmp;
+        i--;
+    }
+}
+
+// ============ Public API ============
+
+void ngram_init(void) {
+    ngram_free();
+    table_init(&bigrams);
+    table_init(&trigrams);
+}
+
+void ngram_observe(const char *cmd) {
+    if (!cmd || !*cmd) return;
+    StrId id = strpool_intern(cmd);
+    if (id == STR_NONE) return;
+
+    if (prev1 != STR_NONE) {
+        NgramSlot *slot = table_find_or_insert(&bigrams, prev1);
+        if (slot) slot_record(slot, id);
+    }
+    if (prev2 != STR_NONE) {
+        NgramSlot *slot = table_find_or_insert(&trigrams, ((uint64_t)prev2 << 32) | prev1);
+        if (slot) slot_record(slot, id);
+    }
+    prev2 = prev1;
+    prev1 = id;
+}
+
+int ngram_predict(StrId *out, int max) {
+    int n = 0;
+    if (prev1 == STR_NONE || max <= 0) return 0;
+
+    // Trigram context first, then back off to the bigram
+    NgramSlot *sources[2] = {
+        prev2 != STR_NONE ? table_find(&trigrams, ((uint64_t)prev2 << 32) | prev1) : NULL,
+        table_find(&bigrams, prev1)
+    };
+
+    for (int s = 0; s < 2; s++) {
+        if (!sources[s]) continue;
+        for (int i = 0; i < NGRAM_CANDIDATES && n < max; i++) {
+            StrId next = sources[s]->cand[i].next;
+            if (next == STR_NONE) break;
+
+            int seen = 0;
+            for (int k = 0; k < n; k++) {
+                if (out[k] == next) { seen = 1; break; }
+            }
+            if (!seen) out[n++] = next;
+        }
+    }
+    return n;
+}
+
+void ngram_free(void) {
+    free(bigrams.slots);
+    free(trigrams.slots);
+    memset(&bigrams, 0, sizeof(bigrams));
+    memset(&trigrams, 0, sizeof(trigrams));
+    prev1 = prev2 = STR_NONE;
+}
@@ -0,0 +1,165 @@
+/**
+ * NLP Batch Implementation - Parallel replay of utterance files
+ * Workers claim small chunks of items from a shared counter, so slow
+ * items do not leave other threads idle. Results are stored per item and
+ * reported in file order.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "nlp_batch.h"
+#include "nlp_engine.h"
+
+#define CLAIM_CHUNK 16           // Items taken per claim
+
+typedef struct {
+    NLPBatch *batch;
+    int next;                    // Next unclaimed item, advanced atomically
+} BatchQueue;
+
+static double now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+// ============ Loading ============
+
+int nlp_batch_load(const char *path, NLPBatch *batch) {
+    memset(batch, 0, sizeof(*batch));
+    FILE *fp = fopen(path, "r");
+    if (!fp) return -1;
+
+    size_t cap = 4096, len = 0;
+    char *text = malloc(cap);
+    size_t n;
+    while (text && (n = fread(text + len, 1, cap - len - 1, fp)) > 0) {
+        len += n;
+        if (len + 1 == cap) {
+            char *grown = realloc(text, cap * 2);
+            if (!grown) {
+                free(text);
+                text = NULL;
+                break;
+            }
+            text = grown;
+            cap *= 2;
+        }
+    }
+    int failed = !text || ferror(fp);
+    fclose(fp);
+    if (failed) {
+        free(text);
+        errno = ENOMEM;
+        return -1;
+    }
+    text[len] = '\0';
+
+    int lines = 1;
+    for (size_t i = 0; i < len; i++) lines += text[i] == '\n';
+    batch->items = calloc(lines, sizeof(NLPBatchItem));
+    if (!batch->items) {
+        free(text);
+        errno = ENOMEM;
+        return -1;
+    }
+    batch->text = text;
+
+    for (char *line = text; line && *line;) {
+        char *end = strchr(line, '\n');
+        if (end) *end = '\0';
+        size_t l = strlen(line);
+        if (l && line[l - 1] == '\r') line[--l] = '\0';
+        while (*line == ' ' || *line == '\t') line++;
+        if (*line && *line != '#') batch->items[batch->count++].text = line;
+        line = end ? end + 1 : NULL;
+    }
+    return 0;
+}
+
+// ============ Running ============
+
+static void *batch_worker(void *arg) {
+    BatchQueue *queue = arg;
+    NLPBatch *batch = queue->batch;
+    int start;
+    while ((start = __atomic_fetch_add(&queue->next, CLAIM_CHUNK, __ATOMIC_RELAXED)) < batch->count) {
+        int end = start + CLAIM_CHUNK < batch->count ? start + CLAIM_CHUNK : batch->count;
+        for (int i = start; i < end; i++) {
+            NLPBatchItem *item = &batch->items[i];
+            double t0 = now_us();
+            NLPResult result = nlp_translate(item->text);
+            item->latency_us = now_us() - t0;
+            if (result.was_translated) {
+                item->command = strdup(result.translated);
+                item->confidence = result.confidence;
+            }
+        }
+    }
+    return NULL;
+}
+
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return x < y ? -1 : x > y;
+}
+
+// Nearest-rank percentile over sorted values
+static double percentile(const double *sorted, int count, double p) {
+    int rank = (int)(p * count + 0.999999);
+    if (rank < 1) rank = 1;
+    if (rank > count) rank = count;
+    return sorted[rank - 1];
+}
+
+void nlp_batch_run(NLPBatch *batch, int threads) {
+    if (threads <= 0) threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads < 1) threads = 1;
+    if (threads > NLP_BATCH_MAX_THREADS) threads = NLP_BATCH_MAX_THREADS;
+    if (threads > batch->count) threads = batch->count > 0 ? batch->count : 1;
+    batch->threads = threads;
+
+    // Load tables before timing, so the first items do not pay for it
+    nlp_init();
+
+    BatchQueue queue = {batch, 0};
+    pthread_t workers[NLP_BATCH_MAX_THREADS];
+    int started = 0;
+    double t0 = now_us();
+    for (int i = 1; i < threads; i++) {
+        if (pthread_create(&workers[started], NULL, batch_worker, &queue) == 0) started++;
+    }
+    batch_worker(&queue);
+    for (int i = 0; i < started; i++) pthread_join(workers[i], NULL);
+    batch->wall_ms = (now_us() - t0) / 1e3;
+    batch->threads = started + 1;
+
+    batch->translated = 0;
+    batch->per_second = batch->wall_ms > 0 ? batch->count / (batch->wall_ms / 1e3) : 0;
+    batch->p50_us = batch->p99_us = 0;
+    if (batch->count == 0) return;
+
+    double *latencies = malloc(sizeof(double) * batch->count);
+    for (int i = 0; i < batch->count; i++) {
+        batch->translated += batch->items[i].command != NULL;
+        if (latencies) latencies[i] = batch->items[i].latency_us;
+    }
+    if (latencies) {
+        qsort(latencies, batch->count, sizeof(double), compare_doubles);
+        batch->p50_us = percentile(latencies, batch->count, 0.50);
+        batch->p99_us = percentile(latencies, batch->count, 0.99);
+        free(latencies);
+    }
+}
+
+void nlp_batch_free(NLPBatch *batch) {
+    for (int i = 0; i < batch->count; i++) free(batch->items[i].command);
+    free(batch->items);
+    free(batch->text);
+    memset(batch, 0, sizeof(*batch));
+}
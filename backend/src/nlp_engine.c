@@ -7,161 +7,274 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <math.h>
+#include <stdint.h>
+#include <limits.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
 #include "nlp_engine.h"
+#include "nlp_pack.h"
+#include "intent_model.h"
+#include "nlp_slots.h"
+#include "phrase_index.h"
 
 // ============ Pattern Definitions ============
 
-typedef struct {
-    const char *patterns[10];  // Multiple patterns that match
-    int pattern_count;
-    const char *command_template;
-    const char *explanation;
-} NLPPattern;
-
-// All supported NLP patterns
-static NLPPattern nlp_patterns[] = {
+// Phrase list literal plus its length, for NLPIntentDef initializers
+#define PHRASES(...) (const char *const[]){__VA_ARGS__}, \
+    sizeof((const char *const[]){__VA_ARGS__}) / sizeof(const char *)
+
+// Built-in patterns, used when no pattern pack file is installed.
+// data/nlp_patterns.txt is the pack source with the same intents.
+// Phrases use canonical words only; builtin_synonyms covers the rest.
+static const NLPIntentDef builtin_intents[] = {
     // Show/List files
-    {{"show files", "list files", "display files", "show all files", "list all files", 
-      "what files", "see files", "view files"}, 8, 
+    {PHRASES("show files", "show all files", "what files"),
      "ls", "Listing files in current directory"},
     
     // Show directory tree
-    {{"show tree", "display tree", "directory tree", "show directory tree", "folder structure"}, 5,
+    {PHRASES("show tree", "folder tree", "show folder tree", "folder structure"),
      "tree", "Displaying directory tree structure"},
     
     // Current directory
-    {{"where am i", "current directory", "current path", "current location", 
-      "show directory", "print directory", "what directory", "pwd"}, 8,
+    {PHRASES("where am i", "current folder", "current path", "current location", "show folder",
+      "what folder", "pwd"),
      "pwd", "Showing current working directory"},
     
     // Create directory
-    {{"create folder", "make folder", "new folder", "create directory", 
-      "make directory", "new directory", "mkdir"}, 7,
+    {PHRASES("create folder", "new folder", "mkdir"),
      "mkdir %s", "Creating new directory"},
     
     // Create file
-    {{"create file", "make file", "new file", "touch file", "create new file"}, 5,
+    {PHRASES("create file", "new file", "touch file", "create new file"),
      "touch %s", "Creating new file"},
     
     // Delete file
-    {{"delete file", "remove file", "erase file", "delete the file", "rm file"}, 5,
+    {PHRASES("delete file", "delete the file"),
      "rm %s", "Removing file"},
     
     // Delete directory
-    {{"delete folder", "remove folder", "delete directory", "remove directory", 
-      "erase folder", "rmdir"}, 6,
+    {PHRASES("delete folder", "rmdir"),
      "rmdir %s", "Removing directory"},
     
     // Copy file
-    {{"copy file", "duplicate file", "copy the file", "make copy of"}, 4,
+    {PHRASES("copy file", "duplicate file", "copy the file", "create copy of"),
      "cp %s %s", "Copying file"},
     
     // Move/Rename file
-    {{"move file", "rename file", "move the file", "rename the file", "relocate"}, 5,
+    {PHRASES("move file", "rename file", "move the file", "rename the file", "relocate"),
      "mv %s %s", "Moving/renaming file"},
     
     // Read file
-    {{"read file", "show file", "display file", "print file", "view file", 
-      "cat file", "show contents", "what is in", "whats in"}, 9,
+    {PHRASES("read file", "show file", "cat file", "show contents", "what is in", "whats in"),
      "cat %s", "Displaying file contents"},
     
     // Search
-    {{"search for", "find text", "look for", "search text", "grep for"}, 5,
+    {PHRASES("search for", "search text"),
      "search %s", "Searching for pattern"},
     
     // Change directory
-    {{"go to", "change to", "navigate to", "switch to", "cd to", "enter folder", "enter directory"}, 7,
+    {PHRASES("go to", "change to", "go into", "cd to", "enter folder"),
      "cd %s", "Changing directory"},
     
     // Go back
-    {{"go back", "go up", "parent directory", "go to parent", "cd .."}, 5,
+    {PHRASES("go back", "go up", "parent folder", "go to parent", "cd .."),
      "cd ..", "Going to parent directory"},
     
     // Go home
-    {{"go home", "home directory", "cd home", "go to home"}, 4,
+    {PHRASES("go home", "home folder", "cd home", "go to home"),
      "cd ~", "Going to home directory"},
     
     // System monitor
-    {{"system monitor", "show system", "system info", "system status", 
-      "resource monitor", "show resources", "cpu usage", "memory usage"}, 8,
+    {PHRASES("system monitor", "show system", "system info", "system status", "resource monitor",
+      "show resources", "cpu usage", "memory usage"),
      "sysmon", "Opening system resource monitor"},
     
     // Help
-    {{"help", "show help", "help me", "what commands", "available commands", "show commands"}, 6,
+    {PHRASES("help", "show help", "help me", "what commands", "available commands", "show commands"),
      "help", "Showing available commands"},
     
     // History
-    {{"show history", "command history", "previous commands", "history"}, 4,
+    {PHRASES("show history", "command history", "previous commands", "history"),
      "history", "Showing command history"},
     
     // Clear screen
-    {{"clear screen", "clear terminal", "cls", "clear"}, 4,
+    {PHRASES("clear screen", "clear"),
      "clear", "Clearing the screen"},
     
     // Recent files
-    {{"recent files", "show recent", "recently modified", "new files"}, 4,
+    {PHRASES("recent files", "show recent", "recently modified", "new files"),
      "recent", "Showing recently modified files"},
     
     // Backup
-    {{"backup file", "create backup", "save backup", "backup"}, 4,
+    {PHRASES("backup file", "create backup", "save backup", "backup"),
      "backup %s", "Creating file backup"},
     
     // Compare files
-    {{"compare files", "diff files", "check difference", "compare"}, 4,
+    {PHRASES("compare files", "check difference", "compare"),
      "compare %s %s", "Comparing two files"},
     
     // File info
-    {{"file info", "file details", "file information", "info about"}, 4,
+    {PHRASES("file info", "info about"),
      "fileinfo %s", "Showing detailed file information"},
     
     // Find duplicates
-    {{"find duplicates", "duplicate files", "find duplicate"}, 3,
+    {PHRASES("search duplicate", "duplicate files"),
      "duplicate", "Finding duplicate files"},
     
     // Word count
-    {{"count words", "word count", "count lines", "line count", "wc"}, 5,
+    {PHRASES("count word", "word count", "count line", "line count", "wc"),
      "wc %s", "Counting words/lines in file"},
     
     // Head/Tail
-    {{"first lines", "show first", "head of file", "beginning of"}, 4,
+    {PHRASES("first line", "show first", "head of file", "beginning of"),
      "head %s", "Showing first lines of file"},
     
-    {{"last lines", "show last", "tail of file", "end of"}, 4,
+    {PHRASES("last line", "show last", "tail of file", "end of"),
      "tail %s", "Showing last lines of file"},
     
     // Date/Time
-    {{"current time", "what time", "show time", "current date", "show date", "date and time"}, 6,
+    {PHRASES("current time", "what time", "show time", "current date", "show date", "date and time"),
      "date", "Showing current date and time"},
     
     // User info
-    {{"who am i", "current user", "my username", "whoami"}, 4,
+    {PHRASES("who am i", "current user", "my username", "whoami"),
      "whoami", "Showing current user"},
     
     // Disk space
-    {{"disk space", "free space", "storage space", "disk usage", "df"}, 5,
+    {PHRASES("disk space", "free space", "disk usage", "df"),
      "df", "Showing disk space usage"},
     
     // Process list
-    {{"running processes", "list processes", "show processes", "process list", "ps"}, 5,
+    {PHRASES("running process", "show process", "process show", "ps"),
      "ps", "Listing running processes"},
     
     // Calculator
-    {{"calculate", "calc", "compute", "math"}, 4,
+    {PHRASES("calculate", "math"),
      "calc %s", "Calculating expression"},
     
     // Notes
-    {{"add note", "quick note", "save note", "take note"}, 4,
+    {PHRASES("add note", "quick note", "save note", "take note"),
      "quicknote add %s", "Adding a quick note"},
     
-    {{"show notes", "list notes", "my notes"}, 3,
+    {PHRASES("show note", "my note"),
      "quicknote list", "Showing saved notes"},
     
     // Exit
-    {{"exit", "quit", "close", "bye", "goodbye"}, 5,
+    {PHRASES("exit", "close"),
      "exit", "Exiting the shell"},
 };
 
-static int num_patterns = sizeof(nlp_patterns) / sizeof(nlp_patterns[0]);
+static const int num_builtin_intents = sizeof(builtin_intents) / sizeof(builtin_intents[0]);
+
+// Synonym and inflection list compiled with the built-in patterns. Regular
+// plurals need no entry: translation looks up each plural's stem.
+#define SYNONYMS(canonical, ...) \
+    {canonical, (const char *const[]){__VA_ARGS__}, \
+     sizeof((const char *const[]){__VA_ARGS__}) / sizeof(const char *)}
+
+static const struct {
+    const char *canonical;
+    const char *const *words;
+    int count;
+} builtin_synonyms[] = {
+    SYNONYMS("folder", "directory", "dir"),
+    SYNONYMS("delete", "remove", "erase", "rm", "del", "deleting", "removing", "erasing",
+             "deleted", "removed"),
+    SYNONYMS("create", "make", "creating", "making", "created"),
+    SYNONYMS("show", "display", "list", "view", "see", "print", "showing", "displaying",
+             "listing", "viewing"),
+    SYNONYMS("go", "navigate", "switch", "going"),
+    SYNONYMS("search", "find", "look", "grep", "searching", "finding", "looking"),
+    SYNONYMS("copy", "copying", "copied"),
+    SYNONYMS("move", "moving", "moved"),
+    SYNONYMS("info", "information", "details", "detail"),
+    SYNONYMS("screen", "terminal"),
+    SYNONYMS("clear", "cls"),
+    SYNONYMS("compare", "diff", "comparing"),
+    SYNONYMS("disk", "storage"),
+    SYNONYMS("calculate", "calc", "compute", "calculating"),
+    SYNONYMS("exit", "quit", "bye", "goodbye"),
+};
+
+static const int num_builtin_synonyms = sizeof(builtin_synonyms) / sizeof(builtin_synonyms[0]);
+
+// ============ Pattern Packs ============
+
+#define MAX_INPUT_TOKENS 64
+#define PHRASE_MAP_SIZE 1024     // Candidate phrases scored per call (power of two)
+#define SCATTERED_FACTOR 0.75    // Score penalty when phrase words are not adjacent
+#define STEMMED_FACTOR 0.9       // ... and when some only matched as a plural's stem
+#define PACK_POLL_INTERVAL 1     // Seconds between checks of the pack file
+#define DEFAULT_PACK_FILE "data/nlp_patterns.pack"  // Relative to the executable
+#define CORPUS_FILE ".nlp_intents"  // Extra training phrases, in $HOME
+#define MODEL_MIN_NL 0.75        // Only clearly-NL input falls back to the model
+#define MODEL_MIN_PROB 0.5       // Posterior needed to act on the model's guess
+#define MODEL_MIN_MARGIN 0.3     // ... and its lead over the runner-up
+#define MODEL_MIN_COVERAGE 0.4   // Share of input words the model was trained on
+
+// Per-call score accumulator for one candidate phrase
+typedef struct {
+    int32_t phrase;              // -1 = empty slot
+    uint32_t mask;               // Phrase positions covered by input tokens
+    uint32_t stem_mask;          // ... and by the stems of plural input words
+    int contiguous;              // Phrase appeared as an exact word run
+    uint32_t words;              // Phrase length in words
+    double weight;               // Phrase weight from the pack
+} PhraseScore;
+
+// A pack and the intent model trained from it, replaced as a unit.
+// Callers hold a reference for the duration of one call, so a reload
+// never frees tables still being read.
+typedef struct {
+    NLPPack *pack;
+    IntentModel model;
+    PhraseIndex *completions;    // Over the normalized phrases; use counts change
+    int refs;
+    uint32_t generation;         // Tags cache entries ranked against it
+} NLPTables;
+
+static NLPTables *active_tables = NULL;
+static pthread_mutex_t pack_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t poll_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t completion_lock = PTHREAD_MUTEX_INITIALIZER;  // Guards use counts
+static char pack_path[PATH_MAX];
+static struct stat pack_stat;    // Identity of the file last loaded or rejected
+static time_t pack_checked = 0;
+
+// ============ Translation Cache ============
+
+#define NLP_CACHE_SIZE 256          // Entries kept before evicting the LRU one
+#define NLP_CACHE_BUCKETS 512       // Hash buckets (power of two)
+#define NLP_CACHE_MAX_TOKENS 16     // Longer inputs bypass the cache
+#define NLP_CACHE_CANDIDATES 4      // Ranked phrases remembered per entry
+
+// Keyed by the input's token ids with non-pattern words as 0, so "create
+// folder called foo" and "create folder called bar" share one entry,
+// followed by the stem ids. The value is the ranked phrase list;
+// arguments are re-extracted on every hit.
+typedef struct {
+    uint32_t hash;
+    uint32_t generation;         // Tables whose phrase ids these are
+    int token_count;             // Key length, twice the input's words
+    uint32_t ids[NLP_CACHE_MAX_TOKENS * 2];
+    int candidates[NLP_CACHE_CANDIDATES];
+    double confidence[NLP_CACHE_CANDIDATES];
+    int candidate_count;
+    int truncated;               // More candidates existed than were kept
+    int prev, next;              // LRU list, most recent at head
+    int chain;                   // Next entry in the same bucket
+} NLPCacheEntry;
+
+static NLPCacheEntry cache_entries[NLP_CACHE_SIZE];
+static int cache_buckets[NLP_CACHE_BUCKETS];
+static int cache_head = -1, cache_tail = -1;
+static int cache_count = 0;
+static NLPCacheStats cache_stats;
+static uint32_t tables_generation = 0;
+static pthread_mutex_t cache_lock = PTHREAD_MUTEX_INITIALIZER;  // After pack_lock
 
 // ============ Available Commands List ============
 
@@ -170,7 +283,7 @@ static const char *available_commands[] = {
     "echo", "tree", "search", "backup", "compare", "stats", "sysmon",
     "bookmark", "recent", "bulk_rename", "help", "history", "exit", "clear",
     "watch", "fileinfo", "dirtree", "duplicate", "encrypt", "decrypt",
-    "hexdump", "sizeof", "age", "monitor", "freq", "lines", "template",
+    "hexdump", "sizeof", "age", "ff", "monitor", "freq", "lines", "template",
     "snap", "quicknote", "calc", "env", "alias", "procinfo", "netstat",
     "memmap", "jsoncat", "tail_live", "head", "tail", "wc", "grep",
     "sort", "uniq", "rev", "date", "whoami", "hostname", "uptime", "df",
@@ -187,173 +300,1021 @@ static void str_to_lower(char *str) {
     }
 }
 
-// Trim whitespace from both ends
-static char* str_trim(char *str) {
-    while (isspace((unsigned char)*str)) str++;
-    if (*str == 0) return str;
-    
-    char *end = str + strlen(str) - 1;
-    while (end > str && isspace((unsigned char)*end)) end--;
-    end[1] = '\0';
-    
-    return str;
-}
-
-// Check if string contains substring
-static int str_contains(const char *haystack, const char *needle) {
-    return strstr(haystack, needle) != NULL;
-}
-
-// Extract argument after a keyword (e.g., "called test" returns "test")
-static int extract_argument(const char *input, const char *keywords[], int keyword_count, char *output) {
-    char temp[MAX_PATTERN_LEN];
-    strncpy(temp, input, sizeof(temp) - 1);
-    temp[sizeof(temp) - 1] = '\0';
-    str_to_lower(temp);
-    
-    for (int i = 0; i < keyword_count; i++) {
-        char *pos = strstr(temp, keywords[i]);
-        if (pos) {
-            pos += strlen(keywords[i]);
-            while (*pos && isspace((unsigned char)*pos)) pos++;
-            
-            // Find end of argument
-            char *end = pos;
-            while (*end && !isspace((unsigned char)*end)) end++;
-            
-            int len = end - pos;
-            if (len > 0) {
-                // Get from original string to preserve case
-                int offset = pos - temp;
-                strncpy(output, input + offset, len);
-                output[len] = '\0';
-                return 1;
+// ============ Natural Language Classifier ============
+
+#define FEATURE_SLOTS 256          // Feature word hash slots (power of two)
+#define FEATURE_MAX_LEN 16         // Longer words are never features
+
+// Logistic weights; a positive total means natural language
+#define W_BIAS          (-0.5)
+#define W_FIRST_COMMAND (-3.5)     // "ls ...", "cat ..."
+#define W_FIRST_VERB      2.0      // "show ...", "create ..."
+#define W_VERB            0.5
+#define W_FUNCTION        1.0      // "the", "me", "called", "where" ...
+#define W_FLAG          (-1.5)     // "-la"
+#define W_SHELL_SYNTAX  (-2.5)     // | < > ; & $ = ` * anywhere
+#define W_PATH          (-0.5)     // A token containing '/'
+#define W_QUESTION        1.5      // Ends with '?'
+#define W_ONE_WORD      (-2.0)
+#define W_MANY_WORDS      0.6      // Added at two words and again at three
+
+enum { FEATURE_NONE, FEATURE_COMMAND, FEATURE_VERB, FEATURE_FUNCTION };
+
+typedef struct {
+    const char *word;
+    uint8_t len;
+    uint8_t kind;
+} FeatureSlot;
+
+static FeatureSlot feature_slots[FEATURE_SLOTS];
+
+// Words that open a request, and function words shell commands rarely use
+static const char *nl_verbs[] = {
+    "show", "list", "display", "create", "make", "delete", "remove", "erase",
+    "find", "go", "open", "tell", "give", "get", "print", "count", "copy",
+    "move", "rename", "read", "view", "change", "navigate", "switch", "enter",
+    "look", "check", "add", "save", "take", "compute", "calculate"
+};
+
+static const char *nl_function_words[] = {
+    "me", "my", "the", "a", "an", "all", "to", "in", "of", "for", "with",
+    "from", "into", "about", "called", "named", "i", "you", "please", "can",
+    "could", "want", "need", "is", "are", "am", "what", "whats", "where",
+    "how", "which", "some", "this", "that", "it", "do", "does", "there"
+};
+
+static uint32_t feature_hash(const char *word, int len) {
+    uint32_t h = 2166136261u;
+    for (int i = 0; i < len; i++) {
+        h ^= (unsigned char)word[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// First registration wins, so a command name is never treated as a verb
+static void feature_add(const char *word, int kind) {
+    int len = strlen(word);
+    if (len > FEATURE_MAX_LEN) return;
+    uint32_t i = feature_hash(word, len) & (FEATURE_SLOTS - 1);
+    while (feature_slots[i].word) {
+        if (feature_slots[i].len == len && memcmp(feature_slots[i].word, word, len) == 0) return;
+        i = (i + 1) & (FEATURE_SLOTS - 1);
+    }
+    feature_slots[i].word = word;
+    feature_slots[i].len = len;
+    feature_slots[i].kind = kind;
+}
+
+static void features_init(void) {
+    memset(feature_slots, 0, sizeof(feature_slots));
+    for (int i = 0; i < num_commands; i++) feature_add(available_commands[i], FEATURE_COMMAND);
+    for (size_t i = 0; i < sizeof(nl_verbs) / sizeof(nl_verbs[0]); i++) {
+        feature_add(nl_verbs[i], FEATURE_VERB);
+    }
+    for (size_t i = 0; i < sizeof(nl_function_words) / sizeof(nl_function_words[0]); i++) {
+        feature_add(nl_function_words[i], FEATURE_FUNCTION);
+    }
+}
+
+static int feature_kind(const char *word, int len, uint32_t hash) {
+    uint32_t i = hash & (FEATURE_SLOTS - 1);
+    while (feature_slots[i].word) {
+        if (feature_slots[i].len == len && memcmp(feature_slots[i].word, word, len) == 0) {
+            return feature_slots[i].kind;
+        }
+        i = (i + 1) & (FEATURE_SLOTS - 1);
+    }
+    return FEATURE_NONE;
+}
+
+double nlp_classify(const char *input) {
+    if (!input) return 0;
+    nlp_init();
+    
+    // One pass: each word is lowercased and hashed as it is read
+    double z = W_BIAS;
+    int words = 0, syntax = 0, path = 0;
+    char last = 0;
+    const char *p = input;
+    while (*p) {
+        while (*p == ' ' || *p == '\t') p++;
+        if (!*p) break;
+        
+        char word[FEATURE_MAX_LEN];
+        int len = 0, plain = 1;
+        uint32_t h = 2166136261u;
+        if (*p == '-') z += W_FLAG;
+        for (; *p && *p != ' ' && *p != '\t'; p++) {
+            unsigned char c = *p;
+            last = c;
+            if (c >= 'A' && c <= 'Z') c += 'a' - 'A';
+            if (c >= 'a' && c <= 'z') {
+                if (len < FEATURE_MAX_LEN) {
+                    word[len++] = c;
+                    h = (h ^ c) * 16777619u;
+                } else {
+                    plain = 0;
+                }
+                continue;
+            }
+            switch (c) {
+                case '|': case '<': case '>': case ';': case '&':
+                case '$': case '=': case '`': case '*':
+                    syntax = 1;
+                    break;
+                case '/':
+                    path = 1;
+                    break;
+            }
+            // Apostrophes and closing punctuation still leave a plain word
+            if (c != '\'' && !((c == '?' || c == '.' || c == ',' || c == '!') &&
+                               (!p[1] || p[1] == ' ' || p[1] == '\t'))) {
+                plain = 0;
             }
         }
+        
+        int kind = plain && len ? feature_kind(word, len, h) : FEATURE_NONE;
+        if (kind == FEATURE_COMMAND && words == 0) z += W_FIRST_COMMAND;
+        else if (kind == FEATURE_VERB) z += words == 0 ? W_FIRST_VERB : W_VERB;
+        else if (kind == FEATURE_FUNCTION) z += W_FUNCTION;
+        words++;
     }
-    return 0;
+    if (words == 0) return 0;
+    
+    if (syntax) z += W_SHELL_SYNTAX;
+    if (path) z += W_PATH;
+    if (last == '?') z += W_QUESTION;
+    if (words == 1) z += W_ONE_WORD;
+    if (words >= 2) z += W_MANY_WORDS;
+    if (words >= 3) z += W_MANY_WORDS;
+    return 1.0 / (1.0 + exp(-z));
+}
+
+int nlp_is_natural_language(const char *input) {
+    return nlp_classify(input) >= NLP_NL_THRESHOLD;
+}
+
+// ============ Main NLP Functions ============
+
+// Entries reference phrase ids, so they die with the pack; counters survive
+static void cache_reset(void) {
+    pthread_mutex_lock(&cache_lock);
+    for (int i = 0; i < NLP_CACHE_BUCKETS; i++) cache_buckets[i] = -1;
+    cache_head = cache_tail = -1;
+    cache_count = 0;
+    pthread_mutex_unlock(&cache_lock);
+}
+
+static NLPTables *tables_acquire(void) {
+    pthread_mutex_lock(&pack_lock);
+    NLPTables *tables = active_tables;
+    if (tables) tables->refs++;
+    pthread_mutex_unlock(&pack_lock);
+    return tables;
 }
 
-// Extract last word from string
-static int extract_last_word(const char *input, char *output) {
-    const char *last_space = strrchr(input, ' ');
-    if (last_space) {
-        strcpy(output, last_space + 1);
-        return strlen(output) > 0;
+static void tables_release(NLPTables *tables) {
+    if (!tables) return;
+    pthread_mutex_lock(&pack_lock);
+    int last = --tables->refs == 0;
+    pthread_mutex_unlock(&pack_lock);
+    if (last) {
+        if (tables->completions) phrase_index_free(tables->completions);
+        free(tables->completions);
+        intent_model_free(&tables->model);
+        nlp_pack_free(tables->pack);
+        free(tables);
     }
-    return 0;
 }
 
-// Extract words between two keywords
-static int extract_between(const char *input, const char *from_kw __attribute__((unused)), const char *to_kw, char *arg1, char *arg2) {
-    char temp[MAX_PATTERN_LEN];
-    strncpy(temp, input, sizeof(temp) - 1);
-    str_to_lower(temp);
-    
-    char *to_pos = strstr(temp, to_kw);
-    if (!to_pos) return 0;
-    
-    // Get second argument (after "to")
-    char *arg2_start = to_pos + strlen(to_kw);
-    while (*arg2_start && isspace((unsigned char)*arg2_start)) arg2_start++;
-    
-    char *arg2_end = arg2_start;
-    while (*arg2_end && !isspace((unsigned char)*arg2_end)) arg2_end++;
-    
-    int offset2 = arg2_start - temp;
-    int len2 = arg2_end - arg2_start;
-    strncpy(arg2, input + offset2, len2);
-    arg2[len2] = '\0';
-    
-    // Get first argument (before "to", after keywords like "copy", "move", etc.)
-    *to_pos = '\0';  // Temporarily terminate
+// Input in canonical, singular words ("erase those directories" ->
+// "delete those folder"), the form the intent model is trained and
+// queried with
+static void normalize_text(const NLPPack *pack, const char *input, char *out, size_t size) {
+    NLPToken tokens[MAX_INPUT_TOKENS];
+    int count = nlp_tokenize(input, tokens, MAX_INPUT_TOKENS);
+    size_t used = 0;
+    out[0] = '\0';
+    for (int i = 0; i < count; i++) {
+        char stem[NLP_MAX_TOKEN_LEN];
+        const char *word = nlp_stem(tokens[i].text, stem) ? stem : tokens[i].text;
+        int len = snprintf(out + used, size - used, "%s%s", i ? " " : "", nlp_pack_canonical(pack, word));
+        if (len < 0 || (size_t)len >= size - used) break;
+        used += len;
+    }
+}
+
+// Training examples from $NLP_INTENT_CORPUS or ~/.nlp_intents, in pattern
+// source format. Intents are matched to the pack by command template.
+static int load_corpus(const NLPPack *pack, NLPSource *src, IntentExample **examples) {
+    char path[PATH_MAX];
+    const char *env = getenv("NLP_INTENT_CORPUS");
+    const char *home = getenv("HOME");
+    if (env && !*env) return 0;  // Set but empty: no corpus
+    if (env) snprintf(path, sizeof(path), "%s", env);
+    else if (home) snprintf(path, sizeof(path), "%s/%s", home, CORPUS_FILE);
+    else return 0;
+    if (nlp_pack_read_source(path, src) != 0) return 0;
+    
+    int total = 0;
+    for (int i = 0; i < src->intent_count; i++) total += src->intents[i].phrase_count;
+    *examples = malloc(sizeof(IntentExample) * (total ? total : 1));
+    if (!*examples) return 0;
+    
+    int count = 0;
+    for (int i = 0; i < src->intent_count; i++) {
+        const NLPIntentDef *def = &src->intents[i];
+        uint32_t target = 0;
+        while (target < pack->header->intent_count &&
+               strcmp(nlp_pack_string(pack, pack->intents[target].template_str), def->command_template) != 0) {
+            target++;
+        }
+        if (target == pack->header->intent_count) {
+            fprintf(stderr, "nlp: %s: no pattern intent '%s'\n", path, def->command_template);
+            continue;
+        }
+        for (int j = 0; j < def->phrase_count; j++) {
+            (*examples)[count].text = def->phrases[j];
+            (*examples)[count].intent = target;
+            count++;
+        }
+    }
+    return count;
+}
+
+// Wrap a pack with an intent model trained on its phrases and the corpus
+static NLPTables *tables_create(NLPPack *pack) {
+    NLPTables *tables = calloc(1, sizeof(NLPTables));
+    if (!tables) return NULL;
+    tables->pack = pack;
+    
+    NLPSource corpus;
+    IntentExample *extra = NULL;
+    memset(&corpus, 0, sizeof(corpus));
+    int extra_count = load_corpus(pack, &corpus, &extra);
+    
+    uint32_t phrase_count = pack->header->phrase_count;
+    int total = phrase_count + extra_count;
+    IntentExample *examples = malloc(sizeof(IntentExample) * (total + 1));
+    char (*texts)[MAX_PATTERN_LEN] = malloc(MAX_PATTERN_LEN * (total + 1));
+    if (examples && texts) {
+        for (uint32_t i = 0; i < phrase_count; i++) {
+            examples[i].text = nlp_pack_string(pack, pack->phrases[i].text_str);
+            examples[i].intent = pack->phrases[i].intent;
+        }
+        for (int i = 0; i < extra_count; i++) examples[phrase_count + i] = extra[i];
+        for (int i = 0; i < total; i++) {
+            normalize_text(pack, examples[i].text, texts[i], MAX_PATTERN_LEN);
+            examples[i].text = texts[i];
+        }
+        // A failed training leaves an empty model, which predicts nothing
+        intent_model_train(&tables->model, examples, total, pack->header->intent_count);
+
+        // Pack phrases come first in texts. A failed build leaves an empty
+        // index, which completes nothing.
+        const char **phrases = malloc(sizeof(char *) * (phrase_count + 1));
+        tables->completions = calloc(1, sizeof(PhraseIndex));
+        if (phrases && tables->completions) {
+            for (uint32_t i = 0; i < phrase_count; i++) phrases[i] = texts[i];
+            phrase_index_build(tables->completions, phrases, phrase_count);
+        }
+        free(phrases);
+    }
+    free(examples);
+    free(texts);
+    free(extra);
+    nlp_pack_free_source(&corpus);
+    return tables;
+}
+
+// Make pack the active one; the old tables go once their last reader is done
+static void pack_install(NLPPack *pack) {
+    NLPTables *tables = tables_create(pack);
+    if (!tables) {
+        nlp_pack_free(pack);
+        return;
+    }
+    tables->refs = 1;
+    pthread_mutex_lock(&pack_lock);
+    NLPTables *old = active_tables;
+    tables->generation = ++tables_generation;
+    active_tables = tables;
+    cache_reset();
+    pthread_mutex_unlock(&pack_lock);
+    tables_release(old);
+}
+
+static int same_file(const struct stat *a, const struct stat *b) {
+    return a->st_dev == b->st_dev && a->st_ino == b->st_ino && a->st_size == b->st_size &&
+           a->st_mtim.tv_sec == b->st_mtim.tv_sec && a->st_mtim.tv_nsec == b->st_mtim.tv_nsec;
+}
+
+// Swap in the pack file when it has changed. Packs are precompiled, so a
+// reload is an mmap plus validation; concurrent callers skip the check.
+static void pack_poll(void) {
+    if (!pack_path[0] || pthread_mutex_trylock(&poll_lock) != 0) return;
+    
+    time_t now = time(NULL);
+    struct stat st;
+    if (now - pack_checked >= PACK_POLL_INTERVAL && stat(pack_path, &st) == 0 &&
+        !same_file(&st, &pack_stat)) {
+        // Remember rejected files too, so a bad pack is not retried every poll
+        pack_stat = st;
+        NLPPack *pack = nlp_pack_open(pack_path);
+        if (pack) pack_install(pack);
+        else fprintf(stderr, "nlp: ignoring invalid pattern pack %s\n", pack_path);
+    }
+    pack_checked = now;
+    pthread_mutex_unlock(&poll_lock);
+}
+
+// $NLP_PATTERN_PACK, or data/nlp_patterns.pack next to the executable.
+// Resolved once, since later "cd" commands change the working directory.
+static void resolve_pack_path(void) {
+    const char *env = getenv("NLP_PATTERN_PACK");
+    char dir[PATH_MAX];
+    int len;
+    
+    if (pack_path[0]) return;  // Chosen by nlp_set_pack_path()
+    if (env && *env) {
+        if (env[0] == '/' || !getcwd(dir, sizeof(dir))) {
+            len = snprintf(pack_path, sizeof(pack_path), "%s", env);
+        } else {
+            len = snprintf(pack_path, sizeof(pack_path), "%s/%s", dir, env);
+        }
+    } else {
+        ssize_t n = readlink("/proc/self/exe", dir, sizeof(dir) - 1);
+        char *slash = NULL;
+        if (n > 0) {
+            dir[n] = '\0';
+            slash = strrchr(dir, '/');
+        }
+        if (!slash) {
+            pack_path[0] = '\0';
+            return;
+        }
+        *slash = '\0';
+        len = snprintf(pack_path, sizeof(pack_path), "%s/%s", dir, DEFAULT_PACK_FILE);
+    }
+    if (len < 0 || len >= (int)sizeof(pack_path)) pack_path[0] = '\0';
+}
+
+// Flatten the built-in synonym groups into pairs and compile the pack
+static NLPPack *compile_builtin(void) {
+    int count = 0;
+    for (int i = 0; i < num_builtin_synonyms; i++) count += builtin_synonyms[i].count;
+    NLPSynonymDef *pairs = malloc(sizeof(NLPSynonymDef) * count);
+    if (!pairs) return NULL;
+    
+    int n = 0;
+    for (int i = 0; i < num_builtin_synonyms; i++) {
+        for (int j = 0; j < builtin_synonyms[i].count; j++) {
+            pairs[n].word = builtin_synonyms[i].words[j];
+            pairs[n].canonical = builtin_synonyms[i].canonical;
+            n++;
+        }
+    }
+    NLPPack *pack = nlp_pack_compile(builtin_intents, num_builtin_intents, pairs, n);
+    free(pairs);
+    return pack;
+}
+
+static pthread_once_t init_once = PTHREAD_ONCE_INIT;
+
+static void init_tables(void) {
+    cache_reset();
+    features_init();
+    resolve_pack_path();
+    
+    NLPPack *pack = NULL;
+    if (pack_path[0] && stat(pack_path, &pack_stat) == 0) {
+        pack = nlp_pack_open(pack_path);
+        if (!pack) fprintf(stderr, "nlp: ignoring invalid pattern pack %s\n", pack_path);
+    }
+    if (!pack) pack = compile_builtin();
+    if (!pack) return;
     
-    // Find last significant word before "to"
-    char *word_end = to_pos - 1;
-    while (word_end > temp && isspace((unsigned char)*word_end)) word_end--;
+    pack_checked = time(NULL);
+    pack_install(pack);
+}
+
+// Safe to call from several threads; later calls wait for the first
+void nlp_init(void) {
+    pthread_once(&init_once, init_tables);
+}
+
+void nlp_set_pack_path(const char *path) {
+    if (!path) return;
+    pthread_mutex_lock(&poll_lock);
+    if (path[0] == '/' || !getcwd(pack_path, sizeof(pack_path))) {
+        snprintf(pack_path, sizeof(pack_path), "%s", path);
+    } else {
+        size_t used = strlen(pack_path);
+        int len = snprintf(pack_path + used, sizeof(pack_path) - used, "/%s", path);
+        if (len < 0 || (size_t)len >= sizeof(pack_path) - used) pack_path[0] = '\0';
+    }
+    pthread_mutex_unlock(&poll_lock);
+}
+
+// Find or claim the score slot for a phrase; NULL when the map is full
+static PhraseScore *score_slot(const NLPPack *pack, PhraseScore *map, int *used, uint32_t phrase) {
+    uint32_t i = (phrase * 2654435761u) & (PHRASE_MAP_SIZE - 1);
+    while (map[i].phrase != -1) {
+        if ((uint32_t)map[i].phrase == phrase) return &map[i];
+        i = (i + 1) & (PHRASE_MAP_SIZE - 1);
+    }
+    if (*used >= PHRASE_MAP_SIZE * 3 / 4) return NULL;
+    (*used)++;
+    map[i].phrase = phrase;
+    map[i].mask = 0;
+    map[i].stem_mask = 0;
+    map[i].contiguous = 0;
+    map[i].words = pack->phrases[phrase].token_count;
+    map[i].weight = pack->phrases[phrase].weight;
+    return &map[i];
+}
+
+typedef struct {
+    const NLPPack *pack;
+    PhraseScore *map;
+    int *used;
+} RunContext;
+
+// Automaton callback: the phrase occurred as an exact run of words
+static void mark_contiguous(int phrase_id, size_t end, void *ctx) {
+    (void)end;
+    RunContext *run = ctx;
+    PhraseScore *s = score_slot(run->pack, run->map, run->used, phrase_id);
+    if (s) s->contiguous = 1;
+}
+
+static double phrase_score(const PhraseScore *s) {
+    double score = s->weight * (s->contiguous ? 1.0 : SCATTERED_FACTOR);
+    return s->stem_mask & ~s->mask ? score * STEMMED_FACTOR : score;
+}
+
+// Share of the input's pattern words this phrase explains
+static double phrase_confidence(const PhraseScore *s, double known_weight) {
+    double conf = known_weight > 0 ? phrase_score(s) / known_weight : 0;
+    return conf > 1.0 ? 1.0 : conf;
+}
+
+// Best score first; more words, then table order, break ties
+static int compare_candidates(const void *a, const void *b) {
+    const PhraseScore *sa = a, *sb = b;
+    double da = phrase_score(sa), db = phrase_score(sb);
+    if (da != db) return da > db ? -1 : 1;
+    if (sa->words != sb->words) return (int)sb->words - (int)sa->words;
+    return sa->phrase - sb->phrase;
+}
+
+// Record every phrase containing word id at its position in the phrase
+static void post_word(const NLPPack *pack, PhraseScore *map, int *used, uint32_t id, int stem) {
+    const NLPPackWord *word = &pack->words[id];
+    const NLPPosting *post = &pack->postings[word->first_posting];
+    for (uint32_t p = 0; p < word->posting_count; p++) {
+        PhraseScore *s = score_slot(pack, map, used, post[p].phrase);
+        if (!s) continue;
+        if (stem) s->stem_mask |= 1u << post[p].pos;
+        else s->mask |= 1u << post[p].pos;
+    }
+}
+
+// Rank every phrase whose words all appear in the input; returns the count.
+// ids are the input's words as written, stems[i] the word id of a plural's
+// singular (0 for none), so "remove my files" meets "delete file" while
+// "show files" still prefers ls over "show file".
+static int rank_phrases(const NLPPack *pack, const uint32_t *ids, const uint32_t *stems,
+                        int token_count, PhraseScore *candidates) {
+    // Inverted index: every phrase sharing a word with the input is a candidate
+    PhraseScore map[PHRASE_MAP_SIZE];
+    int used = 0;
+    for (int i = 0; i < PHRASE_MAP_SIZE; i++) map[i].phrase = -1;
+    
+    uint32_t stemmed[MAX_INPUT_TOKENS];
+    int any_stem = 0;
+    for (int i = 0; i < token_count; i++) {
+        if (ids[i]) post_word(pack, map, &used, ids[i], 0);
+        if (stems[i]) post_word(pack, map, &used, stems[i], 1);
+        stemmed[i] = stems[i] ? stems[i] : ids[i];
+        any_stem |= stems[i] != 0;
+    }
     
-    char *word_start = word_end;
-    while (word_start > temp && !isspace((unsigned char)*(word_start - 1))) word_start--;
+    // Exact word runs score higher than scattered words
+    RunContext run = {pack, map, &used};
+    ac_scan_seq(&pack->automaton, ids, token_count, mark_contiguous, &run);
+    if (any_stem) ac_scan_seq(&pack->automaton, stemmed, token_count, mark_contiguous, &run);
+    
+    // Keep phrases whose every word appeared, best score first
+    int candidate_count = 0;
+    for (int i = 0; i < PHRASE_MAP_SIZE; i++) {
+        if (map[i].phrase == -1) continue;
+        uint32_t full = (1u << map[i].words) - 1;
+        if ((map[i].mask | map[i].stem_mask) == full) candidates[candidate_count++] = map[i];
+    }
+    qsort(candidates, candidate_count, sizeof(PhraseScore), compare_candidates);
+    return candidate_count;
+}
+
+static uint32_t hash_ids(const uint32_t *ids, int count) {
+    uint32_t h = 2166136261u;
+    for (int i = 0; i < count; i++) {
+        h ^= ids[i];
+        h *= 16777619u;
+    }
+    return h ^ (uint32_t)count;
+}
+
+static void cache_unlink(int e) {
+    NLPCacheEntry *entry = &cache_entries[e];
+    if (entry->prev != -1) cache_entries[entry->prev].next = entry->next;
+    else cache_head = entry->next;
+    if (entry->next != -1) cache_entries[entry->next].prev = entry->prev;
+    else cache_tail = entry->prev;
+}
+
+static void cache_push_front(int e) {
+    cache_entries[e].prev = -1;
+    cache_entries[e].next = cache_head;
+    if (cache_head != -1) cache_entries[cache_head].prev = e;
+    cache_head = e;
+    if (cache_tail == -1) cache_tail = e;
+}
+
+static NLPCacheEntry *cache_lookup(uint32_t generation, const uint32_t *ids, int count, uint32_t hash) {
+    for (int e = cache_buckets[hash & (NLP_CACHE_BUCKETS - 1)]; e != -1; e = cache_entries[e].chain) {
+        NLPCacheEntry *entry = &cache_entries[e];
+        if (entry->hash == hash && entry->generation == generation && entry->token_count == count &&
+            memcmp(entry->ids, ids, sizeof(uint32_t) * count) == 0) {
+            cache_unlink(e);
+            cache_push_front(e);
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+// Take a free entry, or evict the least recently used one
+static NLPCacheEntry *cache_insert(uint32_t generation, const uint32_t *ids, int count, uint32_t hash) {
+    int e;
+    if (cache_count < NLP_CACHE_SIZE) {
+        e = cache_count++;
+    } else {
+        e = cache_tail;
+        cache_unlink(e);
+        int *link = &cache_buckets[cache_entries[e].hash & (NLP_CACHE_BUCKETS - 1)];
+        while (*link != e) link = &cache_entries[*link].chain;
+        *link = cache_entries[e].chain;
+        cache_stats.evictions++;
+    }
     
-    int offset1 = word_start - temp;
-    int len1 = word_end - word_start + 1;
-    strncpy(arg1, input + offset1, len1);
-    arg1[len1] = '\0';
+    NLPCacheEntry *entry = &cache_entries[e];
+    entry->hash = hash;
+    entry->generation = generation;
+    entry->token_count = count;
+    memcpy(entry->ids, ids, sizeof(uint32_t) * count);
+    int *bucket = &cache_buckets[hash & (NLP_CACHE_BUCKETS - 1)];
+    entry->chain = *bucket;
+    *bucket = e;
+    cache_push_front(e);
+    return entry;
+}
+
+void nlp_cache_clear(void) {
+    cache_reset();
+    pthread_mutex_lock(&cache_lock);
+    memset(&cache_stats, 0, sizeof(cache_stats));
+    pthread_mutex_unlock(&cache_lock);
+}
+
+void nlp_cache_get_stats(NLPCacheStats *stats) {
+    if (!stats) return;
+    pthread_mutex_lock(&cache_lock);
+    *stats = cache_stats;
+    stats->entries = cache_count;
+    pthread_mutex_unlock(&cache_lock);
+    stats->capacity = NLP_CACHE_SIZE;
+}
+
+// Write command_template with its n filled slots, shell-quoted, to result
+static void format_command(const char *command_template, char args[NLP_MAX_SLOTS][NLP_SLOT_LEN], int n,
+                           NLPResult *result) {
+    char quoted[NLP_MAX_SLOTS][NLP_SLOT_LEN * 2 + 3];
+    for (int i = 0; i < n; i++) nlp_shell_quote(args[i], quoted[i], sizeof(quoted[i]));
+    if (n == 2) {
+        snprintf(result->translated, sizeof(result->translated), command_template, quoted[0], quoted[1]);
+    } else {
+        snprintf(result->translated, sizeof(result->translated), command_template, quoted[0]);
+    }
+    snprintf(result->argument, sizeof(result->argument), "%s", args[n - 1]);
+    result->was_translated = 1;
+}
+
+// Fill result from a matched pattern; returns 0 if its arguments are missing
+static int apply_intent(const NLPPack *pack, uint32_t intent_id, NLPSlotInput *slots, NLPResult *result) {
+    const NLPPackIntent *intent = &pack->intents[intent_id];
+    const char *command_template = nlp_pack_string(pack, intent->template_str);
+    strncpy(result->explanation, nlp_pack_string(pack, intent->explanation_str),
+            sizeof(result->explanation) - 1);
+    
+    // Fill %s slots from the input; an unfilled slot means this intent
+    // does not apply
+    if (strstr(command_template, "%s")) {
+        char args[NLP_MAX_SLOTS][NLP_SLOT_LEN];
+        int n = nlp_fill_slots(slots, command_template, args);
+        if (n == 0) return 0;
+        format_command(command_template, args, n, result);
+        result->suggest_only = slots->missing;
+        return 1;
+    }
     
-    return strlen(arg1) > 0 && strlen(arg2) > 0;
+    // No arguments needed
+    strncpy(result->translated, command_template, sizeof(result->translated) - 1);
+    result->was_translated = 1;
+    return 1;
 }
 
-// ============ Main NLP Functions ============
+// "copy 'my report.txt' to backup": an explicit source and destination
+// after a copy or move verb decide the intent before any phrase is ranked,
+// since the destination may be a pattern word itself. Only packs that
+// define the command take part.
+static int apply_transfer(const NLPPack *pack, NLPSlotInput *slots, NLPResult *result) {
+    char args[NLP_MAX_SLOTS][NLP_SLOT_LEN];
+    const char *command_template = nlp_fill_transfer(slots, args);
+    if (!command_template) return 0;
+    for (uint32_t i = 0; i < pack->header->intent_count; i++) {
+        const NLPPackIntent *intent = &pack->intents[i];
+        if (strcmp(nlp_pack_string(pack, intent->template_str), command_template) != 0) continue;
+        strncpy(result->explanation, nlp_pack_string(pack, intent->explanation_str),
+                sizeof(result->explanation) - 1);
+        format_command(command_template, args, NLP_MAX_SLOTS, result);
+        result->confidence = 1.0;
+        result->suggest_only = slots->missing;
+        return 1;
+    }
+    return 0;
+}
 
-void nlp_init(void) {
-    // Initialization if needed (currently stateless)
+// Statistical fallback for phrasings no pattern matches. The model names an
+// intent for any sentence, so a guess needs most of the input's words to
+// be known, a clear lead, and, for file commands, a file that exists:
+// "what is the capital of france" is not "cat france". What survives is
+// only ever offered, never run.
+static void guess_intent(const NLPTables *tables, const char *input, NLPSlotInput *slots,
+                         NLPResult *result) {
+    IntentScore best[2];
+    char normalized[MAX_PATTERN_LEN];
+    if (nlp_classify(input) < MODEL_MIN_NL) return;
+    normalize_text(tables->pack, input, normalized, sizeof(normalized));
+    if (intent_model_coverage(&tables->model, normalized) < MODEL_MIN_COVERAGE) return;
+    int n = intent_model_predict(&tables->model, normalized, best, 2);
+    if (n == 0 || best[0].probability < MODEL_MIN_PROB ||
+        best[0].probability - (n > 1 ? best[1].probability : 0) < MODEL_MIN_MARGIN) {
+        return;
+    }
+    NLPResult guess = *result;
+    if (apply_intent(tables->pack, best[0].intent, slots, &guess) && !slots->missing) {
+        *result = guess;
+        // Never as sure as an explicit phrase match
+        result->confidence = best[0].probability * MODEL_MIN_PROB;
+        result->suggest_only = 1;
+    }
+}
+
+// Rank phrases for input and apply the best usable intent
+// Phrases that translate rise in the completion lists
+static void note_phrase_use(const NLPTables *tables, uint32_t phrase) {
+    if (!tables->completions) return;
+    pthread_mutex_lock(&completion_lock);
+    phrase_index_use(tables->completions, phrase);
+    pthread_mutex_unlock(&completion_lock);
+}
+
+static void translate_with(const NLPTables *tables, const char *input, NLPResult *result) {
+    const NLPPack *pack = tables->pack;
+    
+    // Tokenize once and map words to vocabulary ids (0 = not a pattern
+    // word). A plural also looks up its singular, through the synonyms.
+    // ids and stems sit in one array, the cache key.
+    NLPToken tokens[MAX_INPUT_TOKENS];
+    uint32_t ids[MAX_INPUT_TOKENS * 2];
+    int token_count = nlp_tokenize(input, tokens, MAX_INPUT_TOKENS);
+    uint32_t *stems = ids + token_count;
+    nlp_pack_normalize(pack, tokens, token_count);
+    double known_weight = 0;
+    for (int i = 0; i < token_count; i++) {
+        char stem[NLP_MAX_TOKEN_LEN];
+        ids[i] = nlp_pack_lookup(pack, tokens[i].text);
+        stems[i] = 0;
+        if (nlp_stem(tokens[i].text, stem)) {
+            stems[i] = nlp_pack_lookup(pack, nlp_pack_canonical(pack, stem));
+            if (stems[i] == ids[i]) stems[i] = 0;
+        }
+        if (ids[i]) known_weight += pack->words[ids[i]].weight;
+        else if (stems[i]) known_weight += pack->words[stems[i]].weight;
+    }
+    
+    // Lexed for arguments on the first template with a slot
+    NLPSlotInput slots;
+    nlp_slot_input_init(&slots, pack, input);
+    if (apply_transfer(pack, &slots, result)) return;
+
+    // Repeated phrasings skip ranking; arguments still come from this input.
+    // Hits are copied out so the lock is not held while applying them.
+    uint32_t hash = 0;
+    NLPCacheEntry hit;
+    int found = 0;
+    int cacheable = token_count <= NLP_CACHE_MAX_TOKENS;
+    if (cacheable) {
+        hash = hash_ids(ids, token_count * 2);
+        pthread_mutex_lock(&cache_lock);
+        NLPCacheEntry *entry = cache_lookup(tables->generation, ids, token_count * 2, hash);
+        if (entry) {
+            hit = *entry;
+            found = 1;
+            cache_stats.hits++;
+        } else {
+            cache_stats.misses++;
+        }
+        pthread_mutex_unlock(&cache_lock);
+    }
+    if (found) {
+        for (int i = 0; i < hit.candidate_count; i++) {
+            if (apply_intent(pack, pack->phrases[hit.candidates[i]].intent, &slots, result)) {
+                result->confidence = hit.confidence[i];
+                note_phrase_use(tables, hit.candidates[i]);
+                return;
+            }
+        }
+        if (!hit.truncated) {
+            if (hit.candidate_count == 0) guess_intent(tables, input, &slots, result);
+            return;
+        }
+    }
+    
+    PhraseScore candidates[PHRASE_MAP_SIZE];
+    int candidate_count = rank_phrases(pack, ids, stems, token_count, candidates);
+    
+    if (cacheable && !found) {
+        pthread_mutex_lock(&cache_lock);
+        // Another thread may have ranked the same input meanwhile
+        if (!cache_lookup(tables->generation, ids, token_count * 2, hash)) {
+            NLPCacheEntry *entry = cache_insert(tables->generation, ids, token_count * 2, hash);
+            entry->candidate_count = 0;
+            for (int i = 0; i < candidate_count && i < NLP_CACHE_CANDIDATES; i++) {
+                entry->candidates[i] = candidates[i].phrase;
+                entry->confidence[i] = phrase_confidence(&candidates[i], known_weight);
+                entry->candidate_count++;
+            }
+            entry->truncated = candidate_count > NLP_CACHE_CANDIDATES;
+        }
+        pthread_mutex_unlock(&cache_lock);
+    }
+    
+    for (int i = 0; i < candidate_count; i++) {
+        if (apply_intent(pack, pack->phrases[candidates[i].phrase].intent, &slots, result)) {
+            result->confidence = phrase_confidence(&candidates[i], known_weight);
+            note_phrase_use(tables, candidates[i].phrase);
+            return;
+        }
+    }
+    // A phrase that matched but lacked its arguments ("remove all my
+    // files") is not handed to the model, which would pick something else
+    if (candidate_count == 0) guess_intent(tables, input, &slots, result);
 }
 
 NLPResult nlp_translate(const char *input) {
     NLPResult result;
     memset(&result, 0, sizeof(result));
+    if (!input) return result;
     strncpy(result.original, input, sizeof(result.original) - 1);
     strncpy(result.translated, input, sizeof(result.translated) - 1);
     result.was_translated = 0;
     
-    if (!input || strlen(input) == 0) {
+    if (strlen(input) == 0) {
         return result;
     }
     
-    // Normalize input
+    nlp_init();
+    pack_poll();
+    NLPTables *tables = tables_acquire();
+    if (!tables) return result;
+    
+    // Untranslated input comes back unchanged
+    translate_with(tables, input, &result);
+    tables_release(tables);
+    return result;
+}
+
+int nlp_rank_intents(const char *input, NLPIntentGuess *out, int max) {
+    if (!input || !out || max <= 0) return 0;
+    nlp_init();
+    pack_poll();
+    NLPTables *tables = tables_acquire();
+    if (!tables) return 0;
+    
+    IntentScore scores[INTENT_TOP_K];
     char normalized[MAX_PATTERN_LEN];
-    strncpy(normalized, input, sizeof(normalized) - 1);
-    normalized[sizeof(normalized) - 1] = '\0';
-    str_to_lower(normalized);
-    char *trimmed = str_trim(normalized);
-    
-    // Check each pattern
-    for (int i = 0; i < num_patterns; i++) {
-        NLPPattern *p = &nlp_patterns[i];
-        
-        for (int j = 0; j < p->pattern_count; j++) {
-            if (str_contains(trimmed, p->patterns[j])) {
-                // Found a match!
-                strncpy(result.explanation, p->explanation, sizeof(result.explanation) - 1);
-                
-                // Check if command needs arguments
-                if (strstr(p->command_template, "%s")) {
-                    // Needs argument extraction
-                    const char *arg_keywords[] = {"called", "named", "file", "folder", "directory", "to"};
-                    char arg1[256] = "", arg2[256] = "";
-                    
-                    // Check for two-argument commands (copy, move, compare)
-                    if (strstr(p->command_template, "%s %s")) {
-                        if (extract_between(input, "", " to ", arg1, arg2) ||
-                            extract_between(input, "", " and ", arg1, arg2) ||
-                            extract_between(input, "", " with ", arg1, arg2)) {
-                            snprintf(result.translated, sizeof(result.translated), 
-                                    p->command_template, arg1, arg2);
-                            result.was_translated = 1;
-                            return result;
-                        }
-                    }
-                    
-                    // Single argument
-                    if (extract_argument(input, arg_keywords, 6, arg1) ||
-                        extract_last_word(input, arg1)) {
-                        snprintf(result.translated, sizeof(result.translated),
-                                p->command_template, arg1);
-                        result.was_translated = 1;
-                        return result;
-                    }
-                } else {
-                    // No arguments needed
-                    strncpy(result.translated, p->command_template, sizeof(result.translated) - 1);
-                    result.was_translated = 1;
-                    return result;
+    normalize_text(tables->pack, input, normalized, sizeof(normalized));
+    int n = intent_model_predict(&tables->model, normalized, scores, max < INTENT_TOP_K ? max : INTENT_TOP_K);
+    for (int i = 0; i < n; i++) {
+        const NLPPackIntent *intent = &tables->pack->intents[scores[i].intent];
+        snprintf(out[i].command_template, sizeof(out[i].command_template), "%s",
+                 nlp_pack_string(tables->pack, intent->template_str));
+        snprintf(out[i].explanation, sizeof(out[i].explanation), "%s",
+                 nlp_pack_string(tables->pack, intent->explanation_str));
+        out[i].probability = scores[i].probability;
+    }
+    tables_release(tables);
+    return n;
+}
+
+// ============ Multi-step Requests ============
+
+// Clause separators, longest first so ", and then " wins over " and "
+static const char *step_separators[] = {
+    ", and then ", " and then ", ", then ", " then ", ", and ", " and ",
+    " after that ", "; "
+};
+static const int num_step_separators = sizeof(step_separators) / sizeof(step_separators[0]);
+
+// Words that refer back to the previous step's argument
+static const char *step_references[] = {"it", "there", "them"};
+static const int num_step_references = sizeof(step_references) / sizeof(step_references[0]);
+
+// Split input into clauses on conjunctions outside quotes
+static int split_steps(const char *input, char clauses[][MAX_PATTERN_LEN], int max) {
+    int count = 0, in_quote = 0;
+    const char *start = input, *p = input;
+    while (*p && count < max) {
+        int sep_len = 0;
+        // Quotes open at a word start, so "what's" is not one
+        if (in_quote && *p == in_quote) {
+            in_quote = 0;
+        } else if (!in_quote && (*p == '"' || (*p == '\'' && (p == input || isspace((unsigned char)p[-1]))))) {
+            in_quote = *p;
+        } else if (!in_quote) {
+            for (int i = 0; i < num_step_separators; i++) {
+                size_t len = strlen(step_separators[i]);
+                if (strncasecmp(p, step_separators[i], len) == 0) {
+                    sep_len = len;
+                    break;
                 }
             }
         }
+        if (!sep_len) {
+            p++;
+            continue;
+        }
+        if (p > start) {
+            snprintf(clauses[count++], MAX_PATTERN_LEN, "%.*s", (int)(p - start), start);
+        }
+        p += sep_len;
+        start = p;
+    }
+    if (*start && count < max) {
+        snprintf(clauses[count++], MAX_PATTERN_LEN, "%s", start);
+    } else if (*start) {
+        return 0;  // More steps than fit; treat as a single request
+    }
+    return count;
+}
+
+// Replace whole-word references ("go to it") with argument, quoted if
+// it has spaces so the next clause sees it as one word
+static void resolve_references(const char *clause, const char *raw_argument, char *out, size_t size) {
+    char argument[MAX_SUGGESTION_LEN * 2 + 3];
+    nlp_shell_quote(raw_argument, argument, sizeof(argument));
+    size_t used = 0;
+    out[0] = '\0';
+    const char *p = clause;
+    while (*p && used + 1 < size) {
+        const char *word = p;
+        while (*p && !isspace((unsigned char)*p)) p++;
+        size_t len = p - word;
+        const char *text = word;
+        for (int i = 0; i < num_step_references; i++) {
+            if (strlen(step_references[i]) == len && strncasecmp(word, step_references[i], len) == 0) {
+                text = argument;
+                len = strlen(argument);
+                break;
+            }
+        }
+        while (*p && isspace((unsigned char)*p)) p++;
+        used += snprintf(out + used, size - used, "%s%.*s", used ? " " : "", (int)len, text);
+        if (used >= size) used = size - 1;
+    }
+}
+
+int nlp_translate_sequence(const char *input, NLPResult *steps, int max) {
+    if (!input || !steps || max <= 0) return 0;
+    
+    char clauses[NLP_MAX_STEPS][MAX_PATTERN_LEN];
+    int count = split_steps(input, clauses, max < NLP_MAX_STEPS ? max : NLP_MAX_STEPS);
+    if (count <= 1) {
+        steps[0] = nlp_translate(input);
+        return 1;
+    }
+    
+    nlp_init();
+    pack_poll();
+    NLPTables *tables = tables_acquire();
+    if (!tables) {
+        steps[0] = nlp_translate(input);
+        return 1;
+    }
+    
+    // Every clause must translate, or this was one request with an "and"
+    // in it ("compare a.txt and b.txt")
+    int ok = 1;
+    for (int i = 0; i < count && ok; i++) {
+        char resolved[MAX_PATTERN_LEN];
+        const char *clause = clauses[i];
+        if (i > 0 && steps[i - 1].argument[0]) {
+            resolve_references(clauses[i], steps[i - 1].argument, resolved, sizeof(resolved));
+            clause = resolved;
+        }
+        memset(&steps[i], 0, sizeof(NLPResult));
+        snprintf(steps[i].original, sizeof(steps[i].original), "%.*s", MAX_PATTERN_LEN - 1, clause);
+        snprintf(steps[i].translated, sizeof(steps[i].translated), "%.*s", MAX_PATTERN_LEN - 1, clause);
+        translate_with(tables, clause, &steps[i]);
+        ok = steps[i].was_translated;
     }
+    tables_release(tables);
     
-    // No translation found, return original
-    return result;
+    if (!ok) {
+        steps[0] = nlp_translate(input);
+        return 1;
+    }
+    return count;
+}
+
+// Partial input in the indexed phrases' form: complete words normalized
+// and canonical, the word still being typed only normalized
+static void completion_prefix(const NLPPack *pack, const char *partial, int canonical_last,
+                              char *out, size_t size) {
+    NLPToken tokens[MAX_INPUT_TOKENS];
+    int count = nlp_tokenize(partial, tokens, MAX_INPUT_TOKENS);
+    size_t len = strlen(partial);
+    int open_word = len > 0 && !isspace((unsigned char)partial[len - 1]);
+    size_t used = 0;
+    out[0] = '\0';
+    for (int i = 0; i < count; i++) {
+        int last = i == count - 1 && open_word;
+        const char *word = last && !canonical_last ? tokens[i].text
+                                                   : nlp_pack_canonical(pack, tokens[i].text);
+        int n = snprintf(out + used, size - used, "%s%s", word, last ? "" : " ");
+        if (n < 0 || (size_t)n >= size - used) break;
+        used += n;
+    }
+}
+
+void nlp_complete_phrases(const char *partial, SuggestionList *suggestions) {
+    if (!partial || !suggestions || suggestions->count >= MAX_SUGGESTIONS) return;
+    char lower_partial[256];
+    snprintf(lower_partial, sizeof(lower_partial), "%s", partial);
+    str_to_lower(lower_partial);
+    if (!lower_partial[0]) return;
+    
+    nlp_init();
+    pack_poll();
+    NLPTables *tables = tables_acquire();
+    if (!tables) return;
+    if (tables->completions) {
+        char prefix[MAX_PATTERN_LEN];
+        uint32_t phrases[MAX_SUGGESTIONS];
+        int found = 0;
+        completion_prefix(tables->pack, lower_partial, 0, prefix, sizeof(prefix));
+        pthread_mutex_lock(&completion_lock);
+        if (prefix[0]) {
+            found = phrase_index_complete(tables->completions, prefix, phrases,
+                                          MAX_SUGGESTIONS - suggestions->count);
+        }
+        // A finished synonym with no space after it yet ("erase")
+        if (found == 0) {
+            completion_prefix(tables->pack, lower_partial, 1, prefix, sizeof(prefix));
+            if (prefix[0]) {
+                found = phrase_index_complete(tables->completions, prefix, phrases,
+                                              MAX_SUGGESTIONS - suggestions->count);
+            }
+        }
+        int commands = suggestions->count;
+        for (int i = 0; i < found; i++) {
+            // Only a one-word phrase ("clear") can repeat a command name
+            const char *text = phrase_index_text(tables->completions, phrases[i]);
+            int repeated = 0;
+            for (int j = 0; j < commands && !strchr(text, ' ') && !repeated; j++) {
+                repeated = strcmp(suggestions->suggestions[j], text) == 0;
+            }
+            if (repeated) continue;
+            strncpy(suggestions->suggestions[suggestions->count], text, MAX_SUGGESTION_LEN - 1);
+            suggestions->suggestions[suggestions->count][MAX_SUGGESTION_LEN - 1] = '\0';
+            suggestions->count++;
+        }
+        pthread_mutex_unlock(&completion_lock);
+    }
+    tables_release(tables);
 }
 
 void nlp_get_suggestions(const char *partial, SuggestionList *suggestions) {
@@ -382,108 +1343,36 @@ void nlp_get_suggestions(const char *partial, SuggestionList *suggestions) {
         }
     }
     
-    // Then, substring matches (if not enough suggestions)
+    // Then, substring matches (if not enough suggestions); prefix matches
+    // were added above
     if (suggestions->count < 3) {
         for (int i = 0; i < num_commands && suggestions->count < MAX_SUGGESTIONS; i++) {
-            if (strstr(available_commands[i], lower_partial) != NULL) {
-                // Check if already added
-                int already_added = 0;
-                for (int j = 0; j < suggestions->count; j++) {
-                    if (strcmp(suggestions->suggestions[j], available_commands[i]) == 0) {
-                        already_added = 1;
-                        break;
-                    }
-                }
-                if (!already_added) {
-                    strncpy(suggestions->suggestions[suggestions->count],
-                           available_commands[i], MAX_SUGGESTION_LEN - 1);
-                    suggestions->count++;
-                }
+            if (strncmp(available_commands[i], lower_partial, partial_len) != 0 &&
+                strstr(available_commands[i], lower_partial) != NULL) {
+                strncpy(suggestions->suggestions[suggestions->count],
+                       available_commands[i], MAX_SUGGESTION_LEN - 1);
+                suggestions->count++;
             }
         }
     }
     
-    // Check for natural language patterns
-    for (int i = 0; i < num_patterns && suggestions->count < MAX_SUGGESTIONS; i++) {
-        for (int j = 0; j < nlp_patterns[i].pattern_count; j++) {
-            if (str_contains(nlp_patterns[i].patterns[j], lower_partial) ||
-                str_contains(lower_partial, nlp_patterns[i].patterns[j])) {
-                // Extract base command from template
-                char cmd[64];
-                sscanf(nlp_patterns[i].command_template, "%63s", cmd);
-                
-                // Check if already added
-                int already_added = 0;
-                for (int k = 0; k < suggestions->count; k++) {
-                    if (strcmp(suggestions->suggestions[k], cmd) == 0) {
-                        already_added = 1;
-                        break;
-                    }
-                }
-                if (!already_added) {
-                    strncpy(suggestions->suggestions[suggestions->count],
-                           cmd, MAX_SUGGESTION_LEN - 1);
-                    suggestions->count++;
-                }
-                break;
-            }
-        }
-    }
+    // Then whole phrases completing the input, most used first
+    nlp_complete_phrases(lower_partial, suggestions);
 }
 
-const char* nlp_get_best_suggestion(const char *partial) {
-    static char best[MAX_SUGGESTION_LEN];
+int nlp_get_best_suggestion(const char *partial, char *best, size_t size) {
     SuggestionList suggestions;
     
+    if (!best || size == 0) return 0;
     nlp_get_suggestions(partial, &suggestions);
     
     if (suggestions.count > 0) {
-        strncpy(best, suggestions.suggestions[0], sizeof(best) - 1);
-        best[sizeof(best) - 1] = '\0';
-        return best;
-    }
-    
-    return NULL;
-}
-
-int nlp_is_natural_language(const char *input) {
-    if (!input) return 0;
-    
-    // If it starts with a known command, it's not NL
-    char first_word[64];
-    sscanf(input, "%63s", first_word);
-    str_to_lower(first_word);
-    
-    for (int i = 0; i < num_commands; i++) {
-        if (strcmp(first_word, available_commands[i]) == 0) {
-            return 0;
-        }
+        snprintf(best, size, "%s", suggestions.suggestions[0]);
+        return 1;
     }
     
-    // Check for NL indicators
-    const char *nl_indicators[] = {
-        "show", "list", "display", "create", "make", "delete", "remove",
-        "what", "where", "how", "find", "search", "go", "help", "please",
-        "can you", "i want", "i need"
-    };
-    
-    char lower[MAX_PATTERN_LEN];
-    strncpy(lower, input, sizeof(lower) - 1);
-    str_to_lower(lower);
-    
-    for (int i = 0; i < (int)(sizeof(nl_indicators) / sizeof(nl_indicators[0])); i++) {
-        if (str_contains(lower, nl_indicators[i])) {
-            return 1;
-        }
-    }
-    
-    // If contains multiple words and spaces, likely NL
-    int spaces = 0;
-    for (int i = 0; input[i]; i++) {
-        if (input[i] == ' ') spaces++;
-    }
-    
-    return spaces >= 2;
+    best[0] = '\0';
+    return 0;
 }
 
 const char* nlp_get_command_help(const char *cmd) {
@@ -514,9 +1403,11 @@ const char* nlp_get_command_help(const char *cmd) {
     } else if (strcmp(cmd, "tree") == 0) {
         return "tree [path] - Display directory structure as a tree.";
     } else if (strcmp(cmd, "search") == 0) {
-        return "search <pattern> - Search for pattern in files.";
+        return "search <pattern> [path...] - Search for pattern in files, recursively.";
     } else if (strcmp(cmd, "fileinfo") == 0) {
         return "fileinfo <file> - Show detailed file information.";
+    } else if (strcmp(cmd, "ff") == 0) {
+        return "ff [-n count] [-d] <query> - Fuzzy find files and directories below the current directory.";
     } else if (strcmp(cmd, "duplicate") == 0) {
         return "duplicate [path] - Find duplicate files by content.";
     } else if (strcmp(cmd, "hexdump") == 0) {
@@ -0,0 +1,882 @@
+/**
+ * NLP Pattern Pack Implementation - Compiling, writing and mapping packs
+ * The compiler builds the synonym table, tokenizes and normalizes every
+ * phrase, interns its words, weights them by inverse intent frequency,
+ * lays out posting lists and builds the phrase automaton, then copies
+ * everything into one contiguous image.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "nlp_pack.h"
+#include "arena.h"
+
+#define PACK_ALIGN(n) (((n) + 7u) & ~7u)
+
+// ============ Tokenizer ============
+
+// Lowercase, drop apostrophes and trim edge punctuation ("What's?" -> "whats").
+// Tokens made only of punctuation, like "..", are kept as-is.
+static void normalize_token(const char *src, int len, char *out) {
+    int n = 0;
+    for (int i = 0; i < len && n < NLP_MAX_TOKEN_LEN - 1; i++) {
+        if (src[i] == '\'') continue;
+        out[n++] = tolower((unsigned char)src[i]);
+    }
+    out[n] = '\0';
+
+    const char *edge = ",.?!;:\"()";
+    int start = 0, end = n;
+    while (start < end && strchr(edge, out[start])) start++;
+    while (end > start && strchr(edge, out[end - 1])) end--;
+    if (start == end) return;
+    memmove(out, out + start, end - start);
+    out[end - start] = '\0';
+}
+
+int nlp_stem(const char *word, char *out) {
+    size_t n = strlen(word);
+    out[0] = '\0';
+    if (n < 4 || n >= NLP_MAX_TOKEN_LEN || word[n - 1] != 's') return 0;
+    memcpy(out, word, n + 1);
+    if (n > 4 && strcmp(word + n - 3, "ies") == 0) {
+        strcpy(out + n - 3, "y");
+    } else if (strcmp(word + n - 4, "sses") == 0) {
+        out[n - 2] = '\0';
+    } else if (isalpha((unsigned char)word[n - 2]) && !strchr("siu", word[n - 2])) {
+        out[n - 1] = '\0';
+    } else {
+        out[0] = '\0';
+        return 0;
+    }
+    return 1;
+}
+
+int nlp_tokenize(const char *input, NLPToken *tokens, int max) {
+    int count = 0;
+    const char *p = input;
+    while (*p && count < max) {
+        while (*p && isspace((unsigned char)*p)) p++;
+        if (!*p) break;
+        const char *start = p;
+        while (*p && !isspace((unsigned char)*p)) p++;
+
+        tokens[count].start = start - input;
+        tokens[count].len = p - start;
+        normalize_token(start, p - start, tokens[count].text);
+        if (tokens[count].text[0]) count++;
+    }
+    return count;
+}
+
+static uint32_t hash_word(const char *s) {
+    uint32_t h = 2166136261u;
+    while (*s) {
+        h ^= (unsigned char)*s++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// ============ Synonym Table ============
+// A perfect hash built with hash-and-displace: words are grouped into
+// buckets by one hash, and each bucket is given the seed that sends all of
+// its words to free slots. A lookup is two hashes and one compare.
+
+#define SYNONYM_MAX_SEED 4096        // Seeds tried per bucket before growing
+#define SYNONYM_MAX_SLOTS (1u << 20)
+
+static uint32_t hash_seeded(const char *s, uint32_t seed) {
+    uint32_t h = 2166136261u ^ (seed * 0x9e3779b9u);
+    while (*s) {
+        h ^= (unsigned char)*s++;
+        h *= 16777619u;
+    }
+    // Finalize, so neighbouring seeds give unrelated slots
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35u;
+    h ^= h >> 16;
+    return h;
+}
+
+static uint32_t synonym_slot(const char *word, const uint32_t *seeds, uint32_t slot_count,
+                             uint32_t bucket_count) {
+    uint32_t seed = seeds[hash_seeded(word, 0) % bucket_count];
+    return hash_seeded(word, seed) & (slot_count - 1);
+}
+
+// ============ Loading ============
+
+const char *nlp_pack_string(const NLPPack *pack, uint32_t offset) {
+    return pack->strings + offset;
+}
+
+uint32_t nlp_pack_lookup(const NLPPack *pack, const char *word) {
+    uint32_t mask = pack->header->slot_count - 1;
+    uint32_t i = hash_word(word) & mask;
+    while (pack->slots[i]) {
+        uint32_t id = pack->slots[i];
+        if (strcmp(pack->strings + pack->words[id].text_str, word) == 0) return id;
+        i = (i + 1) & mask;
+    }
+    return 0;
+}
+
+const char *nlp_pack_canonical(const NLPPack *pack, const char *word) {
+    const NLPPackHeader *h = pack->header;
+    if (h->synonym_slot_count == 0) return word;
+    const NLPPackSynonym *syn = &pack->synonyms[synonym_slot(word, pack->synonym_seeds,
+                                                             h->synonym_slot_count,
+                                                             h->synonym_bucket_count)];
+    if (syn->word_str == NLP_PACK_NO_STRING || strcmp(pack->strings + syn->word_str, word) != 0) {
+        return word;
+    }
+    return pack->strings + syn->canonical_str;
+}
+
+void nlp_pack_normalize(const NLPPack *pack, NLPToken *tokens, int count) {
+    for (int i = 0; i < count; i++) {
+        const char *canonical = nlp_pack_canonical(pack, tokens[i].text);
+        if (canonical != tokens[i].text) snprintf(tokens[i].text, NLP_MAX_TOKEN_LEN, "%s", canonical);
+    }
+}
+
+// Section [off, off + count * size) lies inside the image and is aligned
+static int section_ok(const NLPPackHeader *h, uint32_t off, uint32_t count, size_t size) {
+    return off % 8 == 0 && off >= sizeof(NLPPackHeader) && off <= h->size &&
+           (uint64_t)count * size <= h->size - off;
+}
+
+// Bounds-check every index so lookups on a damaged file cannot stray
+static int pack_validate(const NLPPack *p) {
+    const NLPPackHeader *h = p->header;
+    if (h->intent_count == 0 || h->word_count == 0 || h->slot_count < h->word_count ||
+        (h->slot_count & (h->slot_count - 1)) || h->state_count == 0 ||
+        h->strings_size == 0 || p->strings[h->strings_size - 1] != '\0') {
+        return 0;
+    }
+    for (uint32_t i = 0; i < h->intent_count; i++) {
+        const NLPPackIntent *in = &p->intents[i];
+        if (in->template_str >= h->strings_size || in->explanation_str >= h->strings_size ||
+            in->first_phrase > h->phrase_count || in->phrase_count > h->phrase_count - in->first_phrase) {
+            return 0;
+        }
+    }
+    for (uint32_t i = 0; i < h->phrase_count; i++) {
+        const NLPPackPhrase *ph = &p->phrases[i];
+        if (ph->text_str >= h->strings_size || ph->intent >= h->intent_count ||
+            ph->token_count > NLP_MAX_PHRASE_TOKENS || ph->first_token > h->token_count ||
+            ph->token_count > h->token_count - ph->first_token) {
+            return 0;
+        }
+    }
+    for (uint32_t i = 0; i < h->token_count; i++) {
+        if (p->tokens[i] == 0 || p->tokens[i] >= h->word_count) return 0;
+        const NLPPosting *post = &p->postings[i];
+        if (post->phrase >= h->phrase_count || post->pos >= p->phrases[post->phrase].token_count) return 0;
+    }
+    for (uint32_t i = 1; i < h->word_count; i++) {
+        const NLPPackWord *w = &p->words[i];
+        if (w->text_str >= h->strings_size || w->first_posting > h->token_count ||
+            w->posting_count > h->token_count - w->first_posting) {
+            return 0;
+        }
+    }
+    if ((h->synonym_slot_count == 0) != (h->synonym_bucket_count == 0) ||
+        (h->synonym_slot_count & (h->synonym_slot_count - 1)) ||
+        h->synonym_count > h->synonym_slot_count) {
+        return 0;
+    }
+    for (uint32_t i = 0; i < h->synonym_slot_count; i++) {
+        const NLPPackSynonym *syn = &p->synonyms[i];
+        if (syn->word_str != NLP_PACK_NO_STRING &&
+            (syn->word_str >= h->strings_size || syn->canonical_str >= h->strings_size)) {
+            return 0;
+        }
+    }
+    // Probing needs an empty slot to stop at
+    uint32_t filled = 0;
+    for (uint32_t i = 0; i < h->slot_count; i++) {
+        if (p->slots[i] >= h->word_count) return 0;
+        if (p->slots[i]) filled++;
+    }
+    if (filled >= h->slot_count) return 0;
+    // States are in BFS order, so links always point to earlier states;
+    // this also rules out fail-link cycles
+    for (uint32_t i = 0; i < h->state_count; i++) {
+        const AcState *s = &p->automaton.states[i];
+        if (s->first_edge > h->edge_count || s->edge_count > h->edge_count - s->first_edge ||
+            (i > 0 && (s->fail >= i || s->dict_link >= i)) ||
+            (s->output != AC_NO_OUTPUT && (s->output < 0 || (uint32_t)s->output >= h->phrase_count))) {
+            return 0;
+        }
+    }
+    for (uint32_t i = 0; i < h->edge_count; i++) {
+        if (p->automaton.edges[i].target >= h->state_count) return 0;
+    }
+    return 1;
+}
+
+// Wrap an image in typed views; takes ownership of the image on success
+static NLPPack *pack_view(void *image, size_t size, int mapped) {
+    const NLPPackHeader *h = image;
+    if (size < sizeof(NLPPackHeader) || memcmp(h->magic, NLP_PACK_MAGIC, 8) != 0 ||
+        h->version != NLP_PACK_VERSION || h->size != size) {
+        return NULL;
+    }
+    if (!section_ok(h, h->off_intents, h->intent_count, sizeof(NLPPackIntent)) ||
+        !section_ok(h, h->off_phrases, h->phrase_count, sizeof(NLPPackPhrase)) ||
+        !section_ok(h, h->off_tokens, h->token_count, sizeof(uint32_t)) ||
+        !section_ok(h, h->off_words, h->word_count, sizeof(NLPPackWord)) ||
+        !section_ok(h, h->off_slots, h->slot_count, sizeof(uint32_t)) ||
+        !section_ok(h, h->off_postings, h->token_count, sizeof(NLPPosting)) ||
+        !section_ok(h, h->off_states, h->state_count, sizeof(AcState)) ||
+        !section_ok(h, h->off_edges, h->edge_count, sizeof(AcEdge)) ||
+        !section_ok(h, h->off_synonyms, h->synonym_slot_count, sizeof(NLPPackSynonym)) ||
+        !section_ok(h, h->off_synonym_seeds, h->synonym_bucket_count, sizeof(uint32_t)) ||
+        !section_ok(h, h->off_strings, h->strings_size, 1)) {
+        return NULL;
+    }
+
+    NLPPack *pack = malloc(sizeof(NLPPack));
+    if (!pack) return NULL;
+    char *base = image;
+    pack->image = image;
+    pack->size = size;
+    pack->mapped = mapped;
+    pack->header = h;
+    pack->intents = (const NLPPackIntent *)(base + h->off_intents);
+    pack->phrases = (const NLPPackPhrase *)(base + h->off_phrases);
+    pack->tokens = (const uint32_t *)(base + h->off_tokens);
+    pack->words = (const NLPPackWord *)(base + h->off_words);
+    pack->slots = (const uint32_t *)(base + h->off_slots);
+    pack->postings = (const NLPPosting *)(base + h->off_postings);
+    pack->synonyms = (const NLPPackSynonym *)(base + h->off_synonyms);
+    pack->synonym_seeds = (const uint32_t *)(base + h->off_synonym_seeds);
+    pack->strings = base + h->off_strings;
+    // The automaton is only ever scanned, so it can point into a read-only map
+    pack->automaton.states = (AcState *)(base + h->off_states);
+    pack->automaton.state_count = h->state_count;
+    pack->automaton.edges = (AcEdge *)(base + h->off_edges);
+    pack->automaton.edge_count = h->edge_count;
+
+    if (!pack_validate(pack)) {
+        free(pack);
+        return NULL;
+    }
+    return pack;
+}
+
+NLPPack *nlp_pack_open(const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(NLPPackHeader) || st.st_size > UINT32_MAX) {
+        close(fd);
+        return NULL;
+    }
+    void *image = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (image == MAP_FAILED) return NULL;
+
+    NLPPack *pack = pack_view(image, st.st_size, 1);
+    if (!pack) munmap(image, st.st_size);
+    return pack;
+}
+
+void nlp_pack_free(NLPPack *pack) {
+    if (!pack) return;
+    if (pack->mapped) munmap(pack->image, pack->size);
+    else free(pack->image);
+    free(pack);
+}
+
+// ============ Compiler ============
+
+// Append a string to the pool, returning its offset
+static uint32_t pool_add(char *pool, uint32_t *used, const char *s) {
+    uint32_t off = *used;
+    size_t len = strlen(s) + 1;
+    memcpy(pool + off, s, len);
+    *used += len;
+    return off;
+}
+
+// Placed synonyms: the word index in each slot, -1 when empty
+typedef struct {
+    uint32_t *seeds;
+    int *slot_word;
+    uint32_t slot_count;
+    uint32_t bucket_count;
+} SynonymTable;
+
+// Find a seed that puts every word of one bucket into its own free slot
+static int synonym_place(SynonymTable *t, const char *const *words, const int *members,
+                         uint32_t size, uint32_t bucket, uint32_t *slots) {
+    for (uint32_t seed = 1; seed <= SYNONYM_MAX_SEED; seed++) {
+        uint32_t k;
+        for (k = 0; k < size; k++) {
+            slots[k] = hash_seeded(words[members[k]], seed) & (t->slot_count - 1);
+            uint32_t j = 0;
+            while (j < k && slots[j] != slots[k]) j++;
+            if (j < k || t->slot_word[slots[k]] >= 0) break;
+        }
+        if (k == size) {
+            t->seeds[bucket] = seed;
+            for (k = 0; k < size; k++) t->slot_word[slots[k]] = members[k];
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Build a perfect hash over n distinct words, growing the table until
+// every bucket places. Returns 0 on duplicate words or allocation failure.
+static int synonym_build(Arena *a, const char *const *words, int n, SynonymTable *t) {
+    uint32_t buckets = (n + 3) / 4;   // About four words per bucket
+    uint32_t *first = arena_alloc(a, sizeof(uint32_t) * (buckets + 1));
+    uint32_t *fill = arena_alloc(a, sizeof(uint32_t) * buckets);
+    uint32_t *order = arena_alloc(a, sizeof(uint32_t) * buckets);
+    uint32_t *slots = arena_alloc(a, sizeof(uint32_t) * n);
+    int *members = arena_alloc(a, sizeof(int) * n);
+    t->seeds = arena_alloc(a, sizeof(uint32_t) * buckets);
+    if (!first || !fill || !order || !slots || !members || !t->seeds) return 0;
+    memset(first, 0, sizeof(uint32_t) * (buckets + 1));
+    memset(fill, 0, sizeof(uint32_t) * buckets);
+    memset(t->seeds, 0, sizeof(uint32_t) * buckets);
+
+    // Group words by bucket
+    for (int i = 0; i < n; i++) first[hash_seeded(words[i], 0) % buckets + 1]++;
+    uint32_t largest = 0;
+    for (uint32_t b = 0; b < buckets; b++) {
+        if (first[b + 1] > largest) largest = first[b + 1];
+        first[b + 1] += first[b];
+    }
+    for (int i = 0; i < n; i++) {
+        uint32_t b = hash_seeded(words[i], 0) % buckets;
+        members[first[b] + fill[b]++] = i;
+    }
+    // Equal words share a bucket and could never be separated
+    for (uint32_t b = 0; b < buckets; b++) {
+        for (uint32_t i = first[b]; i < first[b + 1]; i++) {
+            for (uint32_t j = first[b]; j < i; j++) {
+                if (strcmp(words[members[i]], words[members[j]]) == 0) return 0;
+            }
+        }
+    }
+
+    // Largest buckets first, while the table is emptiest
+    uint32_t ordered = 0;
+    for (uint32_t size = largest; size > 0; size--) {
+        for (uint32_t b = 0; b < buckets; b++) {
+            if (first[b + 1] - first[b] == size) order[ordered++] = b;
+        }
+    }
+
+    t->bucket_count = buckets;
+    for (t->slot_count = 8; t->slot_count < (uint32_t)n; t->slot_count *= 2) {}
+    for (; t->slot_count <= SYNONYM_MAX_SLOTS; t->slot_count *= 2) {
+        t->slot_word = arena_alloc(a, sizeof(int) * t->slot_count);
+        if (!t->slot_word) return 0;
+        memset(t->slot_word, -1, sizeof(int) * t->slot_count);
+        uint32_t i = 0;
+        while (i < ordered && synonym_place(t, words, members + first[order[i]],
+                                            first[order[i] + 1] - first[order[i]], order[i], slots)) {
+            i++;
+        }
+        if (i == ordered) return 1;
+    }
+    return 0;
+}
+
+// Canonical form of word under a table still being compiled
+static const char *synonym_find(const SynonymTable *t, const char *const *words,
+                                const char *const *canonicals, const char *word) {
+    if (t->slot_count == 0) return word;
+    int i = t->slot_word[synonym_slot(word, t->seeds, t->slot_count, t->bucket_count)];
+    return i >= 0 && strcmp(words[i], word) == 0 ? canonicals[i] : word;
+}
+
+// Whether a phrase in [from, to) already has exactly these word ids
+static int phrase_seen(const uint32_t *tokens, const uint32_t *phrase_first, const uint32_t *phrase_len,
+                       uint32_t from, uint32_t to, const uint32_t *ids, uint32_t n) {
+    for (uint32_t k = from; k < to; k++) {
+        if (phrase_len[k] == n && memcmp(tokens + phrase_first[k], ids, sizeof(uint32_t) * n) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+NLPPack *nlp_pack_compile(const NLPIntentDef *defs, int count,
+                          const NLPSynonymDef *synonyms, int synonym_count) {
+    if (count <= 0 || synonym_count < 0) return NULL;
+
+    Arena scratch;
+    arena_init(&scratch);
+
+    // Word and string counts bound every table below
+    uint32_t phrase_count = 0, max_words = 1, strings_size = 0;
+    for (int i = 0; i < count; i++) {
+        strings_size += strlen(defs[i].command_template) + strlen(defs[i].explanation) + 2;
+        for (int j = 0; j < defs[i].phrase_count; j++) {
+            const char *c = defs[i].phrases[j];
+            strings_size += strlen(c) + 1;
+            for (; *c; c++) {
+                if (*c == ' ') max_words++;
+            }
+            max_words++;
+            phrase_count++;
+        }
+    }
+    uint32_t slot_count = 64;
+    while (slot_count < max_words * 2) slot_count *= 2;
+
+    uint32_t *slots = arena_alloc(&scratch, sizeof(uint32_t) * slot_count);
+    const char **word_text = arena_alloc(&scratch, sizeof(char *) * max_words);
+    double *word_weight = arena_alloc(&scratch, sizeof(double) * max_words);
+    uint32_t *word_postings = arena_alloc(&scratch, sizeof(uint32_t) * max_words);
+    int *last_intent = arena_alloc(&scratch, sizeof(int) * max_words);
+    uint32_t *tokens = arena_alloc(&scratch, sizeof(uint32_t) * max_words);
+    uint32_t *phrase_first = arena_alloc(&scratch, sizeof(uint32_t) * (phrase_count + 1));
+    uint32_t *phrase_len = arena_alloc(&scratch, sizeof(uint32_t) * (phrase_count + 1));
+    uint32_t *phrase_intent = arena_alloc(&scratch, sizeof(uint32_t) * (phrase_count + 1));
+    const char **phrase_text = arena_alloc(&scratch, sizeof(char *) * (phrase_count + 1));
+    uint32_t *intent_first = arena_alloc(&scratch, sizeof(uint32_t) * count);
+    uint32_t *intent_phrases = arena_alloc(&scratch, sizeof(uint32_t) * count);
+    char (*syn_word)[NLP_MAX_TOKEN_LEN] = arena_alloc(&scratch, NLP_MAX_TOKEN_LEN * (synonym_count + 1));
+    char (*syn_canonical)[NLP_MAX_TOKEN_LEN] = arena_alloc(&scratch, NLP_MAX_TOKEN_LEN * (synonym_count + 1));
+    const char **syn_words = arena_alloc(&scratch, sizeof(char *) * (synonym_count + 1));
+    const char **syn_canonicals = arena_alloc(&scratch, sizeof(char *) * (synonym_count + 1));
+    if (!slots || !word_text || !word_weight || !word_postings || !last_intent || !tokens ||
+        !phrase_first || !phrase_len || !phrase_intent || !phrase_text || !intent_first ||
+        !intent_phrases || !syn_word || !syn_canonical || !syn_words || !syn_canonicals) {
+        arena_free(&scratch);
+        return NULL;
+    }
+    memset(slots, 0, sizeof(uint32_t) * slot_count);
+
+    // Synonyms are normalized like input words. A canonical form must not
+    // itself be a synonym, so normalizing once is enough.
+    SynonymTable syn = {NULL, NULL, 0, 0};
+    for (int i = 0; i < synonym_count; i++) {
+        normalize_token(synonyms[i].word, strlen(synonyms[i].word), syn_word[i]);
+        normalize_token(synonyms[i].canonical, strlen(synonyms[i].canonical), syn_canonical[i]);
+        syn_words[i] = syn_word[i];
+        syn_canonicals[i] = syn_canonical[i];
+        strings_size += strlen(syn_word[i]) + strlen(syn_canonical[i]) + 2;
+    }
+    if (synonym_count > 0 && !synonym_build(&scratch, syn_words, synonym_count, &syn)) {
+        arena_free(&scratch);
+        return NULL;
+    }
+    for (int i = 0; i < synonym_count; i++) {
+        if (synonym_find(&syn, syn_words, syn_canonicals, syn_canonicals[i]) != syn_canonicals[i]) {
+            arena_free(&scratch);
+            return NULL;
+        }
+    }
+
+    // Tokenize and normalize phrases, interning each word. Phrases that
+    // normalize to one already in the intent are dropped; weight starts
+    // as intent frequency.
+    uint32_t word_count = 1, token_count = 0, kept = 0;
+    for (int i = 0; i < count; i++) {
+        intent_first[i] = kept;
+        for (int j = 0; j < defs[i].phrase_count; j++) {
+            NLPToken toks[NLP_MAX_PHRASE_TOKENS];
+            int n = nlp_tokenize(defs[i].phrases[j], toks, NLP_MAX_PHRASE_TOKENS);
+            uint32_t *ids = tokens + token_count;
+
+            for (int t = 0; t < n; t++) {
+                const char *text = synonym_find(&syn, syn_words, syn_canonicals, toks[t].text);
+                uint32_t slot = hash_word(text) & (slot_count - 1);
+                while (slots[slot] && strcmp(word_text[slots[slot]], text) != 0) {
+                    slot = (slot + 1) & (slot_count - 1);
+                }
+                uint32_t id = slots[slot];
+                if (!id) {
+                    id = word_count++;
+                    size_t len = strlen(text) + 1;
+                    char *copy = arena_alloc(&scratch, len);
+                    if (!copy) {
+                        arena_free(&scratch);
+                        return NULL;
+                    }
+                    memcpy(copy, text, len);
+                    word_text[id] = copy;
+                    word_weight[id] = 0;
+                    word_postings[id] = 0;
+                    last_intent[id] = -1;
+                    slots[slot] = id;
+                    strings_size += len;
+                }
+                ids[t] = id;
+            }
+            // A duplicate only uses words already interned
+            if (phrase_seen(tokens, phrase_first, phrase_len, intent_first[i], kept, ids, n)) {
+                strings_size -= strlen(defs[i].phrases[j]) + 1;
+                continue;
+            }
+
+            for (int t = 0; t < n; t++) {
+                if (last_intent[ids[t]] != i) {
+                    word_weight[ids[t]] += 1;
+                    last_intent[ids[t]] = i;
+                }
+                word_postings[ids[t]]++;
+            }
+            phrase_first[kept] = token_count;
+            phrase_len[kept] = n;
+            phrase_intent[kept] = i;
+            phrase_text[kept] = defs[i].phrases[j];
+            token_count += n;
+            kept++;
+        }
+        intent_phrases[i] = kept - intent_first[i];
+    }
+    phrase_count = kept;
+
+    // Inverse intent frequency: words shared by many intents count less
+    for (uint32_t id = 1; id < word_count; id++) {
+        word_weight[id] = log(1.0 + (double)count / word_weight[id]);
+    }
+
+    AcAutomaton ac;
+    const uint32_t **seqs = arena_alloc(&scratch, sizeof(uint32_t *) * (phrase_count + 1));
+    if (!seqs) {
+        arena_free(&scratch);
+        return NULL;
+    }
+    for (uint32_t k = 0; k < phrase_count; k++) seqs[k] = tokens + phrase_first[k];
+    if (!ac_build_seq(&ac, (const uint32_t *const *)seqs, phrase_len, phrase_count)) {
+        arena_free(&scratch);
+        return NULL;
+    }
+
+    // Lay the image out section by section
+    NLPPackHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, NLP_PACK_MAGIC, 8);
+    h.version = NLP_PACK_VERSION;
+    h.intent_count = count;
+    h.phrase_count = phrase_count;
+    h.word_count = word_count;
+    h.slot_count = slot_count;
+    h.token_count = token_count;
+    h.state_count = ac.state_count;
+    h.edge_count = ac.edge_count;
+    h.strings_size = strings_size;
+    h.synonym_count = synonym_count;
+    h.synonym_slot_count = syn.slot_count;
+    h.synonym_bucket_count = syn.bucket_count;
+
+    size_t off = PACK_ALIGN(sizeof(NLPPackHeader));
+    h.off_intents = off;  off = PACK_ALIGN(off + sizeof(NLPPackIntent) * count);
+    h.off_phrases = off;  off = PACK_ALIGN(off + sizeof(NLPPackPhrase) * phrase_count);
+    h.off_tokens = off;   off = PACK_ALIGN(off + sizeof(uint32_t) * token_count);
+    h.off_words = off;    off = PACK_ALIGN(off + sizeof(NLPPackWord) * word_count);
+    h.off_slots = off;    off = PACK_ALIGN(off + sizeof(uint32_t) * slot_count);
+    h.off_postings = off; off = PACK_ALIGN(off + sizeof(NLPPosting) * token_count);
+    h.off_synonyms = off; off = PACK_ALIGN(off + sizeof(NLPPackSynonym) * syn.slot_count);
+    h.off_synonym_seeds = off; off = PACK_ALIGN(off + sizeof(uint32_t) * syn.bucket_count);
+    h.off_states = off;   off = PACK_ALIGN(off + sizeof(AcState) * ac.state_count);
+    h.off_edges = off;    off = PACK_ALIGN(off + sizeof(AcEdge) * ac.edge_count);
+    h.off_strings = off;  off = PACK_ALIGN(off + strings_size);
+    h.size = off;
+
+    char *image = calloc(1, off);
+    if (!image || off > UINT32_MAX) {
+        free(image);
+        ac_free(&ac);
+        arena_free(&scratch);
+        return NULL;
+    }
+    memcpy(image, &h, sizeof(h));
+
+    NLPPackIntent *intents = (NLPPackIntent *)(image + h.off_intents);
+    NLPPackPhrase *phrases = (NLPPackPhrase *)(image + h.off_phrases);
+    NLPPackWord *words = (NLPPackWord *)(image + h.off_words);
+    NLPPosting *postings = (NLPPosting *)(image + h.off_postings);
+    NLPPackSynonym *syn_slots = (NLPPackSynonym *)(image + h.off_synonyms);
+    char *pool = image + h.off_strings;
+    uint32_t pool_used = 0;
+
+    memcpy(image + h.off_tokens, tokens, sizeof(uint32_t) * token_count);
+    memcpy(image + h.off_slots, slots, sizeof(uint32_t) * slot_count);
+    memcpy(image + h.off_synonym_seeds, syn.seeds, sizeof(uint32_t) * syn.bucket_count);
+    memcpy(image + h.off_states, ac.states, sizeof(AcState) * ac.state_count);
+    memcpy(image + h.off_edges, ac.edges, sizeof(AcEdge) * ac.edge_count);
+    ac_free(&ac);
+
+    for (uint32_t s = 0; s < syn.slot_count; s++) {
+        int i = syn.slot_word[s];
+        syn_slots[s].word_str = i < 0 ? NLP_PACK_NO_STRING : pool_add(pool, &pool_used, syn_words[i]);
+        syn_slots[s].canonical_str = i < 0 ? NLP_PACK_NO_STRING : pool_add(pool, &pool_used, syn_canonicals[i]);
+    }
+
+    // Posting lists are contiguous, one run per word
+    uint32_t next_posting = 0;
+    for (uint32_t id = 1; id < word_count; id++) {
+        words[id].weight = word_weight[id];
+        words[id].text_str = pool_add(pool, &pool_used, word_text[id]);
+        words[id].first_posting = next_posting;
+        words[id].posting_count = 0;
+        next_posting += word_postings[id];
+    }
+
+    for (int i = 0; i < count; i++) {
+        intents[i].template_str = pool_add(pool, &pool_used, defs[i].command_template);
+        intents[i].explanation_str = pool_add(pool, &pool_used, defs[i].explanation);
+        intents[i].first_phrase = intent_first[i];
+        intents[i].phrase_count = intent_phrases[i];
+    }
+    for (uint32_t k = 0; k < phrase_count; k++) {
+        phrases[k].text_str = pool_add(pool, &pool_used, phrase_text[k]);
+        phrases[k].intent = phrase_intent[k];
+        phrases[k].first_token = phrase_first[k];
+        phrases[k].token_count = phrase_len[k];
+        phrases[k].weight = 0;
+        for (uint32_t t = 0; t < phrase_len[k]; t++) {
+            uint32_t id = tokens[phrase_first[k] + t];
+            NLPPosting *post = &postings[words[id].first_posting + words[id].posting_count++];
+            post->phrase = k;
+            post->pos = t;
+            phrases[k].weight += word_weight[id];
+        }
+    }
+    arena_free(&scratch);
+
+    NLPPack *pack = pack_view(image, h.size, 0);
+    if (!pack) free(image);
+    return pack;
+}
+
+// ============ Pattern Source Files ============
+// A line "> template | explanation" starts an intent; every following
+// non-blank line is one of its phrases. A line "= canonical | word word..."
+// normalizes each word to canonical. Lines starting with '#' are comments.
+
+static char *trim(char *s) {
+    while (isspace((unsigned char)*s)) s++;
+    char *end = s + strlen(s);
+    while (end > s && isspace((unsigned char)end[-1])) end--;
+    *end = '\0';
+    return s;
+}
+
+// Check "word -> canonical" against the pairs so far; a word may map to
+// only one form, and a canonical form may not be mapped itself
+static int synonym_conflict(const NLPSynonymDef *syn, int count, const char *word,
+                            const char *canonical, const char *path, int line_no) {
+    if (strcasecmp(word, canonical) == 0) {
+        fprintf(stderr, "%s:%d: '%s' maps to itself\n", path, line_no, word);
+        return 1;
+    }
+    for (int i = 0; i < count; i++) {
+        if (strcasecmp(syn[i].word, word) == 0) {
+            fprintf(stderr, "%s:%d: '%s' already maps to '%s'\n", path, line_no, word, syn[i].canonical);
+            return 1;
+        }
+        if (strcasecmp(syn[i].canonical, word) == 0 || strcasecmp(syn[i].word, canonical) == 0) {
+            fprintf(stderr, "%s:%d: '%s' is both a synonym and a canonical form\n", path, line_no,
+                    strcasecmp(syn[i].canonical, word) == 0 ? word : canonical);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Parse "= canonical | word word ..." into synonym pairs
+static int read_synonyms(char *s, NLPSynonymDef **syn, int *count, int *cap,
+                         const char *path, int line_no) {
+    char *bar = strchr(s, '|');
+    if (!bar) {
+        fprintf(stderr, "%s:%d: expected '= canonical | word...'\n", path, line_no);
+        return -1;
+    }
+    *bar = '\0';
+    const char *canonical = trim(s + 1);
+    if (!*canonical || strpbrk(canonical, " \t")) {
+        fprintf(stderr, "%s:%d: canonical form must be one word\n", path, line_no);
+        return -1;
+    }
+    char *save = NULL;
+    for (char *word = strtok_r(bar + 1, " \t", &save); word; word = strtok_r(NULL, " \t", &save)) {
+        if (synonym_conflict(*syn, *count, word, canonical, path, line_no)) return -1;
+        if (*count == *cap) {
+            *cap = *cap ? *cap * 2 : 64;
+            NLPSynonymDef *grown = realloc(*syn, sizeof(NLPSynonymDef) * *cap);
+            if (!grown) return -1;
+            *syn = grown;
+        }
+        (*syn)[*count].word = word;
+        (*syn)[*count].canonical = canonical;
+        (*count)++;
+    }
+    return 0;
+}
+
+int nlp_pack_read_source(const char *path, NLPSource *src) {
+    memset(src, 0, sizeof(*src));
+    FILE *fp = fopen(path, "r");
+    if (!fp) return -1;
+    errno = 0;
+    fseek(fp, 0, SEEK_END);
+    long len = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    char *text = malloc(len + 1);
+    if (!text || fread(text, 1, len, fp) != (size_t)len) {
+        fprintf(stderr, "%s: read failed\n", path);
+        free(text);
+        fclose(fp);
+        return -1;
+    }
+    text[len] = '\0';
+    fclose(fp);
+
+    // Phrases point into the text; intents record where their run starts
+    const char **phrases = NULL;
+    NLPIntentDef *defs = NULL;
+    int *first_phrase = NULL;
+    NLPSynonymDef *synonyms = NULL;
+    int phrase_count = 0, phrase_cap = 0, def_count = 0, def_cap = 0;
+    int synonym_count = 0, synonym_cap = 0;
+    int line_no = 0, status = 0;
+
+    char *line = text;
+    while (line && *line) {
+        char *next = strchr(line, '\n');
+        if (next) *next++ = '\0';
+        line_no++;
+        char *s = trim(line);
+        line = next;
+        if (!*s || *s == '#') continue;
+
+        if (*s == '=') {
+            status = read_synonyms(s, &synonyms, &synonym_count, &synonym_cap, path, line_no);
+            if (status != 0) break;
+            continue;
+        }
+
+        if (*s == '>') {
+            char *bar = strchr(s, '|');
+            if (!bar) {
+                fprintf(stderr, "%s:%d: expected '> template | explanation'\n", path, line_no);
+                status = -1;
+                break;
+            }
+            *bar = '\0';
+            if (def_count == def_cap) {
+                def_cap = def_cap ? def_cap * 2 : 32;
+                NLPIntentDef *grown = realloc(defs, sizeof(NLPIntentDef) * def_cap);
+                int *grown_first = realloc(first_phrase, sizeof(int) * def_cap);
+                if (grown) defs = grown;
+                if (grown_first) first_phrase = grown_first;
+                if (!grown || !grown_first) { status = -1; break; }
+            }
+            first_phrase[def_count] = phrase_count;
+            NLPIntentDef *d = &defs[def_count++];
+            d->command_template = trim(s + 1);
+            d->explanation = trim(bar + 1);
+            d->phrases = NULL;
+            d->phrase_count = 0;
+            continue;
+        }
+
+        if (def_count == 0) {
+            fprintf(stderr, "%s:%d: phrase before the first intent\n", path, line_no);
+            status = -1;
+            break;
+        }
+        NLPToken toks[NLP_MAX_PHRASE_TOKENS + 1];
+        int words = nlp_tokenize(s, toks, NLP_MAX_PHRASE_TOKENS + 1);
+        if (words == 0 || words > NLP_MAX_PHRASE_TOKENS) {
+            fprintf(stderr, "%s:%d: phrase must have 1 to %d words\n", path, line_no, NLP_MAX_PHRASE_TOKENS);
+            status = -1;
+            break;
+        }
+        if (phrase_count == phrase_cap) {
+            phrase_cap = phrase_cap ? phrase_cap * 2 : 256;
+            const char **grown = realloc(phrases, sizeof(char *) * phrase_cap);
+            if (!grown) { status = -1; break; }
+            phrases = grown;
+        }
+        phrases[phrase_count++] = s;
+        defs[def_count - 1].phrase_count++;
+    }
+
+    if (status == 0 && def_count == 0) {
+        fprintf(stderr, "%s: no intents defined\n", path);
+        status = -1;
+    }
+    if (status == 0) {
+        for (int i = 0; i < def_count; i++) {
+            defs[i].phrases = phrases + first_phrase[i];
+        }
+    }
+    free(first_phrase);
+
+    src->intents = defs;
+    src->intent_count = def_count;
+    src->phrases = phrases;
+    src->synonyms = synonyms;
+    src->synonym_count = synonym_count;
+    src->text = text;
+    if (status != 0) nlp_pack_free_source(src);
+    return status;
+}
+
+void nlp_pack_free_source(NLPSource *src) {
+    free(src->intents);
+    free(src->phrases);
+    free(src->synonyms);
+    free(src->text);
+    memset(src, 0, sizeof(*src));
+}
+
+int nlp_pack_compile_file(const char *source_path, const char *pack_path) {
+    NLPSource src;
+    if (nlp_pack_read_source(source_path, &src) != 0) {
+        if (errno) perror(source_path);
+        return -1;
+    }
+
+    NLPPack *pack = nlp_pack_compile(src.intents, src.intent_count, src.synonyms, src.synonym_count);
+    if (!pack) {
+        fprintf(stderr, "%s: failed to compile patterns\n", source_path);
+        nlp_pack_free_source(&src);
+        return -1;
+    }
+
+    // Write beside the target and rename, so readers never see a partial pack
+    int status = 0;
+    char tmp_path[4096];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", pack_path);
+    int fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    int ok = fd >= 0 && write(fd, pack->image, pack->size) == (ssize_t)pack->size;
+    if (fd >= 0 && close(fd) != 0) ok = 0;
+    if (!ok || rename(tmp_path, pack_path) != 0) {
+        perror(pack_path);
+        unlink(tmp_path);
+        status = -1;
+    } else {
+        printf("Compiled %d intents, %u phrases, %u words, %u synonyms into %s (%zu bytes)\n",
+               src.intent_count, pack->header->phrase_count, pack->header->word_count - 1,
+               pack->header->synonym_count, pack_path, pack->size);
+    }
+    nlp_pack_free(pack);
+    nlp_pack_free_source(&src);
+    return status;
+}
@@ -0,0 +1,363 @@
+/**
+ * NLP Slot Filling Implementation - Lexing, ranking and filling arguments
+ * Words are lexed with shell quoting rules, tagged as grammar words or
+ * pattern words, and scored per slot. Two-slot commands are split at a
+ * separator ("to", "and", "with", ...) and each side is ranked alone.
+ * Existence checks go through the directory cache, so ranking costs one
+ * stat per directory rather than one per candidate.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <limits.h>
+#include <unistd.h>
+#include "nlp_slots.h"
+#include "dircache.h"
+
+// Candidate score parts
+#define S_QUOTED        4.0
+#define S_MARKED        4.0      // Follows "called" or "named"
+#define S_PATH          2.0      // Has a '/' or an extension, or starts with '.' or '~'
+#define S_EXISTS        3.0      // Exists with the type the slot wants
+#define S_EXISTS_OTHER  1.0      // Exists with the other type
+#define S_LATER         0.1      // Per position: arguments tend to come last
+
+typedef enum { SLOT_ANY, SLOT_NEW, SLOT_FILE, SLOT_DIR, SLOT_TEXT } SlotKind;
+
+// What each slot of a command expects; unlisted commands take SLOT_ANY
+static const struct {
+    const char *command;
+    SlotKind kinds[NLP_MAX_SLOTS];
+} command_slots[] = {
+    {"mkdir", {SLOT_NEW}}, {"touch", {SLOT_NEW}},
+    {"cd", {SLOT_DIR}}, {"rmdir", {SLOT_DIR}},
+    {"rm", {SLOT_FILE}}, {"cat", {SLOT_FILE}}, {"head", {SLOT_FILE}}, {"tail", {SLOT_FILE}},
+    {"wc", {SLOT_FILE}}, {"fileinfo", {SLOT_FILE}}, {"backup", {SLOT_FILE}},
+    {"cp", {SLOT_FILE, SLOT_ANY}}, {"mv", {SLOT_FILE, SLOT_ANY}},
+    {"compare", {SLOT_FILE, SLOT_FILE}},
+    {"search", {SLOT_TEXT}}, {"calc", {SLOT_TEXT}}, {"quicknote", {SLOT_TEXT}},
+};
+static const int num_command_slots = sizeof(command_slots) / sizeof(command_slots[0]);
+
+static const char *stop_words[] = {
+    "a", "an", "the", "of", "in", "on", "at", "for", "to", "into", "from", "with", "and",
+    "as", "by", "my", "this", "that", "it", "me", "please", "called", "named", "some",
+    "all", "i", "is", "are", "its", "then"
+};
+static const int num_stop_words = sizeof(stop_words) / sizeof(stop_words[0]);
+
+// Split points between the two slots of cp, mv and compare
+static const char *slot_separators[] = {"to", "into", "and", "with", "as", "vs"};
+static const int num_slot_separators = sizeof(slot_separators) / sizeof(slot_separators[0]);
+
+// Verbs that name a two-slot command by themselves, and the words that
+// start their destination
+static const struct {
+    const char *verb;            // Canonical form
+    const char *command_template;
+} transfer_verbs[] = {
+    {"copy", "cp %s %s"}, {"move", "mv %s %s"}, {"rename", "mv %s %s"},
+};
+static const int num_transfer_verbs = sizeof(transfer_verbs) / sizeof(transfer_verbs[0]);
+static const char *transfer_separators[] = {"to", "into", "as"};
+static const int num_transfer_separators = sizeof(transfer_separators) / sizeof(transfer_separators[0]);
+
+// Checked for every lexed word, so the first letter screens out most calls
+static int in_list(const char *word, const char **list, int count) {
+    for (int i = 0; i < count; i++) {
+        if (list[i][0] == word[0] && strcmp(word, list[i]) == 0) return 1;
+    }
+    return 0;
+}
+
+// ============ Lexing ============
+
+// Drop sentence punctuation ("main.c?" -> "main.c"), keeping "." and ".."
+static void trim_punctuation(char *text) {
+    size_t n = strlen(text);
+    while (n > 0 && strchr(",;:!?)", text[n - 1])) n--;
+    if (n > 1 && text[n - 1] == '.' && text[n - 2] != '.') n--;
+    text[n] = '\0';
+}
+
+// Shell-style words, split as the shell's parse_command splits them: '...'
+// and "..." group, a backslash escapes a space or a quote, and an
+// apostrophe inside a word ("what's") is just a letter
+static int lex_words(const NLPPack *pack, const char *input, NLPSlotWord *words, int max) {
+    int count = 0;
+    const char *p = input;
+    while (*p && count < max) {
+        while (isspace((unsigned char)*p)) p++;
+        if (!*p) break;
+
+        NLPSlotWord *w = &words[count];
+        w->start = p - input;
+        w->quoted = w->stop = w->pattern = w->marked = 0;
+        w->type = -1;
+        size_t n = 0;
+        char quote = 0;
+        while (*p && (quote || !isspace((unsigned char)*p))) {
+            char c = *p++;
+            if (quote) {
+                if (c == quote) {
+                    quote = 0;
+                    continue;
+                }
+                if (c == '\\' && quote == '"' && *p == '"') c = *p++;
+            } else if (c == '"' || (c == '\'' && n == 0)) {
+                quote = c;
+                w->quoted = 1;
+                continue;
+            } else if (c == '\\' && *p && strchr(" '\"", *p)) {
+                c = *p++;
+                w->quoted = 1;           // Escaped words are taken literally too
+            }
+            if (n < NLP_SLOT_LEN - 1) w->text[n++] = c;
+        }
+        w->text[n] = '\0';
+        w->end = p - input;
+        if (!w->quoted) trim_punctuation(w->text);
+        if (!w->text[0]) continue;
+
+        w->word[0] = '\0';
+        NLPToken token;
+        if (!w->quoted && nlp_tokenize(w->text, &token, 1) == 1) {
+            memcpy(w->word, token.text, sizeof(w->word));
+            w->stop = in_list(w->word, stop_words, num_stop_words);
+            w->pattern = nlp_pack_lookup(pack, nlp_pack_canonical(pack, w->word)) != 0;
+        }
+        if (count > 0 && (strcmp(words[count - 1].word, "called") == 0 ||
+                          strcmp(words[count - 1].word, "named") == 0)) {
+            w->marked = 1;
+        }
+        count++;
+    }
+    return count;
+}
+
+// ============ Ranking ============
+
+static int looks_like_path(const char *s) {
+    if (strchr(s, '/') || s[0] == '~' || (s[0] == '.' && s[1])) return 1;
+    const char *dot = strrchr(s, '.');
+    return dot && dot > s && isalnum((unsigned char)dot[1]);
+}
+
+// Relative words are joined to cwd here so the cache skips its getcwd;
+// cwd is fetched on the first lookup for a request
+static DirCacheType word_type(NLPSlotWord *w, char *cwd) {
+    if (w->type < 0) {
+        char path[PATH_MAX];
+        const char *home = getenv("HOME");
+        if (w->text[0] == '~' && (w->text[1] == '/' || !w->text[1]) && home) {
+            snprintf(path, sizeof(path), "%s%s", home, w->text + 1);
+            w->type = dircache_lookup(path);
+        } else if (w->text[0] != '/' && (cwd[0] || getcwd(cwd, PATH_MAX))) {
+            snprintf(path, sizeof(path), "%s/%s", cwd, w->text);
+            w->type = dircache_lookup(path);
+        } else {
+            w->type = dircache_lookup(w->text);
+        }
+    }
+    return w->type;
+}
+
+// Score of w for a slot, or a negative value if it cannot fill it. Pattern
+// words are only looked up when with_pattern is set.
+static double score_word(NLPSlotWord *w, int index, SlotKind kind, char *cwd, int with_pattern) {
+    if (w->stop && !w->quoted) return -1;
+    if (w->pattern && !w->quoted && !with_pattern) return -1;
+    int check = kind == SLOT_ANY || kind == SLOT_FILE || kind == SLOT_DIR;
+    DirCacheType type = check ? word_type(w, cwd) : DIRCACHE_NONE;
+    if (w->pattern && !w->quoted && type == DIRCACHE_NONE) return -1;
+
+    double score = S_LATER * index;
+    if (w->quoted) score += S_QUOTED;
+    if (w->marked) score += S_MARKED;
+    if (looks_like_path(w->text)) score += S_PATH;
+    if (type != DIRCACHE_NONE) {
+        int wanted = kind == SLOT_ANY || (kind == SLOT_DIR) == (type == DIRCACHE_DIR);
+        score += wanted ? S_EXISTS : S_EXISTS_OTHER;
+    }
+    return score;
+}
+
+// A file or directory slot filled with a word that names nothing on disk
+static int names_nothing(NLPSlotWord *w, SlotKind kind, char *cwd) {
+    return (kind == SLOT_FILE || kind == SLOT_DIR) && word_type(w, cwd) == DIRCACHE_NONE;
+}
+
+// Best candidate in words[from, to) other than skip; -1 if none. A lone
+// candidate needs no ranking, and pattern words ("file", "folder") are
+// checked on disk only when nothing else fits.
+static int best_word(NLPSlotWord *words, int from, int to, int skip, SlotKind kind, char *cwd) {
+    int best = -1, candidates = 0;
+    for (int i = from; i < to; i++) {
+        if (i != skip && (words[i].quoted || (!words[i].stop && !words[i].pattern))) {
+            best = i;
+            candidates++;
+        }
+    }
+    if (candidates == 1) return best;
+
+    best = -1;
+    for (int with_pattern = 0; with_pattern < 2 && best < 0; with_pattern++) {
+        double best_score = -1;
+        for (int i = from; i < to; i++) {
+            if (i == skip) continue;
+            double score = score_word(&words[i], i, kind, cwd, with_pattern);
+            if (score >= 0 && score >= best_score) {
+                best = i;
+                best_score = score;
+            }
+        }
+    }
+    return best;
+}
+
+// Free text: a quoted string, else everything from the first word that
+// is not part of the phrase ("add a note buy milk" -> "buy milk")
+static int fill_text(const char *input, NLPSlotWord *words, int count, char *out) {
+    for (int i = 0; i < count; i++) {
+        if (words[i].quoted) {
+            memcpy(out, words[i].text, strlen(words[i].text) + 1);
+            return 1;
+        }
+    }
+    for (int i = 0; i < count; i++) {
+        if (words[i].stop || words[i].pattern) continue;
+        int len = words[count - 1].end - words[i].start;
+        snprintf(out, NLP_SLOT_LEN, "%.*s", len, input + words[i].start);
+        trim_punctuation(out);
+        return out[0] != '\0';
+    }
+    return 0;
+}
+
+// ============ Filling ============
+
+void nlp_slot_input_init(NLPSlotInput *in, const NLPPack *pack, const char *input) {
+    in->pack = pack;
+    in->input = input;
+    in->count = -1;
+    in->cwd[0] = '\0';
+    in->missing = 0;
+}
+
+int nlp_fill_slots(NLPSlotInput *in, const char *command_template,
+                   char out[NLP_MAX_SLOTS][NLP_SLOT_LEN]) {
+    int slots = 0;
+    for (const char *p = strstr(command_template, "%s"); p; p = strstr(p + 2, "%s")) slots++;
+    if (slots == 0 || slots > NLP_MAX_SLOTS) return 0;
+
+    SlotKind kinds[NLP_MAX_SLOTS] = {SLOT_ANY, SLOT_ANY};
+    size_t name_len = strcspn(command_template, " ");
+    for (int i = 0; i < num_command_slots; i++) {
+        if (strlen(command_slots[i].command) == name_len &&
+            strncmp(command_slots[i].command, command_template, name_len) == 0) {
+            memcpy(kinds, command_slots[i].kinds, sizeof(kinds));
+            break;
+        }
+    }
+
+    if (in->count < 0) in->count = lex_words(in->pack, in->input, in->words, NLP_SLOT_MAX_WORDS);
+    NLPSlotWord *words = in->words;
+    int count = in->count;
+    char *cwd = in->cwd;
+    in->missing = 0;
+    if (slots == 1 && kinds[0] == SLOT_TEXT) return fill_text(in->input, words, count, out[0]);
+
+    if (slots == 1) {
+        int best = best_word(words, 0, count, -1, kinds[0], cwd);
+        if (best < 0) return 0;
+        in->missing = names_nothing(&words[best], kinds[0], cwd);
+        memcpy(out[0], words[best].text, strlen(words[best].text) + 1);
+        return 1;
+    }
+
+    // Two slots: the first separator with a candidate on each side
+    int first = -1, second = -1;
+    for (int s = 1; s < count - 1 && second < 0; s++) {
+        if (!in_list(words[s].word, slot_separators, num_slot_separators)) continue;
+        first = best_word(words, 0, s, -1, kinds[0], cwd);
+        second = first < 0 ? -1 : best_word(words, s + 1, count, -1, kinds[1], cwd);
+    }
+    // No separator ("compare a.txt b.txt"): the two best, in input order
+    if (first < 0 || second < 0) {
+        first = best_word(words, 0, count, -1, kinds[0], cwd);
+        second = first < 0 ? -1 : best_word(words, 0, count, first, kinds[1], cwd);
+        if (second < first) {
+            int t = first;
+            first = second;
+            second = t;
+        }
+    }
+    if (first < 0 || second < 0) return 0;
+    in->missing = names_nothing(&words[first], kinds[0], cwd) || names_nothing(&words[second], kinds[1], cwd);
+    memcpy(out[0], words[first].text, strlen(words[first].text) + 1);
+    memcpy(out[1], words[second].text, strlen(words[second].text) + 1);
+    return 2;
+}
+
+const char *nlp_fill_transfer(NLPSlotInput *in, char out[NLP_MAX_SLOTS][NLP_SLOT_LEN]) {
+    // The verb is checked before lexing, so other requests pay one token
+    NLPToken verb;
+    if (nlp_tokenize(in->input, &verb, 1) != 1) return NULL;
+    const char *canonical = nlp_pack_canonical(in->pack, verb.text);
+    const char *command_template = NULL;
+    for (int i = 0; i < num_transfer_verbs && !command_template; i++) {
+        if (strcmp(canonical, transfer_verbs[i].verb) == 0) command_template = transfer_verbs[i].command_template;
+    }
+    if (!command_template) return NULL;
+
+    in->missing = 0;
+    if (in->count < 0) in->count = lex_words(in->pack, in->input, in->words, NLP_SLOT_MAX_WORDS);
+    NLPSlotWord *words = in->words;
+    int count = in->count;
+    for (int s = 2; s < count - 1; s++) {
+        if (words[s].quoted || !in_list(words[s].word, transfer_separators, num_transfer_separators)) continue;
+
+        // The source must be unmistakable: quoted or shaped like a path
+        int source = -1;
+        for (int i = 1; i < s && source < 0; i++) {
+            if (words[i].quoted || (!words[i].stop && looks_like_path(words[i].text))) source = i;
+        }
+        if (source < 0) return NULL;
+
+        // After the separator any word will do, pattern words included:
+        // "to backup" names a destination, not the backup command
+        int destination = best_word(words, s + 1, count, -1, SLOT_ANY, in->cwd);
+        for (int i = s + 1; i < count && destination < 0; i++) {
+            if (!words[i].stop || words[i].quoted) destination = i;
+        }
+        if (destination < 0) return NULL;
+
+        in->missing = names_nothing(&words[source], SLOT_FILE, in->cwd);
+        memcpy(out[0], words[source].text, strlen(words[source].text) + 1);
+        memcpy(out[1], words[destination].text, strlen(words[destination].text) + 1);
+        return command_template;
+    }
+    return NULL;
+}
+
+void nlp_shell_quote(const char *arg, char *out, size_t size) {
+    if (!strpbrk(arg, " \t'\"")) {
+        snprintf(out, size, "%s", arg);
+        return;
+    }
+    if (!strchr(arg, '\'')) {
+        snprintf(out, size, "'%s'", arg);
+        return;
+    }
+    // Double quotes, escaping "
+    size_t n = 0;
+    if (n + 1 < size) out[n++] = '"';
+    for (const char *p = arg; *p && n + 3 < size; p++) {
+        if (*p == '"') out[n++] = '\\';
+        out[n++] = *p;
+    }
+    if (n + 1 < size) out[n++] = '"';
+    out[n < size ? n : size - 1] = '\0';
+}
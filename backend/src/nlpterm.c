@@ -0,0 +1,186 @@
+/**
+ * libnlpterm Implementation - Stable C API over the shell's engines
+ * The NLP engine is thread-safe on its own. The suggestion engine, trie
+ * and BK-tree keep unlocked state, so calls into them are serialized.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "nlpterm.h"
+#include "nlp_engine.h"
+#include "suggestion_engine.h"
+#include "trie.h"
+#include "bktree.h"
+#include "sysmon_advanced.h"
+#include "strpool.h"
+#include "builtin_commands.h"
+
+#define MAX_MATCHES 128          // More than the built-in command count
+
+static pthread_mutex_t engine_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t init_once = PTHREAD_ONCE_INIT;
+static const char *init_pack_path = NULL;
+static TrieNode *command_trie = NULL;
+static BKTreeNode *command_bktree = NULL;
+
+static void init_engines(void) {
+    if (init_pack_path) nlp_set_pack_path(init_pack_path);
+    strpool_init();
+    nlp_init();
+    suggestion_init();
+    command_trie = create_node();
+    for (int i = 0; i < num_builtin_commands; i++) {
+        insert_trie(command_trie, builtin_commands[i]);
+        insert_bktree(&command_bktree, builtin_commands[i]);
+    }
+}
+
+static void ensure_init(void) {
+    pthread_once(&init_once, init_engines);
+}
+
+// Join items with '|' into out; returns how many fit
+static int join_list(char **items, int count, char *out, size_t size) {
+    if (!out || size == 0) return 0;
+    size_t used = 0;
+    int written = 0;
+    out[0] = '\0';
+    for (int i = 0; i < count; i++) {
+        size_t len = strlen(items[i]) + (written ? 1 : 0);
+        if (used + len >= size) break;
+        used += snprintf(out + used, size - used, "%s%s", written ? "|" : "", items[i]);
+        written++;
+    }
+    return written;
+}
+
+static int join_suggestions(const SuggestionList *list, char *out, size_t size) {
+    char *items[MAX_SUGGESTIONS];
+    for (int i = 0; i < list->count; i++) items[i] = (char *)list->suggestions[i];
+    return join_list(items, list->count, out, size);
+}
+
+// ============ API ============
+
+int nlpterm_version(void) {
+    return NLPTERM_API_VERSION;
+}
+
+int nlpterm_init(const char *pack_path) {
+    pthread_mutex_lock(&engine_lock);
+    if (!init_pack_path && pack_path) init_pack_path = strdup(pack_path);
+    pthread_mutex_unlock(&engine_lock);
+    ensure_init();
+    return command_trie ? 0 : -1;
+}
+
+int nlpterm_translate(const char *input, char *command, size_t command_size,
+                      char *explanation, size_t explanation_size, double *confidence) {
+    if (!input || !command || command_size == 0) return 0;
+    ensure_init();
+    NLPResult result = nlp_translate(input);
+    if (!result.was_translated) {
+        command[0] = '\0';
+        return 0;
+    }
+    snprintf(command, command_size, "%s", result.translated);
+    if (explanation && explanation_size) snprintf(explanation, explanation_size, "%s", result.explanation);
+    if (confidence) *confidence = result.confidence;
+    return result.suggest_only ? 2 : 1;
+}
+
+double nlpterm_classify(const char *input) {
+    ensure_init();
+    return nlp_classify(input);
+}
+
+int nlpterm_suggest(const char *partial, char *out, size_t size) {
+    SuggestionList list;
+    ensure_init();
+    pthread_mutex_lock(&engine_lock);
+    if (!partial || !*partial) suggestion_get_predictions(&list);
+    else suggestion_get_commands(partial, &list);
+    pthread_mutex_unlock(&engine_lock);
+    // The NLP engine locks its own tables
+    if (partial && *partial) nlp_complete_phrases(partial, &list);
+    return join_suggestions(&list, out, size);
+}
+
+int nlpterm_suggest_context(const char *cmd, const char *partial, const char *cwd,
+                            char *out, size_t size) {
+    if (!cmd) return 0;
+    if (!partial) partial = "";
+    ensure_init();
+
+    // Complete "cwd/partial" and strip the cwd back off the results
+    char path[1024];
+    size_t strip = 0;
+    if (cwd && *cwd && partial[0] != '/') {
+        int len = snprintf(path, sizeof(path), "%s/%s", cwd, partial);
+        if (len < 0 || (size_t)len >= sizeof(path)) return 0;
+        strip = strlen(cwd) + 1;
+        partial = path;
+    }
+
+    SuggestionList list;
+    pthread_mutex_lock(&engine_lock);
+    suggestion_get_contextual(cmd, partial, &list);
+    pthread_mutex_unlock(&engine_lock);
+
+    char *items[MAX_SUGGESTIONS];
+    for (int i = 0; i < list.count; i++) {
+        items[i] = list.suggestions[i];
+        if (strip && strlen(items[i]) >= strip) items[i] += strip;
+    }
+    return join_list(items, list.count, out, size);
+}
+
+int nlpterm_complete(const char *prefix, char *out, size_t size) {
+    if (!prefix) return 0;
+    char *matches[MAX_MATCHES];
+    int count = 0;
+    ensure_init();
+    pthread_mutex_lock(&engine_lock);
+    get_suggestions(command_trie, prefix, matches, &count);
+    pthread_mutex_unlock(&engine_lock);
+    int written = join_list(matches, count, out, size);
+    for (int i = 0; i < count; i++) free(matches[i]);
+    return written;
+}
+
+int nlpterm_correct(const char *word, int max_distance, char *out, size_t size) {
+    if (!word) return 0;
+    char *matches[MAX_MATCHES];
+    int count = 0;
+    ensure_init();
+    pthread_mutex_lock(&engine_lock);
+    get_similar_words(command_bktree, word, max_distance, matches, &count);
+    pthread_mutex_unlock(&engine_lock);
+    int written = join_list(matches, count, out, size);
+    for (int i = 0; i < count; i++) free(matches[i]);
+    return written;
+}
+
+void nlpterm_add_history(const char *command) {
+    if (!command) return;
+    ensure_init();
+    pthread_mutex_lock(&engine_lock);
+    suggestion_add_to_history(command);
+    pthread_mutex_unlock(&engine_lock);
+}
+
+int nlpterm_sysinfo(NLPTermSysInfo *info) {
+    if (!info || info->size < sizeof(NLPTermSysInfo)) return -1;
+    CPUInfo cpu = sysmon_get_cpu_info();
+    MemoryInfo mem = sysmon_get_memory_info();
+    UptimeInfo up = sysmon_get_uptime();
+    info->num_cores = cpu.num_cores;
+    info->cpu_percent = cpu.usage_percent;
+    info->mem_total_bytes = mem.total_bytes;
+    info->mem_used_bytes = mem.used_bytes;
+    info->mem_percent = mem.usage_percent;
+    info->uptime_seconds = up.total_seconds;
+    return 0;
+}
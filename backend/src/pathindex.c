@@ -0,0 +1,846 @@
+/**
+ * Path Index Implementation - Parallel walk, flat index, fuzzy ranking
+ * Workers pull directories from a shared stack and record their listings
+ * in per-thread arenas; the listings are then sorted by directory and
+ * flattened, so each directory's paths are contiguous and a refresh can
+ * find the old listing by binary search. Indexes are immutable once
+ * built: a refresh builds a new one and swaps it in.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <limits.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include "pathindex.h"
+#include "dirlist.h"
+#include "arena.h"
+
+#define INDEX_MAGIC "NLPPIDX1"
+#define PARALLEL_MATCH_MIN 100000     // Smaller indexes are matched on one thread
+
+typedef struct {
+    uint64_t chars;                   // Folded characters present, see char_bit()
+    uint32_t path;                    // Offset into text
+    uint16_t len;
+    uint16_t base;                    // Where the last component starts
+    uint32_t is_dir;
+} IndexEntry;
+
+typedef struct {
+    uint32_t path;                    // Offset into text; "" for the root
+    uint32_t len;
+    uint32_t first;                   // Its entries
+    uint32_t count;
+    int64_t mtime_sec;
+    int64_t mtime_nsec;
+    uint64_t ino;
+} IndexDir;
+
+typedef struct {
+    char root[PATH_MAX];
+    IndexEntry *entries;
+    uint32_t entry_count;
+    IndexDir *dirs;                   // Sorted by path
+    uint32_t dir_count;
+    char *text;
+    uint64_t text_len;
+    int truncated;
+    double refreshed_ms;              // 0 when loaded from disk
+} PathIndex;
+
+typedef struct {
+    char magic[8];
+    uint32_t entry_count;
+    uint32_t dir_count;
+    uint64_t text_len;
+    uint32_t truncated;
+    uint32_t entry_size;              // Layout check
+    char root[PATH_MAX];
+} IndexFileHeader;
+
+static PathIndex *current = NULL;
+static PathIndexStats last_stats;
+static int refresh_running = 0;
+static pthread_mutex_t index_lock = PTHREAD_MUTEX_INITIALIZER;    // current, last_stats
+static pthread_mutex_t refresh_lock = PTHREAD_MUTEX_INITIALIZER;  // One refresh at a time; before index_lock
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static int thread_count(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    if (n < 1) n = 1;
+    return n > PATHINDEX_MAX_THREADS ? PATHINDEX_MAX_THREADS : (int)n;
+}
+
+static int fold(int c) {
+    return c >= 'A' && c <= 'Z' ? c + 32 : c;
+}
+
+// Letters and digits get a bit each; everything else shares the rest
+static int char_bit(unsigned char c) {
+    c = fold(c);
+    if (c >= 'a' && c <= 'z') return c - 'a';
+    if (c >= '0' && c <= '9') return 26 + c - '0';
+    return 36 + c % 28;
+}
+
+static uint64_t char_mask(const char *s, size_t len) {
+    uint64_t mask = 0;
+    for (size_t i = 0; i < len; i++) mask |= 1ull << char_bit(s[i]);
+    return mask;
+}
+
+static void index_free(PathIndex *index) {
+    if (!index) return;
+    free(index->entries);
+    free(index->dirs);
+    free(index->text);
+    free(index);
+}
+
+static const IndexDir *find_dir(const PathIndex *index, const char *path) {
+    uint32_t lo = 0, hi = index->dir_count;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        int c = strcmp(index->text + index->dirs[mid].path, path);
+        if (c == 0) return &index->dirs[mid];
+        if (c < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    return NULL;
+}
+
+// ============ Parallel Walk ============
+
+typedef struct {
+    const char *rel;                  // "" for the root
+    uint32_t rel_len;
+    uint32_t first_child;
+    uint32_t child_count;
+    int64_t mtime_sec;
+    int64_t mtime_nsec;
+    uint64_t ino;
+} WalkDir;
+
+typedef struct {
+    const char *name;
+    uint32_t len;
+    uint32_t is_dir;
+} WalkChild;
+
+// One per worker, so recording a listing takes no lock
+typedef struct {
+    Arena arena;
+    DirList list;                     // Reused for every directory read
+    WalkDir *dirs;
+    uint32_t dir_count, dir_cap;
+    WalkChild *children;
+    uint32_t child_count, child_cap;
+    uint32_t dirs_read;
+    int failed;
+} WalkOutput;
+
+typedef struct {
+    const char **stack;               // Directories waiting to be visited
+    uint32_t count, cap;
+    int active;                       // Workers visiting a directory
+    int failed;
+    uint32_t entries;                 // Recorded so far, for the cap
+    int truncated;
+    int root_fd;
+    dev_t dev;
+    const PathIndex *old;             // Listings to reuse, may be NULL
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+} WalkQueue;
+
+typedef struct {
+    WalkQueue *queue;
+    WalkOutput out;
+} WalkWorker;
+
+static int add_child(WalkOutput *out, const char *name, uint32_t len, int is_dir) {
+    if (out->child_count == out->child_cap) {
+        uint32_t cap = out->child_cap ? out->child_cap * 2 : 1024;
+        WalkChild *grown = realloc(out->children, sizeof(WalkChild) * cap);
+        if (!grown) return -1;
+        out->children = grown;
+        out->child_cap = cap;
+    }
+    WalkChild *c = &out->children[out->child_count++];
+    c->name = name;
+    c->len = len;
+    c->is_dir = is_dir;
+    return 0;
+}
+
+static void queue_push(WalkQueue *q, const char **dirs, int count) {
+    pthread_mutex_lock(&q->lock);
+    if (q->count + count > q->cap) {
+        uint32_t cap = q->cap * 2 > q->count + count ? q->cap * 2 : q->count + count;
+        const char **grown = realloc(q->stack, sizeof(char *) * cap);
+        if (grown) {
+            q->stack = grown;
+            q->cap = cap;
+        }
+    }
+    if (q->count + count <= q->cap) {
+        memcpy(q->stack + q->count, dirs, sizeof(char *) * count);
+        q->count += count;
+    } else {
+        q->failed = 1;
+    }
+    pthread_cond_broadcast(&q->wake);
+    pthread_mutex_unlock(&q->lock);
+}
+
+static void visit(WalkQueue *q, WalkOutput *out, const char *rel) {
+    const char *at = rel[0] ? rel : ".";
+    struct stat st;
+    if (fstatat(q->root_fd, at, &st, AT_SYMLINK_NOFOLLOW) != 0 || !S_ISDIR(st.st_mode) ||
+        st.st_dev != q->dev) {
+        return;
+    }
+    if (out->dir_count == out->dir_cap) {
+        uint32_t cap = out->dir_cap ? out->dir_cap * 2 : 256;
+        WalkDir *grown = realloc(out->dirs, sizeof(WalkDir) * cap);
+        if (!grown) {
+            out->failed = 1;
+            return;
+        }
+        out->dirs = grown;
+        out->dir_cap = cap;
+    }
+    uint32_t d = out->dir_count++;
+    WalkDir *dir = &out->dirs[d];
+    dir->rel = rel;
+    dir->rel_len = strlen(rel);
+    dir->first_child = out->child_count;
+    dir->mtime_sec = st.st_mtim.tv_sec;
+    dir->mtime_nsec = st.st_mtim.tv_nsec;
+    dir->ino = st.st_ino;
+
+    // An unchanged directory keeps its old listing; its names stay in the
+    // old index's text, which outlives the walk
+    const IndexDir *prev = q->old ? find_dir(q->old, rel) : NULL;
+    if (prev && prev->mtime_sec == dir->mtime_sec && prev->mtime_nsec == dir->mtime_nsec &&
+        prev->ino == dir->ino) {
+        for (uint32_t i = prev->first; i < prev->first + prev->count; i++) {
+            const IndexEntry *e = &q->old->entries[i];
+            if (add_child(out, q->old->text + e->path + e->base, e->len - e->base, e->is_dir) != 0) {
+                out->failed = 1;
+                break;
+            }
+        }
+    } else {
+        if (dirlist_readat(&out->list, q->root_fd, at) == 0) {
+            out->dirs_read++;
+            for (size_t i = 0; i < out->list.count; i++) {
+                const DirListEntry *e = &out->list.entries[i];
+                if (e->name[0] == '.') continue;   // Hidden, like most finders
+                size_t len = strlen(e->name);
+                char *name = arena_alloc(&out->arena, len + 1);
+                if (!name || add_child(out, name, len, e->type == DT_DIR) != 0) {
+                    out->failed = 1;
+                    break;
+                }
+                memcpy(name, e->name, len + 1);
+            }
+        }
+        // A change in the same clock tick as this read would leave the
+        // mtime as it is, so a listing that fresh is read again next time
+        if (time(NULL) - st.st_mtim.tv_sec < 2) out->dirs[d].mtime_nsec = -1;
+    }
+    dir = &out->dirs[d];
+    dir->child_count = out->child_count - dir->first_child;
+
+    // Queue the subdirectories in one go
+    uint32_t total = __atomic_add_fetch(&q->entries, dir->child_count, __ATOMIC_RELAXED);
+    if (total > PATHINDEX_MAX_ENTRIES) {
+        q->truncated = 1;
+        return;
+    }
+    const char *subdirs[256];
+    int pending = 0;
+    for (uint32_t i = dir->first_child; i < dir->first_child + dir->child_count; i++) {
+        const WalkChild *c = &out->children[i];
+        if (!c->is_dir) continue;
+        size_t len = dir->rel_len + (dir->rel_len ? 1 : 0) + c->len;
+        if (len >= PATHINDEX_PATH_MAX) continue;
+        char *sub = arena_alloc(&out->arena, len + 1);
+        if (!sub) {
+            out->failed = 1;
+            break;
+        }
+        if (dir->rel_len) {
+            memcpy(sub, dir->rel, dir->rel_len);
+            sub[dir->rel_len] = '/';
+        }
+        memcpy(sub + len - c->len, c->name, c->len + 1);
+        subdirs[pending++] = sub;
+        if (pending == 256) {
+            queue_push(q, subdirs, pending);
+            pending = 0;
+        }
+    }
+    if (pending) queue_push(q, subdirs, pending);
+}
+
+static void *walk_worker(void *arg) {
+    WalkWorker *w = arg;
+    WalkQueue *q = w->queue;
+    for (;;) {
+        pthread_mutex_lock(&q->lock);
+        while (q->count == 0 && q->active > 0) pthread_cond_wait(&q->wake, &q->lock);
+        if (q->count == 0) {
+            // Nothing queued and nobody left to queue more
+            pthread_cond_broadcast(&q->wake);
+            pthread_mutex_unlock(&q->lock);
+            return NULL;
+        }
+        const char *rel = q->stack[--q->count];
+        q->active++;
+        pthread_mutex_unlock(&q->lock);
+
+        visit(q, &w->out, rel);
+
+        pthread_mutex_lock(&q->lock);
+        q->active--;
+        if (w->out.failed) q->failed = 1;
+        if (q->count == 0 && q->active == 0) pthread_cond_broadcast(&q->wake);
+        pthread_mutex_unlock(&q->lock);
+    }
+}
+
+// ============ Assembly ============
+
+typedef struct {
+    const WalkDir *dir;
+    const WalkOutput *out;
+} DirRef;
+
+static int compare_dir_refs(const void *a, const void *b) {
+    return strcmp(((const DirRef *)a)->dir->rel, ((const DirRef *)b)->dir->rel);
+}
+
+// Flatten the workers' listings into an index, directories in path order
+static PathIndex *assemble(const char *root, WalkWorker *workers, int threads, int truncated) {
+    uint32_t dir_count = 0, entry_count = 0;
+    uint64_t text_len = 0;
+    for (int t = 0; t < threads; t++) {
+        const WalkOutput *out = &workers[t].out;
+        dir_count += out->dir_count;
+        for (uint32_t d = 0; d < out->dir_count; d++) {
+            const WalkDir *dir = &out->dirs[d];
+            text_len += dir->rel_len + 1;
+            entry_count += dir->child_count;
+            for (uint32_t i = dir->first_child; i < dir->first_child + dir->child_count; i++) {
+                text_len += dir->rel_len + (dir->rel_len ? 1 : 0) + out->children[i].len + 1;
+            }
+        }
+    }
+
+    PathIndex *index = calloc(1, sizeof(PathIndex));
+    DirRef *refs = malloc(sizeof(DirRef) * (dir_count + 1));
+    if (index) {
+        index->entries = malloc(sizeof(IndexEntry) * (entry_count + 1));
+        index->dirs = malloc(sizeof(IndexDir) * (dir_count + 1));
+        index->text = malloc(text_len + 1);
+    }
+    if (!index || !refs || !index->entries || !index->dirs || !index->text || text_len > UINT32_MAX) {
+        free(refs);
+        index_free(index);
+        return NULL;
+    }
+    snprintf(index->root, sizeof(index->root), "%s", root);
+    index->truncated = truncated;
+
+    uint32_t r = 0;
+    for (int t = 0; t < threads; t++) {
+        for (uint32_t d = 0; d < workers[t].out.dir_count; d++) {
+            refs[r].dir = &workers[t].out.dirs[d];
+            refs[r].out = &workers[t].out;
+            r++;
+        }
+    }
+    qsort(refs, dir_count, sizeof(DirRef), compare_dir_refs);
+
+    char *text = index->text;
+    uint64_t used = 0;
+    for (uint32_t i = 0; i < dir_count; i++) {
+        const WalkDir *dir = refs[i].dir;
+        IndexDir *id = &index->dirs[index->dir_count++];
+        id->path = used;
+        id->len = dir->rel_len;
+        memcpy(text + used, dir->rel, dir->rel_len + 1);
+        used += dir->rel_len + 1;
+        id->first = index->entry_count;
+        id->count = dir->child_count;
+        id->mtime_sec = dir->mtime_sec;
+        id->mtime_nsec = dir->mtime_nsec;
+        id->ino = dir->ino;
+
+        for (uint32_t c = dir->first_child; c < dir->first_child + dir->child_count; c++) {
+            const WalkChild *child = &refs[i].out->children[c];
+            IndexEntry *e = &index->entries[index->entry_count++];
+            e->path = used;
+            e->base = dir->rel_len ? dir->rel_len + 1 : 0;
+            e->len = e->base + child->len;
+            e->is_dir = child->is_dir;
+            if (dir->rel_len) {
+                memcpy(text + used, dir->rel, dir->rel_len);
+                text[used + dir->rel_len] = '/';
+            }
+            memcpy(text + used + e->base, child->name, child->len);
+            text[used + e->len] = '\0';
+            e->chars = char_mask(text + used, e->len);
+            used += e->len + 1;
+        }
+    }
+    index->text_len = used;
+    free(refs);
+    return index;
+}
+
+// Walk root with a worker per core. Listings of directories unchanged since
+// old are reused rather than read.
+static PathIndex *index_build(const char *root, const PathIndex *old, PathIndexStats *stats) {
+    double t0 = now_ms();
+    int root_fd = open(root, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    struct stat st;
+    if (root_fd < 0) return NULL;
+    if (fstat(root_fd, &st) != 0) {
+        close(root_fd);
+        return NULL;
+    }
+
+    WalkQueue q;
+    memset(&q, 0, sizeof(q));
+    q.root_fd = root_fd;
+    q.dev = st.st_dev;
+    q.old = old && strcmp(old->root, root) == 0 ? old : NULL;
+    q.cap = 1024;
+    q.stack = malloc(sizeof(char *) * q.cap);
+    pthread_mutex_init(&q.lock, NULL);
+    pthread_cond_init(&q.wake, NULL);
+
+    int threads = thread_count();
+    WalkWorker *workers = calloc(threads, sizeof(WalkWorker));
+    PathIndex *index = NULL;
+    if (q.stack && workers) {
+        q.stack[q.count++] = "";
+        pthread_t tids[PATHINDEX_MAX_THREADS];
+        int started = 0;
+        for (int i = 0; i < threads; i++) {
+            workers[i].queue = &q;
+            arena_init(&workers[i].out.arena);
+            dirlist_init(&workers[i].out.list);
+        }
+        for (int i = 1; i < threads; i++) {
+            if (pthread_create(&tids[started], NULL, walk_worker, &workers[i]) == 0) started++;
+        }
+        walk_worker(&workers[0]);
+        for (int i = 0; i < started; i++) pthread_join(tids[i], NULL);
+
+        if (!q.failed) index = assemble(root, workers, threads, q.truncated);
+        if (index && stats) {
+            memset(stats, 0, sizeof(*stats));
+            for (int i = 0; i < threads; i++) stats->dirs_read += workers[i].out.dirs_read;
+            stats->paths = index->entry_count;
+            stats->dirs = index->dir_count;
+            stats->threads = started + 1;
+            stats->truncated = index->truncated;
+        }
+        for (int i = 0; i < threads; i++) {
+            arena_free(&workers[i].out.arena);
+            dirlist_free(&workers[i].out.list);
+            free(workers[i].out.dirs);
+            free(workers[i].out.children);
+        }
+    }
+    free(workers);
+    free(q.stack);
+    pthread_mutex_destroy(&q.lock);
+    pthread_cond_destroy(&q.wake);
+    close(root_fd);
+
+    if (index) {
+        index->refreshed_ms = now_ms();
+        if (stats) stats->refresh_ms = index->refreshed_ms - t0;
+    }
+    return index;
+}
+
+// ============ Persistence ============
+
+// The saved index for root; 0 if saving is disabled
+static int index_file(const char *root, char *path, size_t size, int create_dir) {
+    const char *env = getenv("NLP_PATH_INDEX_DIR");
+    const char *home = getenv("HOME");
+    char dir[PATH_MAX];
+    if (env && !*env) return 0;
+    if (env) snprintf(dir, sizeof(dir), "%s", env);
+    else if (home) snprintf(dir, sizeof(dir), "%s/%s", home, PATHINDEX_DIR);
+    else return 0;
+    if (create_dir) mkdir(dir, 0700);
+
+    uint64_t h = 14695981039346656037ull;
+    for (const unsigned char *p = (const unsigned char *)root; *p; p++) {
+        h ^= *p;
+        h *= 1099511628211ull;
+    }
+    snprintf(path, size, "%s/%016llx.idx", dir, (unsigned long long)h);
+    return 1;
+}
+
+// Write to a temporary name and rename, so readers never see half a file
+static void index_save(const PathIndex *index) {
+    char path[PATH_MAX + 32], tmp[PATH_MAX + 48];
+    if (!index_file(index->root, path, sizeof(path), 1)) return;
+    snprintf(tmp, sizeof(tmp), "%s.%d", path, (int)getpid());
+    FILE *fp = fopen(tmp, "wb");
+    if (!fp) return;
+
+    IndexFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, INDEX_MAGIC, sizeof(header.magic));
+    header.entry_count = index->entry_count;
+    header.dir_count = index->dir_count;
+    header.text_len = index->text_len;
+    header.truncated = index->truncated;
+    header.entry_size = sizeof(IndexEntry);
+    snprintf(header.root, sizeof(header.root), "%s", index->root);
+    int ok = fwrite(&header, sizeof(header), 1, fp) == 1 &&
+             fwrite(index->entries, sizeof(IndexEntry), index->entry_count, fp) == index->entry_count &&
+             fwrite(index->dirs, sizeof(IndexDir), index->dir_count, fp) == index->dir_count &&
+             fwrite(index->text, 1, index->text_len, fp) == index->text_len;
+    if (fclose(fp) != 0) ok = 0;
+    if (!ok || rename(tmp, path) != 0) unlink(tmp);
+}
+
+// Offsets in a saved file are checked before use; a damaged file is
+// rebuilt rather than trusted
+static int index_valid(const PathIndex *index) {
+    for (uint32_t i = 0; i < index->entry_count; i++) {
+        const IndexEntry *e = &index->entries[i];
+        if ((uint64_t)e->path + e->len >= index->text_len || e->base > e->len ||
+            index->text[e->path + e->len] != '\0') {
+            return 0;
+        }
+    }
+    for (uint32_t i = 0; i < index->dir_count; i++) {
+        const IndexDir *d = &index->dirs[i];
+        if ((uint64_t)d->path + d->len >= index->text_len || index->text[d->path + d->len] != '\0' ||
+            (uint64_t)d->first + d->count > index->entry_count) {
+            return 0;
+        }
+        if (i > 0 && strcmp(index->text + index->dirs[i - 1].path, index->text + d->path) >= 0) return 0;
+    }
+    return 1;
+}
+
+static PathIndex *index_load(const char *root) {
+    char path[PATH_MAX + 32];
+    if (!index_file(root, path, sizeof(path), 0)) return NULL;
+    FILE *fp = fopen(path, "rb");
+    if (!fp) return NULL;
+
+    IndexFileHeader header;
+    struct stat st;
+    PathIndex *index = NULL;
+    if (fread(&header, sizeof(header), 1, fp) == 1 && fstat(fileno(fp), &st) == 0 &&
+        memcmp(header.magic, INDEX_MAGIC, sizeof(header.magic)) == 0 &&
+        header.entry_size == sizeof(IndexEntry) &&
+        memchr(header.root, '\0', sizeof(header.root)) && strcmp(header.root, root) == 0 &&
+        (uint64_t)st.st_size == sizeof(header) + (uint64_t)header.entry_count * sizeof(IndexEntry) +
+                                (uint64_t)header.dir_count * sizeof(IndexDir) + header.text_len) {
+        index = calloc(1, sizeof(PathIndex));
+        if (index) {
+            snprintf(index->root, sizeof(index->root), "%s", root);
+            index->entry_count = header.entry_count;
+            index->dir_count = header.dir_count;
+            index->text_len = header.text_len;
+            index->truncated = header.truncated;
+            index->entries = malloc(sizeof(IndexEntry) * (header.entry_count + 1));
+            index->dirs = malloc(sizeof(IndexDir) * (header.dir_count + 1));
+            index->text = malloc(header.text_len + 1);
+            int ok = index->entries && index->dirs && index->text &&
+                     fread(index->entries, sizeof(IndexEntry), header.entry_count, fp) == header.entry_count &&
+                     fread(index->dirs, sizeof(IndexDir), header.dir_count, fp) == header.dir_count &&
+                     fread(index->text, 1, header.text_len, fp) == header.text_len &&
+                     index_valid(index);
+            if (!ok) {
+                index_free(index);
+                index = NULL;
+            }
+        }
+    }
+    fclose(fp);
+    return index;
+}
+
+// ============ Refresh ============
+
+// Make the index for root current, loading the saved copy if there is one
+// and refreshing anything older than PATHINDEX_REFRESH_MS. Caller holds
+// refresh_lock, so current only changes here.
+static void refresh_locked(const char *root) {
+    PathIndex *cur = current;
+    if (!cur || strcmp(cur->root, root) != 0) {
+        PathIndex *loaded = index_load(root);
+        pthread_mutex_lock(&index_lock);
+        PathIndex *dropped = current;
+        current = loaded;
+        pthread_mutex_unlock(&index_lock);
+        index_free(dropped);
+        cur = loaded;
+    }
+    if (cur && cur->refreshed_ms > 0 && now_ms() - cur->refreshed_ms < PATHINDEX_REFRESH_MS) return;
+
+    PathIndexStats stats;
+    PathIndex *built = index_build(root, cur, &stats);
+    if (!built) return;
+    pthread_mutex_lock(&index_lock);
+    current = built;
+    last_stats = stats;
+    pthread_mutex_unlock(&index_lock);
+    index_free(cur);
+    if (stats.dirs_read > 0 || !cur) index_save(built);
+}
+
+static void *refresh_thread(void *arg) {
+    pthread_mutex_lock(&refresh_lock);
+    refresh_locked(arg);
+    pthread_mutex_unlock(&refresh_lock);
+    pthread_mutex_lock(&index_lock);
+    refresh_running = 0;
+    pthread_mutex_unlock(&index_lock);
+    free(arg);
+    return NULL;
+}
+
+// Caller holds index_lock
+static void start_refresh(const char *root) {
+    if (refresh_running) return;
+    char *copy = strdup(root);
+    pthread_t tid;
+    pthread_attr_t attr;
+    if (!copy || pthread_attr_init(&attr) != 0) {
+        free(copy);
+        return;
+    }
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    if (pthread_create(&tid, &attr, refresh_thread, copy) == 0) refresh_running = 1;
+    else free(copy);
+    pthread_attr_destroy(&attr);
+}
+
+// ============ Matching ============
+
+typedef struct {
+    const char *text;
+    int len;
+    int exact_case;                   // The query has uppercase: match it exactly
+    uint64_t chars;
+    int dirs_only;
+} Query;
+
+typedef struct {
+    uint32_t entry;
+    int score;
+} Hit;
+
+typedef struct {
+    Hit *hits;
+    int count;
+    int max;
+} TopHits;
+
+static int same_char(char a, char b, int exact_case) {
+    return exact_case ? a == b : fold((unsigned char)a) == b;
+}
+
+// Score of path for the query, -1 if it is not a subsequence. The window
+// is the rightmost match, tightened from the left, which favours matches
+// in the last component. Matches at word starts and in runs score more;
+// gaps and long paths score less.
+static int score_path(const char *path, int len, int base, const Query *q) {
+    int qi = q->len - 1, start = -1;
+    for (int i = len - 1; i >= 0; i--) {
+        if (same_char(path[i], q->text[qi], q->exact_case) && --qi < 0) {
+            start = i;
+            break;
+        }
+    }
+    if (start < 0) return -1;
+
+    int score = 0, prev = -2;
+    qi = 0;
+    for (int i = start; i < len && qi < q->len; i++) {
+        if (!same_char(path[i], q->text[qi], q->exact_case)) {
+            score -= 1;
+            continue;
+        }
+        int s = 16;
+        char before = i > 0 ? path[i - 1] : '/';
+        if (before == '/') s += 12;
+        else if (before == '_' || before == '-' || before == '.' || before == ' ') s += 8;
+        else if (islower((unsigned char)before) && isupper((unsigned char)path[i])) s += 8;
+        if (prev == i - 1) s += 8;
+        score += s;
+        prev = i;
+        qi++;
+    }
+    if (start >= base) score += 32;
+
+    int name_len = len - base;
+    if (name_len >= q->len) {
+        int prefix = 1;
+        for (int i = 0; i < q->len && prefix; i++) prefix = same_char(path[base + i], q->text[i], q->exact_case);
+        if (prefix) score += name_len == q->len ? 64 : 24;
+    }
+    return score - len / 16;
+}
+
+static int hit_before(const PathIndex *index, const Hit *a, const Hit *b) {
+    if (a->score != b->score) return a->score > b->score;
+    const IndexEntry *ea = &index->entries[a->entry], *eb = &index->entries[b->entry];
+    if (ea->len != eb->len) return ea->len < eb->len;
+    return strcmp(index->text + ea->path, index->text + eb->path) < 0;
+}
+
+static void top_insert(const PathIndex *index, TopHits *top, Hit hit) {
+    if (top->count == top->max && !hit_before(index, &hit, &top->hits[top->count - 1])) return;
+    int pos = top->count < top->max ? top->count++ : top->count - 1;
+    while (pos > 0 && hit_before(index, &hit, &top->hits[pos - 1])) {
+        top->hits[pos] = top->hits[pos - 1];
+        pos--;
+    }
+    top->hits[pos] = hit;
+}
+
+static void match_range(const PathIndex *index, const Query *q, uint32_t from, uint32_t to, TopHits *top) {
+    for (uint32_t i = from; i < to; i++) {
+        const IndexEntry *e = &index->entries[i];
+        if ((q->chars & ~e->chars) || (q->dirs_only && !e->is_dir) || e->len < q->len) continue;
+        int score = score_path(index->text + e->path, e->len, e->base, q);
+        if (score >= 0) top_insert(index, top, (Hit){i, score});
+    }
+}
+
+typedef struct {
+    const PathIndex *index;
+    const Query *query;
+    uint32_t from, to;
+    TopHits top;
+} MatchJob;
+
+static void *match_worker(void *arg) {
+    MatchJob *job = arg;
+    match_range(job->index, job->query, job->from, job->to, &job->top);
+    return NULL;
+}
+
+// Best max entries; large indexes are split across threads and the
+// per-thread lists merged
+static int match_index(const PathIndex *index, const Query *q, Hit *hits, int max) {
+    TopHits top = {hits, 0, max};
+    int threads = index->entry_count >= PARALLEL_MATCH_MIN ? thread_count() : 1;
+    MatchJob jobs[PATHINDEX_MAX_THREADS];
+    Hit *scratch = threads > 1 ? malloc(sizeof(Hit) * max * threads) : NULL;
+    if (!scratch) {
+        match_range(index, q, 0, index->entry_count, &top);
+        return top.count;
+    }
+
+    pthread_t tids[PATHINDEX_MAX_THREADS];
+    int started[PATHINDEX_MAX_THREADS] = {0};
+    uint32_t chunk = index->entry_count / threads + 1;
+    for (int t = 0; t < threads; t++) {
+        jobs[t].index = index;
+        jobs[t].query = q;
+        jobs[t].from = t * chunk < index->entry_count ? t * chunk : index->entry_count;
+        jobs[t].to = jobs[t].from + chunk < index->entry_count ? jobs[t].from + chunk : index->entry_count;
+        jobs[t].top = (TopHits){scratch + t * max, 0, max};
+        if (t > 0) started[t] = pthread_create(&tids[t], NULL, match_worker, &jobs[t]) == 0;
+    }
+    match_worker(&jobs[0]);
+    for (int t = 1; t < threads; t++) {
+        if (started[t]) pthread_join(tids[t], NULL);
+        else match_worker(&jobs[t]);
+    }
+    for (int t = 0; t < threads; t++) {
+        for (int i = 0; i < jobs[t].top.count; i++) top_insert(index, &top, jobs[t].top.hits[i]);
+    }
+    free(scratch);
+    return top.count;
+}
+
+// ============ Queries ============
+
+int pathindex_find(const char *query, int dirs_only, int wait, PathMatch *out, int max) {
+    char root[PATH_MAX];
+    char folded[PATHINDEX_PATH_MAX];
+    if (!query || !*query || max <= 0 || !getcwd(root, sizeof(root))) return 0;
+
+    Query q = {folded, 0, 0, 0, dirs_only};
+    for (const char *p = query; *p && q.len < PATHINDEX_PATH_MAX - 1; p++) {
+        if (isupper((unsigned char)*p)) q.exact_case = 1;
+        folded[q.len++] = *p;
+    }
+    folded[q.len] = '\0';
+    if (!q.exact_case) {
+        for (int i = 0; i < q.len; i++) folded[i] = fold((unsigned char)folded[i]);
+    }
+    q.chars = char_mask(folded, q.len);
+
+    if (wait) {
+        pthread_mutex_lock(&refresh_lock);
+        refresh_locked(root);
+        pthread_mutex_unlock(&refresh_lock);
+    }
+
+    Hit *hits = malloc(sizeof(Hit) * max);
+    if (!hits) return 0;
+    int count = 0;
+    pthread_mutex_lock(&index_lock);
+    PathIndex *index = current;
+    if (!wait && (!index || strcmp(index->root, root) != 0 || index->refreshed_ms == 0 ||
+                  now_ms() - index->refreshed_ms >= PATHINDEX_REFRESH_MS)) {
+        start_refresh(root);
+    }
+    if (index && strcmp(index->root, root) == 0) {
+        int found = match_index(index, &q, hits, max);
+        for (int i = 0; i < found; i++) {
+            const IndexEntry *e = &index->entries[hits[i].entry];
+            memcpy(out[count].path, index->text + e->path, e->len + 1);
+            out[count].is_dir = e->is_dir;
+            out[count].score = hits[i].score;
+            count++;
+        }
+    }
+    pthread_mutex_unlock(&index_lock);
+    free(hits);
+    return count;
+}
+
+void pathindex_stats(PathIndexStats *stats) {
+    pthread_mutex_lock(&index_lock);
+    *stats = last_stats;
+    if (current) {
+        stats->paths = current->entry_count;
+        stats->dirs = current->dir_count;
+        stats->truncated = current->truncated;
+    }
+    pthread_mutex_unlock(&index_lock);
+}
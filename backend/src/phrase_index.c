@@ -0,0 +1,238 @@
+/**
+ * Phrase Index Implementation - Trie with per-node top-K completion lists
+ * Phrases are inserted in sorted order, so a node's children arrive in
+ * character order and flatten into sorted edge runs. Use counts only ever
+ * grow, which lets one use update the lists on the phrase's own path to
+ * the root without rescanning anything else.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "phrase_index.h"
+
+typedef struct {
+    const char *text;
+    uint32_t id;
+} SortedPhrase;
+
+// Build-time child links, flattened into edges afterwards
+typedef struct {
+    uint32_t first_child;
+    uint32_t last_child;
+    uint32_t next_sibling;
+    unsigned char ch;
+} NodeLinks;
+
+static int compare_text(const void *a, const void *b) {
+    const SortedPhrase *x = a, *y = b;
+    int c = strcmp(x->text, y->text);
+    if (c) return c;
+    return x->id < y->id ? -1 : x->id > y->id;
+}
+
+// Completion order: more uses, then shorter, then lower id
+static int ranks_before(const PhraseIndex *index, uint32_t a, uint32_t b) {
+    if (index->uses[a] != index->uses[b]) return index->uses[a] > index->uses[b];
+    if (index->lengths[a] != index->lengths[b]) return index->lengths[a] < index->lengths[b];
+    return a < b;
+}
+
+static int compare_rank(const void *a, const void *b, void *index) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    if (x == y) return 0;
+    return ranks_before(index, x, y) ? -1 : 1;
+}
+
+// ============ Construction ============
+
+static uint32_t add_node(PhraseIndex *index, NodeLinks **links, uint32_t *cap,
+                         uint32_t parent, unsigned char ch) {
+    if (index->node_count == *cap) {
+        *cap = *cap ? *cap * 2 : 256;
+        PhraseNode *nodes = realloc(index->nodes, sizeof(PhraseNode) * *cap);
+        if (!nodes) return 0;
+        index->nodes = nodes;
+        NodeLinks *grown = realloc(*links, sizeof(NodeLinks) * *cap);
+        if (!grown) return 0;
+        *links = grown;
+    }
+    uint32_t n = index->node_count++;
+    memset(&index->nodes[n], 0, sizeof(PhraseNode));
+    memset(&(*links)[n], 0, sizeof(NodeLinks));
+    index->nodes[n].parent = parent;
+    (*links)[n].ch = ch;
+    if (n > 0) {
+        NodeLinks *p = &(*links)[parent];
+        if (p->last_child) (*links)[p->last_child].next_sibling = n;
+        else p->first_child = n;
+        p->last_child = n;
+    }
+    return n;
+}
+
+int phrase_index_build(PhraseIndex *index, const char *const *phrases, int count) {
+    memset(index, 0, sizeof(PhraseIndex));
+    arena_init(&index->arena);
+    index->phrase_count = count;
+    index->texts = calloc(count + 1, sizeof(char *));
+    index->lengths = calloc(count + 1, sizeof(uint32_t));
+    index->uses = calloc(count + 1, sizeof(uint32_t));
+    index->leaf = calloc(count + 1, sizeof(uint32_t));
+    SortedPhrase *sorted = malloc(sizeof(SortedPhrase) * (count + 1));
+    uint32_t *order = malloc(sizeof(uint32_t) * (count + 1));
+    NodeLinks *links = NULL;
+    uint32_t cap = 0;
+    int ok = index->texts && index->lengths && index->uses && index->leaf && sorted && order;
+
+    for (int i = 0; ok && i < count; i++) {
+        size_t len = strlen(phrases[i]);
+        char *copy = arena_alloc(&index->arena, len + 1);
+        if (!copy) {
+            ok = 0;
+            break;
+        }
+        memcpy(copy, phrases[i], len + 1);
+        index->texts[i] = copy;
+        index->lengths[i] = len;
+        sorted[i].text = copy;
+        sorted[i].id = i;
+    }
+
+    // Sorted insertion: a new child always sorts after its siblings, so an
+    // existing child for ch can only be the last one
+    if (ok) {
+        qsort(sorted, count, sizeof(SortedPhrase), compare_text);
+        add_node(index, &links, &cap, 0, 0);
+        ok = index->node_count == 1;
+    }
+    for (int i = 0; ok && i < count; i++) {
+        const unsigned char *p = (const unsigned char *)sorted[i].text;
+        if (!*p || (i > 0 && strcmp(sorted[i].text, sorted[i - 1].text) == 0)) continue;
+        uint32_t node = 0;
+        for (; *p && ok; p++) {
+            uint32_t last = links[node].last_child;
+            if (last && links[last].ch == *p) {
+                node = last;
+            } else {
+                node = add_node(index, &links, &cap, node, *p);
+                ok = node != 0;
+            }
+        }
+        index->leaf[sorted[i].id] = node;
+    }
+
+    if (ok) {
+        index->edges = malloc(sizeof(PhraseEdge) * (index->node_count + 1));
+        index->top = malloc(sizeof(uint32_t) * PHRASE_INDEX_TOP * index->node_count);
+        ok = index->edges && index->top;
+    }
+    if (ok) {
+        uint32_t edge_count = 0;
+        for (uint32_t n = 0; n < index->node_count; n++) {
+            index->nodes[n].first_edge = edge_count;
+            for (uint32_t c = links[n].first_child; c; c = links[c].next_sibling) {
+                index->edges[edge_count].ch = links[c].ch;
+                index->edges[edge_count].target = c;
+                edge_count++;
+            }
+            index->nodes[n].edge_count = edge_count - index->nodes[n].first_edge;
+        }
+
+        // Fill the lists best-first; once a node is full its ancestors are too
+        int indexed = 0;
+        for (int i = 0; i < count; i++) {
+            if (index->leaf[i]) order[indexed++] = i;
+        }
+        qsort_r(order, indexed, sizeof(uint32_t), compare_rank, index);
+        for (int i = 0; i < indexed; i++) {
+            uint32_t node = index->leaf[order[i]];
+            for (;;) {
+                PhraseNode *n = &index->nodes[node];
+                if (n->top_count == PHRASE_INDEX_TOP) break;
+                index->top[node * PHRASE_INDEX_TOP + n->top_count++] = order[i];
+                if (node == 0) break;
+                node = n->parent;
+            }
+        }
+    }
+
+    free(sorted);
+    free(order);
+    free(links);
+    if (!ok) phrase_index_free(index);
+    return ok;
+}
+
+// ============ Queries ============
+
+int phrase_index_complete(const PhraseIndex *index, const char *prefix, uint32_t *out, int max) {
+    if (!index->nodes || !prefix) return 0;
+    uint32_t node = 0;
+    for (const unsigned char *p = (const unsigned char *)prefix; *p; p++) {
+        const PhraseNode *n = &index->nodes[node];
+        uint32_t lo = n->first_edge, hi = n->first_edge + n->edge_count;
+        while (lo < hi) {
+            uint32_t mid = (lo + hi) / 2;
+            if (index->edges[mid].ch < *p) lo = mid + 1;
+            else hi = mid;
+        }
+        if (lo == n->first_edge + n->edge_count || index->edges[lo].ch != *p) return 0;
+        node = index->edges[lo].target;
+    }
+    int count = 0;
+    const uint32_t *top = &index->top[node * PHRASE_INDEX_TOP];
+    while (count < max && (uint32_t)count < index->nodes[node].top_count) {
+        out[count] = top[count];
+        count++;
+    }
+    return count;
+}
+
+void phrase_index_use(PhraseIndex *index, uint32_t phrase) {
+    if (!index->nodes || phrase >= (uint32_t)index->phrase_count || !index->leaf[phrase]) return;
+    index->uses[phrase]++;
+
+    // Only this phrase's rank changed, and only upwards: on each node of its
+    // path, move it up its list or let it take the last place
+    for (uint32_t node = index->leaf[phrase];; node = index->nodes[node].parent) {
+        PhraseNode *n = &index->nodes[node];
+        uint32_t *top = &index->top[node * PHRASE_INDEX_TOP];
+        uint32_t pos = 0;
+        while (pos < n->top_count && top[pos] != phrase) pos++;
+        if (pos == n->top_count) {
+            if (n->top_count < PHRASE_INDEX_TOP) {
+                n->top_count++;
+            } else if (ranks_before(index, phrase, top[pos - 1])) {
+                pos--;
+            } else {
+                break;              // Not good enough here, so not above either
+            }
+            top[pos] = phrase;
+        }
+        while (pos > 0 && ranks_before(index, top[pos], top[pos - 1])) {
+            uint32_t t = top[pos];
+            top[pos] = top[pos - 1];
+            top[pos - 1] = t;
+            pos--;
+        }
+        if (node == 0) break;
+    }
+}
+
+const char *phrase_index_text(const PhraseIndex *index, uint32_t phrase) {
+    if (phrase >= (uint32_t)index->phrase_count) return "";
+    return index->texts[phrase] ? index->texts[phrase] : "";
+}
+
+void phrase_index_free(PhraseIndex *index) {
+    free(index->nodes);
+    free(index->edges);
+    free(index->top);
+    free(index->texts);
+    free(index->lengths);
+    free(index->uses);
+    free(index->leaf);
+    arena_free(&index->arena);
+    memset(index, 0, sizeof(PhraseIndex));
+}
@@ -0,0 +1,998 @@
+/**
+ * Regex DFA Implementation
+ * Parse to a tree, emit a Thompson NFA, then run the subset construction
+ * to completion over byte classes (bytes no pattern set tells apart share
+ * a column). Line starts and ends are two extra input symbols, BOL and
+ * EOL, which only the ^ and $ states consume. Unanchored search comes from
+ * adding the NFA start state back in after every byte. Accepting states
+ * are absorbing: grep only asks whether a line matches, not where.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "regexdfa.h"
+#include "arena.h"
+
+#define MAX_NFA_STATES 200000
+#define MAX_NESTING 1000
+
+// ============ Parsing ============
+
+typedef struct {
+    uint64_t bits[4];
+} ByteSet;
+
+typedef enum { N_EMPTY, N_SET, N_BOL, N_EOL, N_CAT, N_ALT, N_REPEAT } NodeType;
+
+typedef struct Node {
+    NodeType type;
+    int set;                     // N_SET: index into Parser.sets
+    struct Node **kids;          // N_CAT, N_ALT
+    int kid_count;
+    int min, max;                // N_REPEAT of kids[0]; max -1 = unbounded
+} Node;
+
+typedef struct {
+    const char *p;
+    int icase;
+    int depth;
+    const char *error;
+    Arena arena;                 // Nodes and child arrays
+    ByteSet *sets;
+    int set_count, set_cap;
+} Parser;
+
+static void set_add(ByteSet *s, unsigned c) {
+    s->bits[c >> 6] |= 1ULL << (c & 63);
+}
+
+static int set_has(const ByteSet *s, unsigned c) {
+    return (s->bits[c >> 6] >> (c & 63)) & 1;
+}
+
+static void set_add_range(ByteSet *s, unsigned lo, unsigned hi) {
+    for (unsigned c = lo; c <= hi; c++) set_add(s, c);
+}
+
+static Node *new_node(Parser *ps, NodeType type) {
+    Node *n = arena_alloc(&ps->arena, sizeof(Node));
+    if (!n) {
+        ps->error = "out of memory";
+        return NULL;
+    }
+    memset(n, 0, sizeof(Node));
+    n->type = type;
+    return n;
+}
+
+// Case folding comes before negation, so [^a] with -i excludes 'A' too
+static Node *set_node(Parser *ps, ByteSet s, int negate) {
+    if (ps->icase) {
+        for (unsigned c = 'a'; c <= 'z'; c++) {
+            if (set_has(&s, c) || set_has(&s, c - 32)) {
+                set_add(&s, c);
+                set_add(&s, c - 32);
+            }
+        }
+    }
+    if (negate) {
+        for (int i = 0; i < 4; i++) s.bits[i] = ~s.bits[i];
+    }
+    s.bits['\n' >> 6] &= ~(1ULL << ('\n' & 63));   // Lines never contain one
+
+    if (ps->set_count == ps->set_cap) {
+        int cap = ps->set_cap ? ps->set_cap * 2 : 16;
+        ByteSet *grown = realloc(ps->sets, sizeof(ByteSet) * cap);
+        if (!grown) {
+            ps->error = "out of memory";
+            return NULL;
+        }
+        ps->sets = grown;
+        ps->set_cap = cap;
+    }
+    Node *n = new_node(ps, N_SET);
+    if (!n) return NULL;
+    n->set = ps->set_count;
+    ps->sets[ps->set_count++] = s;
+    return n;
+}
+
+static Node *char_node(Parser *ps, unsigned char c) {
+    ByteSet s;
+    memset(&s, 0, sizeof(s));
+    set_add(&s, c);
+    return set_node(ps, s, 0);
+}
+
+// Wrap items in a node of type, or return the only item
+static Node *list_node(Parser *ps, NodeType type, Node **items, int count) {
+    if (count == 1) return items[0];
+    Node *n = new_node(ps, count ? type : N_EMPTY);
+    if (!n || !count) return n;
+    n->kids = arena_alloc(&ps->arena, sizeof(Node *) * count);
+    if (!n->kids) {
+        ps->error = "out of memory";
+        return NULL;
+    }
+    memcpy(n->kids, items, sizeof(Node *) * count);
+    n->kid_count = count;
+    return n;
+}
+
+static int push_item(Parser *ps, Node ***items, int *count, int *cap, Node *n) {
+    if (*count == *cap) {
+        *cap = *cap ? *cap * 2 : 8;
+        Node **grown = realloc(*items, sizeof(Node *) * *cap);
+        if (!grown) {
+            ps->error = "out of memory";
+            return -1;
+        }
+        *items = grown;
+    }
+    (*items)[(*count)++] = n;
+    return 0;
+}
+
+// ASCII only, so the result does not depend on the locale
+static int add_named_class(ByteSet *s, const char *name, size_t len) {
+    static const struct {
+        const char *name;
+        int (*test)(int);
+    } classes[] = {
+        {"alpha", isalpha}, {"digit", isdigit}, {"alnum", isalnum}, {"upper", isupper},
+        {"lower", islower}, {"space", isspace}, {"blank", isblank}, {"punct", ispunct},
+        {"print", isprint}, {"graph", isgraph}, {"cntrl", iscntrl}, {"xdigit", isxdigit},
+    };
+    for (size_t i = 0; i < sizeof(classes) / sizeof(classes[0]); i++) {
+        if (strlen(classes[i].name) != len || strncmp(classes[i].name, name, len) != 0) continue;
+        for (unsigned c = 0; c < 128; c++) {
+            if (classes[i].test(c)) set_add(s, c);
+        }
+        return 0;
+    }
+    return -1;
+}
+
+// After '['. A ']' first is literal, as is '\' (POSIX).
+static Node *parse_class(Parser *ps) {
+    ByteSet s;
+    memset(&s, 0, sizeof(s));
+    int negate = 0;
+    if (*ps->p == '^') {
+        negate = 1;
+        ps->p++;
+    }
+    int first = 1;
+    while (*ps->p && (*ps->p != ']' || first)) {
+        first = 0;
+        if (ps->p[0] == '[' && ps->p[1] == ':') {
+            const char *close = strstr(ps->p + 2, ":]");
+            if (!close || add_named_class(&s, ps->p + 2, close - ps->p - 2) != 0) {
+                ps->error = "unknown character class";
+                return NULL;
+            }
+            ps->p = close + 2;
+            continue;
+        }
+        if (ps->p[0] == '[' && (ps->p[1] == '=' || ps->p[1] == '.')) {
+            ps->error = "collating elements are not supported";
+            return NULL;
+        }
+        unsigned char lo = *ps->p++;
+        if (ps->p[0] == '-' && ps->p[1] && ps->p[1] != ']') {
+            unsigned char hi = ps->p[1];
+            ps->p += 2;
+            if (hi < lo) {
+                ps->error = "invalid range end";
+                return NULL;
+            }
+            set_add_range(&s, lo, hi);
+        } else {
+            set_add(&s, lo);
+        }
+    }
+    if (*ps->p != ']') {
+        ps->error = "unmatched [";
+        return NULL;
+    }
+    ps->p++;
+    return set_node(ps, s, negate);
+}
+
+// After '\'
+static Node *parse_escape(Parser *ps) {
+    char c = *ps->p;
+    if (!c) {
+        ps->error = "trailing backslash";
+        return NULL;
+    }
+    ps->p++;
+    ByteSet s;
+    memset(&s, 0, sizeof(s));
+    switch (c) {
+    case 'd': case 'D':
+        set_add_range(&s, '0', '9');
+        return set_node(ps, s, c == 'D');
+    case 'w': case 'W':
+        set_add_range(&s, '0', '9');
+        set_add_range(&s, 'a', 'z');
+        set_add_range(&s, 'A', 'Z');
+        set_add(&s, '_');
+        return set_node(ps, s, c == 'W');
+    case 's': case 'S':
+        set_add(&s, ' ');
+        set_add_range(&s, '\t', '\r');
+        return set_node(ps, s, c == 'S');
+    case 't':
+        return char_node(ps, '\t');
+    case 'b': case 'B': case '<': case '>': case '`': case '\'':
+        ps->error = "word boundaries are not supported";
+        return NULL;
+    default:
+        if (c >= '1' && c <= '9') {
+            ps->error = "backreferences are not supported";
+            return NULL;
+        }
+        return char_node(ps, c);
+    }
+}
+
+static Node *parse_alt(Parser *ps);
+
+static Node *parse_atom(Parser *ps) {
+    char c = *ps->p++;
+    switch (c) {
+    case '(': {
+        if (++ps->depth > MAX_NESTING) {
+            ps->error = "parentheses nested too deeply";
+            return NULL;
+        }
+        Node *inner = *ps->p == ')' ? new_node(ps, N_EMPTY) : parse_alt(ps);
+        if (!inner) return NULL;
+        if (*ps->p != ')') {
+            ps->error = "unmatched (";
+            return NULL;
+        }
+        ps->p++;
+        ps->depth--;
+        return inner;
+    }
+    case '[':
+        return parse_class(ps);
+    case '.': {
+        ByteSet s;
+        memset(&s, 0, sizeof(s));
+        return set_node(ps, s, 1);
+    }
+    case '^':
+        return new_node(ps, N_BOL);
+    case '$':
+        return new_node(ps, N_EOL);
+    case '\\':
+        return parse_escape(ps);
+    default:
+        // Includes a quantifier with nothing to repeat, which is literal
+        return char_node(ps, c);
+    }
+}
+
+// At '{': 1 and the bounds if a valid {m}, {m,}, {,n} or {m,n} follows,
+// 0 if the brace is literal, -1 on an error
+static int parse_bound(Parser *ps, int *min, int *max) {
+    const char *q = ps->p + 1;
+    long lo = 0, hi;
+    int digits = 0;
+    for (; isdigit((unsigned char)*q); q++, digits++) {
+        if (lo <= REGEXDFA_MAX_REPEAT) lo = lo * 10 + (*q - '0');
+    }
+    hi = lo;
+    if (*q == ',') {
+        q++;
+        hi = -1;
+        if (isdigit((unsigned char)*q)) {
+            hi = 0;
+            digits++;
+        }
+        for (; isdigit((unsigned char)*q); q++) {
+            if (hi <= REGEXDFA_MAX_REPEAT) hi = hi * 10 + (*q - '0');
+        }
+    }
+    if (!digits || *q != '}') return 0;
+    if (lo > REGEXDFA_MAX_REPEAT || hi > REGEXDFA_MAX_REPEAT) {
+        ps->error = "repetition count too large";
+        return -1;
+    }
+    if (hi >= 0 && hi < lo) {
+        ps->error = "invalid repetition bounds";
+        return -1;
+    }
+    *min = lo;
+    *max = hi;
+    ps->p = q + 1;
+    return 1;
+}
+
+static Node *parse_quantifiers(Parser *ps, Node *atom) {
+    for (;;) {
+        int min, max;
+        char c = *ps->p;
+        if (c == '*' || c == '+' || c == '?') {
+            min = c == '+';
+            max = c == '?' ? 1 : -1;
+            ps->p++;
+        } else if (c == '{') {
+            int r = parse_bound(ps, &min, &max);
+            if (r < 0) return NULL;
+            if (r == 0) break;
+        } else {
+            break;
+        }
+        Node *rep = new_node(ps, N_REPEAT);
+        if (!rep) return NULL;
+        rep->kids = arena_alloc(&ps->arena, sizeof(Node *));
+        if (!rep->kids) {
+            ps->error = "out of memory";
+            return NULL;
+        }
+        rep->kids[0] = atom;
+        rep->kid_count = 1;
+        rep->min = min;
+        rep->max = max;
+        atom = rep;
+    }
+    return atom;
+}
+
+static Node *parse_cat(Parser *ps) {
+    Node **items = NULL;
+    int count = 0, cap = 0;
+    Node *result = NULL;
+    // An unmatched ')' is literal, as in GNU grep
+    while (*ps->p && *ps->p != '|' && (*ps->p != ')' || ps->depth == 0)) {
+        Node *n = parse_atom(ps);
+        if (n) n = parse_quantifiers(ps, n);
+        if (!n || push_item(ps, &items, &count, &cap, n) != 0) goto done;
+    }
+    result = list_node(ps, N_CAT, items, count);
+done:
+    free(items);
+    return result;
+}
+
+static Node *parse_alt(Parser *ps) {
+    Node **items = NULL;
+    int count = 0, cap = 0;
+    Node *result = NULL;
+    for (;;) {
+        Node *n = parse_cat(ps);
+        if (!n || push_item(ps, &items, &count, &cap, n) != 0) goto done;
+        if (*ps->p != '|') break;
+        ps->p++;
+    }
+    result = list_node(ps, N_ALT, items, count);
+done:
+    free(items);
+    return result;
+}
+
+// ============ Required Literal ============
+
+typedef struct {
+    char s[REGEXDFA_LITERAL_MAX];
+    size_t len;
+    int exact;                   // Every match of the node is exactly s
+} Literal;
+
+static void literal_append(Literal *to, const Literal *from, int *cut) {
+    size_t n = from->len;
+    if (to->len + n > REGEXDFA_LITERAL_MAX) {
+        n = REGEXDFA_LITERAL_MAX - to->len;
+        *cut = 1;
+    }
+    memcpy(to->s + to->len, from->s, n);
+    to->len += n;
+}
+
+// exact describes the node as a whole; req is the longest string every
+// match contains. A cut-off run is still required, just no longer exact.
+static void literal_info(const Parser *ps, const Node *n, Literal *exact, Literal *req) {
+    exact->len = req->len = 0;
+    exact->exact = req->exact = 0;
+    switch (n->type) {
+    case N_EMPTY:
+        exact->exact = 1;
+        break;
+    case N_SET: {
+        const ByteSet *s = &ps->sets[n->set];
+        int count = 0, c = 0;
+        for (int i = 0; i < 4; i++) count += __builtin_popcountll(s->bits[i]);
+        if (count != 1) break;
+        while (!set_has(s, c)) c++;
+        exact->s[0] = req->s[0] = (char)c;
+        exact->len = req->len = 1;
+        exact->exact = 1;
+        break;
+    }
+    case N_BOL:
+    case N_EOL:
+    case N_ALT:
+        break;
+    case N_CAT: {
+        Literal run = {{0}, 0, 0}, ke, kr;
+        int all_exact = 1, cut = 0;
+        for (int i = 0; i < n->kid_count; i++) {
+            literal_info(ps, n->kids[i], &ke, &kr);
+            if (kr.len > req->len) *req = kr;
+            if (ke.exact) {
+                literal_append(&run, &ke, &cut);
+            } else {
+                if (run.len > req->len) *req = run;
+                run.len = 0;
+                all_exact = 0;
+            }
+        }
+        if (run.len > req->len) *req = run;
+        if (all_exact && !cut) {
+            *exact = run;
+            exact->exact = 1;
+        }
+        break;
+    }
+    case N_REPEAT: {
+        Literal ke, kr;
+        literal_info(ps, n->kids[0], &ke, &kr);
+        if (n->max == 0) {
+            exact->exact = 1;
+            break;
+        }
+        if (n->min == 0) break;
+        *req = kr;
+        if (!ke.exact) break;
+        Literal rep = {{0}, 0, 0};
+        int cut = 0;
+        for (int i = 0; i < n->min && !cut; i++) literal_append(&rep, &ke, &cut);
+        if (rep.len > req->len) *req = rep;
+        if (n->min == n->max && !cut) {
+            *exact = rep;
+            exact->exact = 1;
+        }
+        break;
+    }
+    }
+    req->exact = 0;
+}
+
+// ============ NFA ============
+
+typedef enum { NS_EPS, NS_SPLIT, NS_SET, NS_BOL, NS_EOL, NS_MATCH } NStateType;
+
+typedef struct {
+    uint8_t type;
+    int set;
+    int out, out1;
+} NState;
+
+typedef struct {
+    NState *states;
+    int count, cap;
+    const char *error;
+} Nfa;
+
+typedef struct {
+    int start;
+    int end;                     // An NS_EPS whose out is still open
+} Frag;
+
+static int nfa_add(Nfa *nfa, NStateType type, int set) {
+    if (nfa->count == MAX_NFA_STATES) {
+        nfa->error = "pattern too large";
+        return -1;
+    }
+    if (nfa->count == nfa->cap) {
+        int cap = nfa->cap ? nfa->cap * 2 : 64;
+        NState *grown = realloc(nfa->states, sizeof(NState) * cap);
+        if (!grown) {
+            nfa->error = "out of memory";
+            return -1;
+        }
+        nfa->states = grown;
+        nfa->cap = cap;
+    }
+    NState *s = &nfa->states[nfa->count];
+    s->type = type;
+    s->set = set;
+    s->out = s->out1 = -1;
+    return nfa->count++;
+}
+
+static Frag emit(Nfa *nfa, const Node *n);
+
+// kid, optional (max_one) or repeated any number of times, after f
+static int emit_loop(Nfa *nfa, Frag *f, const Node *kid, int max_one) {
+    Frag g = emit(nfa, kid);
+    if (g.start < 0) return -1;
+    int e = nfa_add(nfa, NS_EPS, 0);
+    int s = nfa_add(nfa, NS_SPLIT, 0);
+    if (e < 0 || s < 0) return -1;
+    nfa->states[s].out = g.start;
+    nfa->states[s].out1 = e;
+    nfa->states[g.end].out = max_one ? e : s;
+    nfa->states[f->end].out = s;
+    f->end = e;
+    return 0;
+}
+
+static Frag emit(Nfa *nfa, const Node *n) {
+    Frag f = {-1, -1};
+    switch (n->type) {
+    case N_EMPTY:
+        f.start = f.end = nfa_add(nfa, NS_EPS, 0);
+        break;
+    case N_SET:
+    case N_BOL:
+    case N_EOL: {
+        NStateType type = n->type == N_SET ? NS_SET : n->type == N_BOL ? NS_BOL : NS_EOL;
+        int s = nfa_add(nfa, type, n->set);
+        int e = nfa_add(nfa, NS_EPS, 0);
+        if (s < 0 || e < 0) return (Frag){-1, -1};
+        nfa->states[s].out = e;
+        f.start = s;
+        f.end = e;
+        break;
+    }
+    case N_CAT:
+        for (int i = 0; i < n->kid_count; i++) {
+            Frag g = emit(nfa, n->kids[i]);
+            if (g.start < 0) return (Frag){-1, -1};
+            if (i == 0) f.start = g.start;
+            else nfa->states[f.end].out = g.start;
+            f.end = g.end;
+        }
+        break;
+    case N_ALT: {
+        int e = nfa_add(nfa, NS_EPS, 0);
+        if (e < 0) return f;
+        for (int i = n->kid_count - 1; i >= 0; i--) {
+            Frag g = emit(nfa, n->kids[i]);
+            if (g.start < 0) return (Frag){-1, -1};
+            nfa->states[g.end].out = e;
+            if (f.start < 0) {
+                f.start = g.start;
+                continue;
+            }
+            int s = nfa_add(nfa, NS_SPLIT, 0);
+            if (s < 0) return (Frag){-1, -1};
+            nfa->states[s].out = g.start;
+            nfa->states[s].out1 = f.start;
+            f.start = s;
+        }
+        f.end = e;
+        break;
+    }
+    case N_REPEAT:
+        f.start = f.end = nfa_add(nfa, NS_EPS, 0);
+        if (f.start < 0) return f;
+        for (int i = 0; i < n->min; i++) {
+            Frag g = emit(nfa, n->kids[0]);
+            if (g.start < 0) return (Frag){-1, -1};
+            nfa->states[f.end].out = g.start;
+            f.end = g.end;
+        }
+        if (n->max < 0) {
+            if (emit_loop(nfa, &f, n->kids[0], 0) != 0) return (Frag){-1, -1};
+        } else {
+            for (int i = n->min; i < n->max; i++) {
+                if (emit_loop(nfa, &f, n->kids[0], 1) != 0) return (Frag){-1, -1};
+            }
+        }
+        break;
+    }
+    return f;
+}
+
+// ============ Subset Construction ============
+
+typedef struct {
+    int *ids;                    // Sorted consuming and match NFA states
+    int count;
+    uint32_t hash;
+} DState;
+
+typedef struct {
+    const Nfa *nfa;
+    const ByteSet *sets;
+    int *mark;                   // Per NFA state: last generation it was added
+    int gen;
+    int *stack;
+    int *scratch;
+    int *inject;                 // Start closure without ^ states
+    int inject_count;
+    DState *states;
+    int count, cap;
+    int *slots;                  // State index + 1, 0 = empty
+    int slot_count;
+    Arena arena;
+} Builder;
+
+static int compare_ints(const void *a, const void *b) {
+    int x = *(const int *)a, y = *(const int *)b;
+    return x < y ? -1 : x > y;
+}
+
+// Add the consuming states reachable from s by epsilon moves
+static void closure(Builder *b, int s, int *out, int *n) {
+    int top = 0;
+    b->stack[top++] = s;
+    while (top) {
+        int x = b->stack[--top];
+        if (x < 0 || b->mark[x] == b->gen) continue;
+        b->mark[x] = b->gen;
+        const NState *st = &b->nfa->states[x];
+        if (st->type == NS_EPS) {
+            b->stack[top++] = st->out;
+        } else if (st->type == NS_SPLIT) {
+            b->stack[top++] = st->out1;
+            b->stack[top++] = st->out;
+        } else {
+            out[(*n)++] = x;
+        }
+    }
+}
+
+static uint32_t hash_ids(const int *ids, int count) {
+    uint32_t h = 2166136261u;
+    for (int i = 0; i < count; i++) {
+        h ^= (uint32_t)ids[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// Index of the DFA state for ids (sorted), adding it if new; -1 on failure
+static int find_or_add(Builder *b, int *ids, int count, const char **error) {
+    uint32_t h = hash_ids(ids, count);
+    int slot = h & (b->slot_count - 1);
+    while (b->slots[slot]) {
+        const DState *d = &b->states[b->slots[slot] - 1];
+        if (d->hash == h && d->count == count && memcmp(d->ids, ids, sizeof(int) * count) == 0) {
+            return b->slots[slot] - 1;
+        }
+        slot = (slot + 1) & (b->slot_count - 1);
+    }
+    if (b->count == REGEXDFA_MAX_STATES) {
+        *error = "pattern too complex";
+        return -1;
+    }
+    if (b->count == b->cap) {
+        int cap = b->cap ? b->cap * 2 : 64;
+        DState *grown = realloc(b->states, sizeof(DState) * cap);
+        if (!grown) {
+            *error = "out of memory";
+            return -1;
+        }
+        b->states = grown;
+        b->cap = cap;
+    }
+    DState *d = &b->states[b->count];
+    d->ids = arena_alloc(&b->arena, sizeof(int) * (count ? count : 1));
+    if (!d->ids) {
+        *error = "out of memory";
+        return -1;
+    }
+    memcpy(d->ids, ids, sizeof(int) * count);
+    d->count = count;
+    d->hash = h;
+    b->slots[slot] = ++b->count;
+    return b->count - 1;
+}
+
+// Turn the subset construction's table into the one the matchers use.
+// A '\n' ends one line and starts the next: from a live state it goes to
+// the start state, or, if the line just ended matched at its EOL, to an
+// extra REGEXDFA_NEWLINE state. States are then renumbered so every stop
+// state comes last, and entries become row offsets, so the scan loop is a
+// load, an add and one compare per byte.
+static int finish_dfa(RegexDfa *re, int count, int start, int eol) {
+    uint32_t width = re->symbol_count;
+    int total = count + 1, newline = count;
+    int32_t *trans = realloc(re->trans, sizeof(int32_t) * (size_t)total * width);
+    if (trans) re->trans = trans;
+    uint8_t *stop = realloc(re->stop, total);
+    if (stop) re->stop = stop;
+    int32_t *out = malloc(sizeof(int32_t) * (size_t)total * width);
+    int *order = malloc(sizeof(int) * total);
+    if (!trans || !stop || !out || !order) {
+        free(out);
+        free(order);
+        return -1;
+    }
+
+    int nl = re->byte_class['\n'];
+    stop[newline] = REGEXDFA_NEWLINE;
+    for (uint32_t sym = 0; sym < width; sym++) trans[(size_t)newline * width + sym] = newline;
+    for (int d = 0; d < count; d++) {
+        int32_t *row = trans + (size_t)d * width;
+        if (stop[d] == REGEXDFA_ACCEPT) continue;
+        row[nl] = stop[d] == 0 && stop[row[eol]] == REGEXDFA_ACCEPT ? newline : start;
+    }
+
+    int next = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        for (int d = 0; d < total; d++) {
+            if ((stop[d] != 0) == pass) order[d] = next++;
+        }
+        if (pass == 0) re->stop_row = next * width;
+    }
+    uint8_t *renumbered = malloc(total);
+    if (!renumbered) {
+        free(out);
+        free(order);
+        return -1;
+    }
+    for (int d = 0; d < total; d++) {
+        const int32_t *row = trans + (size_t)d * width;
+        int32_t *to = out + (size_t)order[d] * width;
+        for (uint32_t sym = 0; sym < width; sym++) to[sym] = order[row[sym]] * width;
+        renumbered[order[d]] = stop[d];
+    }
+    free(re->trans);
+    free(re->stop);
+    re->trans = out;
+    re->stop = renumbered;
+    re->state_count = total;
+    re->start = order[start] * width;
+    free(order);
+
+    // The live state most bytes leave where it is, usually the one where
+    // no match has begun, becomes the idle state the scan skips through
+    int best = 0;
+    re->idle_row = -1;
+    for (int32_t row = 0; row < re->stop_row; row += width) {
+        int loops = 0;
+        for (int c = 0; c < 256; c++) loops += out[row + re->byte_class[c]] == row;
+        if (loops > best) {
+            best = loops;
+            re->idle_row = row;
+        }
+    }
+    for (int c = 0; c < 256 && re->idle_row >= 0; c++) {
+        re->idle_skip[c] = out[re->idle_row + re->byte_class[c]] == re->idle_row;
+    }
+    return 0;
+}
+
+static int build_dfa(RegexDfa *re, const Nfa *nfa, int start, const ByteSet *sets, int set_count,
+                     const char **error) {
+    // Byte classes: a new class wherever some set changes membership
+    // '\n' always gets a class of its own, for the whole-buffer scan
+    uint8_t boundary[256] = {0};
+    boundary['\n'] = boundary['\n' + 1] = 1;
+    for (int i = 0; i < set_count; i++) {
+        for (int c = 1; c < 256; c++) {
+            if (set_has(&sets[i], c) != set_has(&sets[i], c - 1)) boundary[c] = 1;
+        }
+    }
+    int classes = 0, rep[256];
+    for (int c = 0; c < 256; c++) {
+        if (c == 0 || boundary[c]) rep[classes++] = c;
+        re->byte_class[c] = classes - 1;
+    }
+    int bol = classes, eol = classes + 1;
+    re->symbol_count = classes + 2;
+
+    Builder b;
+    memset(&b, 0, sizeof(b));
+    b.nfa = nfa;
+    b.sets = sets;
+    b.mark = calloc(nfa->count, sizeof(int));
+    b.stack = malloc(sizeof(int) * (nfa->count * 2 + 1));
+    b.scratch = malloc(sizeof(int) * (nfa->count + 1));
+    b.inject = malloc(sizeof(int) * (nfa->count + 1));
+    b.slot_count = REGEXDFA_MAX_STATES * 2;
+    b.slots = calloc(b.slot_count, sizeof(int));
+    arena_init(&b.arena);
+    int ok = 0;
+    if (!b.mark || !b.stack || !b.scratch || !b.inject || !b.slots) {
+        *error = "out of memory";
+        goto done;
+    }
+
+    // The state before BOL, and what every later step adds back in
+    int n = 0;
+    b.gen++;
+    closure(&b, start, b.scratch, &n);
+    qsort(b.scratch, n, sizeof(int), compare_ints);
+    for (int i = 0; i < n; i++) {
+        if (nfa->states[b.scratch[i]].type != NS_BOL) b.inject[b.inject_count++] = b.scratch[i];
+    }
+    if (find_or_add(&b, b.scratch, n, error) < 0) goto done;
+
+    size_t trans_cap = 0;
+    for (int d = 0; d < b.count; d++) {
+        if ((size_t)b.count * re->symbol_count > trans_cap) {
+            trans_cap = (size_t)b.cap * re->symbol_count;
+            int32_t *grown = realloc(re->trans, sizeof(int32_t) * trans_cap);
+            uint8_t *stop = realloc(re->stop, b.cap);
+            if (grown) re->trans = grown;
+            if (stop) re->stop = stop;
+            if (!grown || !stop) {
+                *error = "out of memory";
+                goto done;
+            }
+        }
+        int accept = 0;
+        for (int i = 0; i < b.states[d].count; i++) {
+            accept |= nfa->states[b.states[d].ids[i]].type == NS_MATCH;
+        }
+        int32_t *row = re->trans + (size_t)d * re->symbol_count;
+        re->stop[d] = accept ? REGEXDFA_ACCEPT : b.states[d].count == 0 ? REGEXDFA_DEAD : 0;
+        if (re->stop[d]) {
+            for (uint32_t sym = 0; sym < re->symbol_count; sym++) row[sym] = d;
+            continue;
+        }
+        for (uint32_t sym = 0; sym < re->symbol_count; sym++) {
+            n = 0;
+            b.gen++;
+            const DState *ds = &b.states[d];
+            for (int i = 0; i < ds->count; i++) {
+                const NState *st = &nfa->states[ds->ids[i]];
+                int moves = (st->type == NS_SET && (int)sym < classes && set_has(&sets[st->set], rep[sym]))
+                         || (st->type == NS_BOL && (int)sym == bol)
+                         || (st->type == NS_EOL && (int)sym == eol);
+                if (moves) closure(&b, st->out, b.scratch, &n);
+            }
+            if ((int)sym != eol) {
+                for (int i = 0; i < b.inject_count; i++) {
+                    int x = b.inject[i];
+                    if (b.mark[x] == b.gen) continue;
+                    b.mark[x] = b.gen;
+                    b.scratch[n++] = x;
+                }
+            }
+            qsort(b.scratch, n, sizeof(int), compare_ints);
+            int next = find_or_add(&b, b.scratch, n, error);
+            if (next < 0) goto done;
+            row = re->trans + (size_t)d * re->symbol_count;
+            row[sym] = next;
+        }
+    }
+    if (finish_dfa(re, b.count, re->trans[bol], eol) < 0) {
+        *error = "out of memory";
+        goto done;
+    }
+    ok = 1;
+
+done:
+    free(b.mark);
+    free(b.stack);
+    free(b.scratch);
+    free(b.inject);
+    free(b.slots);
+    free(b.states);
+    arena_free(&b.arena);
+    return ok ? 0 : -1;
+}
+
+// ============ Public API ============
+
+int regexdfa_compile(RegexDfa *re, const char *pattern, int flags, const char **error) {
+    memset(re, 0, sizeof(RegexDfa));
+    Parser ps;
+    memset(&ps, 0, sizeof(ps));
+    ps.p = pattern;
+    ps.icase = (flags & REGEXDFA_ICASE) != 0;
+    arena_init(&ps.arena);
+    Nfa nfa;
+    memset(&nfa, 0, sizeof(nfa));
+    const char *err = NULL;
+
+    Node *root;
+    if (flags & REGEXDFA_FIXED) {
+        Node **items = NULL;
+        int count = 0, cap = 0;
+        for (const char *c = pattern; *c && !ps.error; c++) {
+            Node *n = char_node(&ps, *c);
+            if (n) push_item(&ps, &items, &count, &cap, n);
+        }
+        root = ps.error ? NULL : list_node(&ps, N_CAT, items, count);
+        free(items);
+    } else {
+        root = parse_alt(&ps);
+    }
+    if (!root) {
+        err = ps.error;
+        goto done;
+    }
+
+    // Under -i a literal would need a case-blind memmem, so the DFA alone runs
+    if (!ps.icase) {
+        Literal exact, req;
+        literal_info(&ps, root, &exact, &req);
+        memcpy(re->literal, req.s, req.len);
+        re->literal_len = req.len;
+        re->literal_only = exact.exact && exact.len > 0;
+    }
+
+    Frag f = emit(&nfa, root);
+    int match = f.start >= 0 ? nfa_add(&nfa, NS_MATCH, 0) : -1;
+    if (match < 0) {
+        err = nfa.error;
+        goto done;
+    }
+    nfa.states[f.end].out = match;
+    build_dfa(re, &nfa, f.start, ps.sets, ps.set_count, &err);
+
+done:
+    free(nfa.states);
+    free(ps.sets);
+    arena_free(&ps.arena);
+    if (err) {
+        regexdfa_free(re);
+        if (error) *error = err;
+        return -1;
+    }
+    return 0;
+}
+
+int regexdfa_match_line(const RegexDfa *re, const char *line, size_t len) {
+    const int32_t *trans = re->trans;
+    uint32_t width = re->symbol_count;
+    int32_t s = re->start, stop_row = re->stop_row;
+    for (size_t i = 0; i < len && s < stop_row; i++) {
+        s = trans[s + re->byte_class[(unsigned char)line[i]]];
+    }
+    if (s < stop_row) s = trans[s + width - 1];   // EOL is last
+    return re->stop[s / width] == REGEXDFA_ACCEPT;
+}
+
+const char *regexdfa_find_line(const RegexDfa *re, const char *data, const char *end) {
+    const int32_t *trans = re->trans;
+    const uint16_t *byte_class = re->byte_class;
+    uint32_t width = re->symbol_count;
+    int32_t s = re->start, stop_row = re->stop_row, idle = re->idle_row;
+    const uint8_t *skip = re->idle_skip;
+    const unsigned char *first = (const unsigned char *)data, *q = first;
+    const unsigned char *e = (const unsigned char *)end;
+    for (;;) {
+        while (s < stop_row && q < e) {
+            if (s == idle) {
+                while (q < e && skip[*q]) q++;
+                if (q == e) break;
+            }
+            s = trans[s + byte_class[*q++]];
+        }
+        if (s < stop_row) break;
+        uint8_t kind = re->stop[s / width];
+        if (kind == REGEXDFA_DEAD) {
+            // Nothing more on this line can match
+            q = memchr(q, '\n', e - q);
+            if (!q) return NULL;
+            q++;
+            s = re->start;
+            continue;
+        }
+        // An empty match accepts before any byte of its line is read
+        if (kind == REGEXDFA_ACCEPT && (q == first || q[-1] == '\n')) {
+            return q < e ? (const char *)q : NULL;
+        }
+        // Otherwise the match is on the line holding the last byte read,
+        // which for REGEXDFA_NEWLINE is the line's own '\n'
+        const unsigned char *line = memrchr(first, '\n', q - 1 - first);
+        return (const char *)(line ? line + 1 : first);
+    }
+    // A last line without a newline still ends with EOL
+    if (q > first && q[-1] != '\n' && re->stop[trans[s + width - 1] / width] == REGEXDFA_ACCEPT) {
+        const unsigned char *line = memrchr(first, '\n', q - first);
+        return (const char *)(line ? line + 1 : first);
+    }
+    return NULL;
+}
+
+void regexdfa_free(RegexDfa *re) {
+    free(re->trans);
+    free(re->stop);
+    re->trans = NULL;
+    re->stop = NULL;
+    re->state_count = 0;
+}
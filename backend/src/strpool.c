@@ -0,0 +1,121 @@
+/**
+ * String Pool Implementation
+ * Strings live in an arena; an open-addressing table maps hash -> id
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "strpool.h"
+
+#define STRPOOL_INITIAL_SLOTS 256
+
+typedef struct PoolEntry {
+    const char *str;
+    uint32_t hash;
+} PoolEntry;
+
+static StrPool global_pool;  // History and the n-gram model
+
+// FNV-1a hash
+static uint32_t hash_string(const char *s) {
+    uint32_t h = 2166136261u;
+    while (*s) {
+        h ^= (unsigned char)*s++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static void grow_slots(StrPool *pool) {
+    uint32_t new_count = pool->slot_count ? pool->slot_count * 2 : STRPOOL_INITIAL_SLOTS;
+    StrId *new_slots = calloc(new_count, sizeof(StrId));
+    if (!new_slots) return;
+
+    for (uint32_t id = 1; id < pool->entry_count; id++) {
+        uint32_t i = pool->entries[id].hash & (new_count - 1);
+        while (new_slots[i] != STR_NONE) i = (i + 1) & (new_count - 1);
+        new_slots[i] = id;
+    }
+    free(pool->slots);
+    pool->slots = new_slots;
+    pool->slot_count = new_count;
+}
+
+void strpool_init_in(StrPool *pool) {
+    if (pool->entries) return;
+    arena_init(&pool->arena);
+    pool->entry_capacity = STRPOOL_INITIAL_SLOTS / 2;
+    pool->entries = malloc(sizeof(PoolEntry) * pool->entry_capacity);
+    pool->entry_count = 1;
+    pool->slots = NULL;
+    pool->slot_count = 0;
+    grow_slots(pool);
+}
+
+StrId strpool_intern_in(StrPool *pool, const char *s) {
+    if (!s) return STR_NONE;
+    if (!pool->entries) strpool_init_in(pool);
+
+    uint32_t h = hash_string(s);
+    uint32_t i = h & (pool->slot_count - 1);
+    while (pool->slots[i] != STR_NONE) {
+        PoolEntry *e = &pool->entries[pool->slots[i]];
+        if (e->hash == h && strcmp(e->str, s) == 0) return pool->slots[i];
+        i = (i + 1) & (pool->slot_count - 1);
+    }
+
+    // New string: copy into the arena and claim the empty slot
+    size_t len = strlen(s) + 1;
+    char *copy = arena_alloc(&pool->arena, len);
+    if (!copy) return STR_NONE;
+    memcpy(copy, s, len);
+
+    if (pool->entry_count >= pool->entry_capacity) {
+        pool->entry_capacity *= 2;
+        pool->entries = realloc(pool->entries, sizeof(PoolEntry) * pool->entry_capacity);
+    }
+    StrId id = pool->entry_count++;
+    pool->entries[id].str = copy;
+    pool->entries[id].hash = h;
+    pool->slots[i] = id;
+
+    // Keep load factor under 70%
+    if (pool->entry_count * 10 > pool->slot_count * 7) grow_slots(pool);
+    return id;
+}
+
+const char *strpool_get_in(const StrPool *pool, StrId id) {
+    if (id == STR_NONE || id >= pool->entry_count) return NULL;
+    return pool->entries[id].str;
+}
+
+uint32_t strpool_count_in(const StrPool *pool) {
+    return pool->entry_count ? pool->entry_count - 1 : 0;
+}
+
+void strpool_free_in(StrPool *pool) {
+    if (pool->entries) arena_free(&pool->arena);
+    free(pool->entries);
+    free(pool->slots);
+    memset(pool, 0, sizeof(*pool));
+}
+
+void strpool_init(void) {
+    strpool_init_in(&global_pool);
+}
+
+StrId strpool_intern(const char *s) {
+    return strpool_intern_in(&global_pool, s);
+}
+
+const char *strpool_get(StrId id) {
+    return strpool_get_in(&global_pool, id);
+}
+
+uint32_t strpool_count(void) {
+    return strpool_count_in(&global_pool);
+}
+
+void strpool_free(void) {
+    strpool_free_in(&global_pool);
+}
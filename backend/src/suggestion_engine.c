@@ -8,13 +8,15 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
-#include <dirent.h>
-#include <sys/stat.h>
+#include <stdint.h>
 #include <unistd.h>
 
 #define PATH_SEP '/'
 
 #include "suggestion_engine.h"
+#include "ngram.h"
+#include "dircache.h"
+#include "pathindex.h"
 
 // ============ Command Database ============
 
@@ -26,12 +28,12 @@ static CommandInfo command_database[] = {
     {"rmdir", "Remove empty directory", "rmdir <name>", {"rmdir test", "", ""}},
     {"touch", "Create file or update timestamp", "touch <file>", {"touch file.txt", "", ""}},
     {"rm", "Remove file", "rm <file>", {"rm file.txt", "rm -f old.log", ""}},
-    {"cat", "Display file contents", "cat <file>", {"cat file.txt", "cat -n script.sh", ""}},
-    {"cp", "Copy file", "cp <src> <dest>", {"cp a.txt b.txt", "cp -r dir1 dir2", ""}},
+    {"cat", "Display file contents", "cat <file> [file...]", {"cat file.txt", "cat a.log b.log", ""}},
+    {"cp", "Copy files or directories", "cp [-r] <src>... <dest>", {"cp a.txt b.txt", "cp -r dir1 dir2", ""}},
     {"mv", "Move or rename file", "mv <src> <dest>", {"mv old.txt new.txt", "", ""}},
     {"echo", "Print text", "echo <text>", {"echo hello", "echo $PATH", ""}},
     {"tree", "Directory tree view", "tree [path]", {"tree", "tree /home", ""}},
-    {"search", "Search in files", "search <pattern>", {"search hello", "search TODO", ""}},
+    {"search", "Search in files", "search <pattern> [path...]", {"search hello", "search TODO src", ""}},
     {"backup", "Create timestamped backup", "backup <file>", {"backup data.txt", "", ""}},
     {"compare", "Compare two files", "compare <f1> <f2>", {"compare a.txt b.txt", "", ""}},
     {"stats", "Shell statistics", "stats", {"stats", "", ""}},
@@ -45,13 +47,14 @@ static CommandInfo command_database[] = {
     {"exit", "Exit shell", "exit", {"exit", "", ""}},
     {"watch", "Watch file for changes", "watch <path> [interval]", {"watch .", "watch log.txt 1000", ""}},
     {"fileinfo", "Detailed file info", "fileinfo <file>", {"fileinfo data.txt", "", ""}},
-    {"dirtree", "Directory tree with sizes", "dirtree [path] [-s size]", {"dirtree", "dirtree -s 1M", ""}},
+    {"dirtree", "Directory tree with sizes", "dirtree [path] [-s size] [-d depth]", {"dirtree", "dirtree -s 1M", "dirtree src -d 1"}},
     {"duplicate", "Find duplicate files", "duplicate [path]", {"duplicate", "duplicate /home", ""}},
     {"encrypt", "Encrypt file", "encrypt <file> <key>", {"encrypt secret.txt mykey", "", ""}},
     {"decrypt", "Decrypt file", "decrypt <file> <key>", {"decrypt secret.txt mykey", "", ""}},
     {"hexdump", "Hex view of file", "hexdump <file> [off] [len]", {"hexdump binary.dat", "hexdump file 0 100", ""}},
     {"sizeof", "Total size of matching files", "sizeof <pattern>", {"sizeof *.txt", "sizeof *.c", ""}},
     {"age", "Find files by age", "age <days> [older|newer]", {"age 7 older", "age 1 newer", ""}},
+    {"ff", "Fuzzy find files in the tree", "ff [-n count] [-d] <query>", {"ff main.c", "ff -d src", "ff -n 50 test"}},
     {"monitor", "Monitor command output", "monitor <sec> <cmd>", {"monitor 5 ls", "", ""}},
     {"freq", "Word frequency analysis", "freq <file> [top_n]", {"freq doc.txt", "freq doc.txt 10", ""}},
     {"lines", "Line/word/char count", "lines <file>", {"lines code.c", "", ""}},
@@ -69,7 +72,7 @@ static CommandInfo command_database[] = {
     {"head", "First N lines", "head <file> [n]", {"head file.txt", "head file.txt 20", ""}},
     {"tail", "Last N lines", "tail <file> [n]", {"tail file.txt", "tail file.txt 20", ""}},
     {"wc", "Word count", "wc <file>", {"wc document.txt", "", ""}},
-    {"grep", "Search pattern", "grep <pattern> <file>", {"grep error log.txt", "", ""}},
+    {"grep", "Search with a regex", "grep [-i] [-v] [-c] [-n] [-r] [-F] [-A n] [-B n] [-C n] <pattern> [file...]", {"grep error log.txt", "grep \"TODO|FIXME\" -rn src", ""}},
     {"sort", "Sort lines", "sort <file> [-r] [-n]", {"sort list.txt", "sort nums.txt -n", ""}},
     {"uniq", "Remove duplicates", "uniq <file>", {"uniq list.txt", "", ""}},
     {"rev", "Reverse lines", "rev <file>", {"rev file.txt", "", ""}},
@@ -131,6 +134,7 @@ static int levenshtein_distance(const char *s1, const char *s2) {
 
 void suggestion_init(void) {
     history_count = 0;
+    ngram_init();
 }
 
 void suggestion_get_commands(const char *prefix, SuggestionList *out) {
@@ -182,7 +186,219 @@ void suggestion_get_commands(const char *prefix, SuggestionList *out) {
     }
 }
 
-void suggestion_get_paths(const char *partial_path, int dirs_only, SuggestionList *out) {
+// ============ Path Ranking ============
+
+// Match tiers; within a tier shorter names, the wanted type and recent
+// use move an entry up
+#define SCORE_EXACT_PREFIX 1000
+#define SCORE_PREFIX 800          // Ignoring case
+#define SCORE_SUBSTRING 500
+#define SCORE_SUBSEQUENCE 300
+#define SCORE_TYPO 200
+#define RECENT_SLOTS 256          // Power of two
+#define RECENT_BONUS 120          // For the latest path; one less per use since
+#define FILE_BONUS 60             // For files when files are wanted
+#define MAX_BONUS (FILE_BONUS + RECENT_BONUS)
+
+// Hashes of paths named in recent commands, for the recency bonus
+typedef struct {
+    uint32_t hash;
+    uint32_t tick;                // 0 = empty
+} RecentPath;
+
+static RecentPath recent_paths[RECENT_SLOTS];
+static uint32_t recent_tick = 0;
+
+typedef struct {
+    int score;
+    int is_dir;
+    char name[MAX_SUGGESTION_LEN];
+} RankedPath;
+
+typedef struct {
+    const char *dir_path;
+    int kind;
+    const char *prefix;           // As typed
+    char lower[256];              // Folded copy
+    int prefix_len;
+    uint32_t dir_hash;            // FNV state after "dir_path/"
+    RankedPath heap[MAX_SUGGESTIONS];   // Min-heap: the weakest kept entry on top
+    int count;
+} PathRanking;
+
+static uint32_t fnv_extend(uint32_t h, const char *s, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)s[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// Paths are compared without "./" in front or '/' behind
+static uint32_t path_hash(const char *path, size_t len) {
+    while (len >= 2 && path[0] == '.' && path[1] == '/') {
+        path += 2;
+        len -= 2;
+    }
+    while (len > 1 && path[len - 1] == '/') len--;
+    return fnv_extend(2166136261u, path, len);
+}
+
+static void recent_note(const char *path, size_t len) {
+    uint32_t h = path_hash(path, len);
+    recent_paths[h & (RECENT_SLOTS - 1)].hash = h;
+    recent_paths[h & (RECENT_SLOTS - 1)].tick = ++recent_tick;
+}
+
+static int recent_bonus(uint32_t h) {
+    const RecentPath *r = &recent_paths[h & (RECENT_SLOTS - 1)];
+    if (!r->tick || r->hash != h) return 0;
+    uint32_t age = recent_tick - r->tick;
+    return age < RECENT_BONUS ? RECENT_BONUS - (int)age : 0;
+}
+
+// tolower() without the locale lookup, for the per-entry loops
+static inline char fold_ascii(char c) {
+    return c >= 'A' && c <= 'Z' ? c + 32 : c;
+}
+
+// Characters of a (folded) left unpaired in b, both len < 64 long. No
+// edit script can be shorter, so this screens the Levenshtein call.
+static int unpaired_chars(const char *a, const char *b, int len) {
+    uint64_t used = 0;
+    int unpaired = 0;
+    for (int i = 0; i < len; i++) {
+        int j = 0;
+        while (j < len && ((used >> j & 1) || fold_ascii(b[j]) != a[i])) j++;
+        if (j < len) used |= 1ull << j;
+        else unpaired++;
+    }
+    return unpaired;
+}
+
+// Tier score of name for the typed prefix, -1 for no match. Tiers that
+// could not reach floor even with every bonus are not tried: once the
+// heap holds K prefix matches, the costlier checks stop running.
+static int match_score(const PathRanking *rank, const char *name, size_t name_len, int floor) {
+    int plen = rank->prefix_len;
+    if (plen == 0) return SCORE_PREFIX;
+    if ((size_t)plen <= name_len) {
+        if (strncmp(name, rank->prefix, plen) == 0) return SCORE_EXACT_PREFIX;
+        if (strncasecmp(name, rank->prefix, plen) == 0) return SCORE_PREFIX;
+    }
+
+    if (SCORE_SUBSTRING + MAX_BONUS < floor) return -1;
+
+    // Substring and subsequence, ignoring case, in one scan
+    const char *p = rank->lower;
+    int qi = 0, gaps = 0, first = -1;
+    for (size_t i = 0; i < name_len && qi < plen; i++) {
+        if (fold_ascii(name[i]) == p[qi]) {
+            if (first < 0) first = i;
+            qi++;
+        } else if (qi > 0) {
+            gaps++;
+        }
+    }
+    if (qi == plen) {
+        if (gaps == 0) return SCORE_SUBSTRING - (first < 50 ? first : 50);
+        return SCORE_SUBSEQUENCE - (gaps < 100 ? gaps : 100);
+    }
+
+    // A typo in what was typed so far: compare against the same length.
+    // The first character is taken as right, which keeps this rare.
+    if (plen >= 3 && (size_t)plen <= name_len && plen < 64 && SCORE_TYPO + MAX_BONUS >= floor &&
+        fold_ascii(name[0]) == p[0]) {
+        int allowed = plen >= 4 ? 2 : 1;
+        if (unpaired_chars(p, name, plen) > allowed) return -1;
+        char head[64];
+        memcpy(head, name, plen);
+        head[plen] = '\0';
+        int dist = levenshtein_distance(head, rank->lower);
+        if (dist <= allowed) return SCORE_TYPO - 50 * dist;
+    }
+    return -1;
+}
+
+static int ranks_lower(const RankedPath *a, const RankedPath *b) {
+    if (a->score != b->score) return a->score < b->score;
+    return strcmp(a->name, b->name) > 0;
+}
+
+static void heap_sift_down(RankedPath *heap, int count, int i) {
+    for (;;) {
+        int low = i, l = 2 * i + 1, r = l + 1;
+        if (l < count && ranks_lower(&heap[l], &heap[low])) low = l;
+        if (r < count && ranks_lower(&heap[r], &heap[low])) low = r;
+        if (low == i) return;
+        RankedPath t = heap[i];
+        heap[i] = heap[low];
+        heap[low] = t;
+        i = low;
+    }
+}
+
+static int rank_path(const DirCacheItem *item, void *ctx) {
+    PathRanking *rank = ctx;
+    int is_dir = item->type == DIRCACHE_DIR;
+    if (rank->kind == PATH_DIRS && !is_dir) return 0;
+    // Hidden entries only when asked for
+    if (item->name[0] == '.' && rank->prefix[0] != '.') return 0;
+
+    size_t name_len = strlen(item->name);
+    int floor = rank->count == MAX_SUGGESTIONS ? rank->heap[0].score : -1;
+    int score = match_score(rank, item->name, name_len, floor);
+    if (score < 0) return 0;
+    score -= name_len < 40 ? (int)name_len : 40;
+    if (name_len == (size_t)rank->prefix_len && score >= SCORE_PREFIX) score += 100;
+    if (rank->kind == PATH_FILES && !is_dir) score += FILE_BONUS;
+    score += recent_bonus(fnv_extend(rank->dir_hash, item->name, name_len));
+
+    // Only a candidate that beats the weakest kept one is copied
+    RankedPath *heap = rank->heap;
+    if (rank->count == MAX_SUGGESTIONS) {
+        if (score < heap[0].score || (score == heap[0].score && strcmp(item->name, heap[0].name) >= 0)) {
+            return 0;
+        }
+    }
+    RankedPath cand;
+    cand.score = score;
+    cand.is_dir = is_dir;
+    snprintf(cand.name, sizeof(cand.name), "%s", item->name);
+    if (rank->count < MAX_SUGGESTIONS) {
+        int i = rank->count++;
+        heap[i] = cand;
+        while (i > 0 && ranks_lower(&heap[i], &heap[(i - 1) / 2])) {
+            RankedPath t = heap[i];
+            heap[i] = heap[(i - 1) / 2];
+            heap[(i - 1) / 2] = t;
+            i = (i - 1) / 2;
+        }
+    } else {
+        heap[0] = cand;
+        heap_sift_down(heap, rank->count, 0);
+    }
+    return 0;
+}
+
+static void add_ranked(SuggestionList *out, const char *dir_path, const RankedPath *r) {
+    if (out->count >= MAX_SUGGESTIONS) return;
+    int len;
+    if (strcmp(dir_path, ".") == 0) {
+        len = snprintf(out->suggestions[out->count], MAX_SUGGESTION_LEN, "%s%s",
+                       r->name, r->is_dir ? "/" : "");
+    } else {
+        len = snprintf(out->suggestions[out->count], MAX_SUGGESTION_LEN, "%s/%s%s",
+                       dir_path, r->name, r->is_dir ? "/" : "");
+    }
+    if (len <= 0 || len >= MAX_SUGGESTION_LEN) return;   // A cut-off path is no use
+    for (int i = 0; i < out->count; i++) {
+        if (strcmp(out->suggestions[i], out->suggestions[out->count]) == 0) return;
+    }
+    out->count++;
+}
+
+void suggestion_get_paths(const char *partial_path, int kind, SuggestionList *out) {
     if (!out) return;
     out->count = 0;
     out->selected_index = 0;
@@ -209,51 +425,51 @@ void suggestion_get_paths(const char *partial_path, int dirs_only, SuggestionLis
         }
     }
     
-    // Use opendir/readdir system calls
-    DIR *dir = opendir(dir_path);
-    if (!dir) return;
+    // Every entry of the directory is scored and the best MAX_SUGGESTIONS
+    // kept in a bounded heap, in one pass over the cached listing
+    PathRanking rank;
+    rank.dir_path = dir_path;
+    rank.kind = kind;
+    rank.prefix = file_prefix;
+    rank.prefix_len = strlen(file_prefix);
+    memcpy(rank.lower, file_prefix, rank.prefix_len + 1);
+    str_to_lower_sug(rank.lower);
+    rank.dir_hash = strcmp(dir_path, ".") == 0 ? path_hash("", 0) : fnv_extend(path_hash(dir_path, strlen(dir_path)), "/", 1);
+    rank.count = 0;
+    dircache_list(dir_path, NULL, 0, rank_path, &rank);
     
-    struct dirent *entry;
-    int prefix_len = strlen(file_prefix);
+    RankedPath ranked[MAX_SUGGESTIONS];
+    int ranked_count = rank.count;
+    for (int i = ranked_count - 1; i >= 0; i--) {
+        ranked[i] = rank.heap[0];
+        rank.heap[0] = rank.heap[--rank.count];
+        heap_sift_down(rank.heap, rank.count, 0);
+    }
     
-    while ((entry = readdir(dir)) != NULL && out->count < MAX_SUGGESTIONS) {
-        // Skip . and ..
-        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
-            continue;
-        }
-        
-        // Check prefix match
-        if (prefix_len > 0 && strncmp(entry->d_name, file_prefix, prefix_len) != 0) {
-            continue;
-        }
-        
-        // Check if directory
-        char full_path[768];
-        snprintf(full_path, sizeof(full_path), "%s/%s", dir_path, entry->d_name);
-        
-        struct stat st;
-        if (stat(full_path, &st) == 0) {
-            int is_dir = S_ISDIR(st.st_mode);
-            
-            if (dirs_only && !is_dir) continue;
-            
-            // Build suggestion - use larger buffer to avoid truncation
-            char suggestion[768];
-            if (strcmp(dir_path, ".") == 0) {
-                snprintf(suggestion, sizeof(suggestion), "%s%s", 
-                        entry->d_name, is_dir ? "/" : "");
-            } else {
-                snprintf(suggestion, sizeof(suggestion), "%s/%s%s",
-                        dir_path, entry->d_name, is_dir ? "/" : "");
-            }
-            
-            strncpy(out->suggestions[out->count], suggestion, MAX_SUGGESTION_LEN - 1);
-            out->suggestions[out->count][MAX_SUGGESTION_LEN - 1] = '\0';
-            out->count++;
-        }
+    // Prefix matches here first, then deeper paths from the tree-wide
+    // index, then the looser matches here
+    int next = 0;
+    while (next < ranked_count && ranked[next].score >= SCORE_PREFIX - 40) {
+        add_ranked(out, dir_path, &ranked[next++]);
     }
     
-    closedir(dir);
+    // The index never waits: a missing or stale one is refreshed in the
+    // background and answers a later keystroke
+    if (out->count < MAX_SUGGESTIONS && partial_path && partial_path[0] &&
+        partial_path[0] != '/' && partial_path[0] != '~' && strncmp(partial_path, "..", 2) != 0) {
+        PathMatch matches[MAX_SUGGESTIONS];
+        int found = pathindex_find(partial_path, kind == PATH_DIRS, 0, matches, MAX_SUGGESTIONS);
+        for (int i = 0; i < found && out->count < MAX_SUGGESTIONS; i++) {
+            char suggestion[MAX_SUGGESTION_LEN];
+            int len = snprintf(suggestion, sizeof(suggestion), "%s%s",
+                               matches[i].path, matches[i].is_dir ? "/" : "");
+            if (len < 0 || len >= MAX_SUGGESTION_LEN) continue;
+            int seen = 0;
+            for (int j = 0; j < out->count && !seen; j++) seen = strcmp(out->suggestions[j], suggestion) == 0;
+            if (!seen) strcpy(out->suggestions[out->count++], suggestion);
+        }
+    }
+    while (next < ranked_count) add_ranked(out, dir_path, &ranked[next++]);
 }
 
 void suggestion_get_contextual(const char *cmd, const char *partial_arg, SuggestionList *out) {
@@ -264,7 +480,7 @@ void suggestion_get_contextual(const char *cmd, const char *partial_arg, Suggest
     const char *dir_cmds[] = {"cd", "mkdir", "rmdir", "tree", "dirtree", "watch"};
     for (int i = 0; i < 6; i++) {
         if (strcmp(cmd, dir_cmds[i]) == 0) {
-            suggestion_get_paths(partial_arg, 1, out);  // dirs only
+            suggestion_get_paths(partial_arg, PATH_DIRS, out);
             return;
         }
     }
@@ -275,14 +491,14 @@ void suggestion_get_contextual(const char *cmd, const char *partial_arg, Suggest
                                "jsoncat", "freq", "lines", "sort", "uniq", "rev"};
     for (int i = 0; i < 18; i++) {
         if (strcmp(cmd, file_cmds[i]) == 0) {
-            suggestion_get_paths(partial_arg, 0, out);  // all files
+            suggestion_get_paths(partial_arg, PATH_FILES, out);
             return;
         }
     }
     
     // cp, mv - both source and dest need paths
     if (strcmp(cmd, "cp") == 0 || strcmp(cmd, "mv") == 0 || strcmp(cmd, "compare") == 0) {
-        suggestion_get_paths(partial_arg, 0, out);
+        suggestion_get_paths(partial_arg, PATH_ANY, out);
         return;
     }
 }
@@ -290,6 +506,19 @@ void suggestion_get_contextual(const char *cmd, const char *partial_arg, Suggest
 void suggestion_add_to_history(const char *cmd) {
     if (!cmd || strlen(cmd) == 0) return;
     
+    // Every execution trains the next-command model, repeats included
+    ngram_observe(cmd);
+    
+    // Arguments feed the recency bonus of path completion
+    const char *p = cmd;
+    while (*p && *p != ' ') p++;
+    while (*p) {
+        while (*p == ' ') p++;
+        const char *start = p;
+        while (*p && *p != ' ') p++;
+        if (p > start && *start != '-') recent_note(start, p - start);
+    }
+    
     // Check if already in history
     for (int i = 0; i < history_count; i++) {
         if (strcmp(command_history_storage[i], cmd) == 0) {
@@ -327,6 +556,20 @@ void suggestion_get_from_history(const char *prefix, SuggestionList *out) {
     }
 }
 
+void suggestion_get_predictions(SuggestionList *out) {
+    if (!out) return;
+    out->count = 0;
+    out->selected_index = 0;
+    
+    StrId ids[MAX_SUGGESTIONS];
+    int n = ngram_predict(ids, MAX_SUGGESTIONS);
+    for (int i = 0; i < n; i++) {
+        strncpy(out->suggestions[out->count], strpool_get(ids[i]), MAX_SUGGESTION_LEN - 1);
+        out->suggestions[out->count][MAX_SUGGESTION_LEN - 1] = '\0';
+        out->count++;
+    }
+}
+
 CommandInfo* suggestion_get_command_info(const char *cmd) {
     if (!cmd) return NULL;
     
@@ -0,0 +1,349 @@
+/**
+ * Tree Walk Implementation
+ * Each worker owns a deque of directories: it pushes and pops at the
+ * tail, so it goes deep first, and idle workers steal from the head,
+ * where the oldest and usually largest subtrees wait. A directory's
+ * pending count starts at its subdirectories plus one for its own
+ * listing; whichever thread takes it to zero totals the directory and
+ * moves on to the parent.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include "treewalk.h"
+#include "dirlist.h"
+#include "arena.h"
+
+typedef struct {
+    TreeNode **tasks;                 // [head, count) are queued
+    size_t head, count, cap;
+    pthread_mutex_t lock;
+} Deque;
+
+typedef struct {
+    TreeWalk *walk;
+    int index;
+    Deque deque;
+    Arena arena;                      // Nodes and names of the directories it read
+    DirList list;
+    char path[PATH_MAX];
+} Worker;
+
+struct TreeWalk {
+    TreeNode root;
+    TreeWalkOptions options;
+    Worker *workers;
+    int threads;
+    pthread_t tids[TREEWALK_MAX_THREADS];
+    int started;
+    uint64_t outstanding;             // Directories queued or being read
+    uint64_t queued;                  // Directories sitting in a deque
+    int sleepers;
+    TreeNode *waiting;                // The node the caller is blocked on
+    pthread_mutex_t lock;
+    pthread_cond_t idle;              // Workers with nothing to steal
+    pthread_cond_t progress;          // The caller, in treewalk_wait
+};
+
+static int thread_count(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    if (n < 1) n = 1;
+    return n > TREEWALK_MAX_THREADS ? TREEWALK_MAX_THREADS : (int)n;
+}
+
+// ============ Deques ============
+
+static int deque_push(Deque *d, TreeNode **nodes, size_t count) {
+    pthread_mutex_lock(&d->lock);
+    if (d->count + count > d->cap && d->head > 0) {
+        memmove(d->tasks, d->tasks + d->head, sizeof(TreeNode *) * (d->count - d->head));
+        d->count -= d->head;
+        d->head = 0;
+    }
+    if (d->count + count > d->cap) {
+        size_t cap = d->cap * 2 > d->count + count ? d->cap * 2 : d->count + count + 64;
+        TreeNode **grown = realloc(d->tasks, sizeof(TreeNode *) * cap);
+        if (!grown) {
+            pthread_mutex_unlock(&d->lock);
+            return -1;
+        }
+        d->tasks = grown;
+        d->cap = cap;
+    }
+    memcpy(d->tasks + d->count, nodes, sizeof(TreeNode *) * count);
+    d->count += count;
+    pthread_mutex_unlock(&d->lock);
+    return 0;
+}
+
+// The owner takes the newest directory, a thief the oldest
+static TreeNode *deque_take(Deque *d, int steal) {
+    pthread_mutex_lock(&d->lock);
+    TreeNode *n = NULL;
+    if (d->count > d->head) n = steal ? d->tasks[d->head++] : d->tasks[--d->count];
+    if (d->head == d->count) d->head = d->count = 0;
+    pthread_mutex_unlock(&d->lock);
+    return n;
+}
+
+// ============ Progress ============
+
+static void set_state(TreeWalk *w, TreeNode *n, int state) {
+    __atomic_store_n(&n->state, state, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&w->waiting, __ATOMIC_SEQ_CST) == n) {
+        pthread_mutex_lock(&w->lock);
+        pthread_cond_broadcast(&w->progress);
+        pthread_mutex_unlock(&w->lock);
+    }
+}
+
+// Total a directory whose subdirectories are all done, then its parent
+// if this was the last one it was waiting for
+static void finish_dir(TreeWalk *w, TreeNode *dir) {
+    while (dir) {
+        uint64_t size = 0, files = 0, dirs = 0;
+        for (uint32_t i = 0; i < dir->child_count; i++) {
+            const TreeNode *c = &dir->children[i];
+            size += c->size;
+            if (c->type == DT_DIR) {
+                files += c->files;
+                dirs += c->dirs + 1;
+            } else {
+                files++;
+            }
+        }
+        dir->size = size;
+        dir->files = files;
+        dir->dirs = dirs;
+        set_state(w, dir, TREE_DONE);
+        dir = dir->parent;
+        if (dir && __atomic_sub_fetch(&dir->pending, 1, __ATOMIC_ACQ_REL) != 0) break;
+    }
+}
+
+// ============ Reading ============
+
+static int not_hidden(const DirListEntry *e, void *ctx) {
+    (void)ctx;
+    return e->name[0] != '.';
+}
+
+static int compare_nodes(const void *a, const void *b) {
+    const TreeNode *na = a, *nb = b;
+    if ((na->type == DT_DIR) != (nb->type == DT_DIR)) return na->type == DT_DIR ? -1 : 1;
+    return strcasecmp(na->name, nb->name);
+}
+
+// The directory's path, from its chain of parents; NULL if it is too deep
+static const char *node_path(Worker *wk, const TreeNode *dir) {
+    const char *names[TREEWALK_MAX_DEPTH];
+    int depth = 0;
+    const TreeNode *n = dir;
+    for (; n && depth < TREEWALK_MAX_DEPTH; n = n->parent) names[depth++] = n->name;
+    if (n) return NULL;
+    size_t len = 0;
+    for (int i = depth - 1; i >= 0; i--) {
+        int n = snprintf(wk->path + len, sizeof(wk->path) - len, "%s%s", names[i], i ? "/" : "");
+        if (n < 0 || (size_t)n >= sizeof(wk->path) - len) return NULL;
+        len += n;
+    }
+    return wk->path;
+}
+
+static void read_dir(Worker *wk, TreeNode *dir) {
+    TreeWalk *w = wk->walk;
+    const char *path = node_path(wk, dir);
+    if (!path || dirlist_read(&wk->list, path) != 0) {
+        dir->error = 1;
+        set_state(w, dir, TREE_LISTED);
+        finish_dir(w, dir);
+        return;
+    }
+    DirList *list = &wk->list;
+    dirlist_filter(list, not_hidden, NULL);
+    if (w->options.sizes) dirlist_sort(list, dirlist_by_inode);
+
+    TreeNode *children = list->count ? arena_alloc(&wk->arena, sizeof(TreeNode) * list->count) : NULL;
+    uint32_t count = 0, subdirs = 0;
+    int descend = w->options.max_depth < 0 || dir->depth + 1 <= w->options.max_depth;
+    for (size_t i = 0; children && i < list->count; i++) {
+        const DirListEntry *e = &list->entries[i];
+        size_t name_len = strlen(e->name);
+        char *name = arena_alloc(&wk->arena, name_len + 1);
+        if (!name) break;
+        memcpy(name, e->name, name_len + 1);
+        TreeNode *c = &children[count++];
+        memset(c, 0, sizeof(TreeNode));
+        c->name = name;
+        c->parent = dir;
+        c->depth = dir->depth + 1;
+        c->type = e->type;
+        struct stat st;
+        if (w->options.sizes && e->type != DT_DIR && dirlist_stat(list, e, &st) == 0) c->size = st.st_size;
+        if (e->type == DT_DIR) {
+            if (descend) subdirs++;
+            else c->state = TREE_DONE;
+        }
+    }
+    if (count > 1) qsort(children, count, sizeof(TreeNode), compare_nodes);
+    dir->children = children;
+    dir->child_count = count;
+    dir->pending = subdirs + 1;
+    set_state(w, dir, TREE_LISTED);
+
+    // Pushed last to first so the owner pops them in order, which is the
+    // order they will be printed in
+    if (subdirs) {
+        TreeNode *batch[256];
+        size_t pending = 0, pushed = 0;
+        for (uint32_t i = count; i-- > 0;) {
+            if (children[i].type != DT_DIR || children[i].state == TREE_DONE) continue;
+            batch[pending++] = &children[i];
+            if (pending == 256 || pushed + pending == subdirs) {
+                __atomic_add_fetch(&w->outstanding, pending, __ATOMIC_SEQ_CST);
+                __atomic_add_fetch(&w->queued, pending, __ATOMIC_SEQ_CST);
+                if (deque_push(&wk->deque, batch, pending) != 0) {
+                    // Out of memory: those directories stay empty
+                    __atomic_sub_fetch(&w->outstanding, pending, __ATOMIC_SEQ_CST);
+                    __atomic_sub_fetch(&w->queued, pending, __ATOMIC_SEQ_CST);
+                    for (size_t k = 0; k < pending; k++) {
+                        batch[k]->error = 1;
+                        set_state(w, batch[k], TREE_LISTED);
+                        finish_dir(w, batch[k]);
+                    }
+                }
+                pushed += pending;
+                pending = 0;
+            }
+        }
+        if (__atomic_load_n(&w->sleepers, __ATOMIC_SEQ_CST) > 0) {
+            pthread_mutex_lock(&w->lock);
+            pthread_cond_broadcast(&w->idle);
+            pthread_mutex_unlock(&w->lock);
+        }
+    }
+    if (__atomic_sub_fetch(&dir->pending, 1, __ATOMIC_ACQ_REL) == 0) finish_dir(w, dir);
+}
+
+static TreeNode *find_work(Worker *wk) {
+    TreeWalk *w = wk->walk;
+    TreeNode *n = deque_take(&wk->deque, 0);
+    for (int k = 1; !n && k < w->threads; k++) {
+        n = deque_take(&w->workers[(wk->index + k) % w->threads].deque, 1);
+    }
+    if (n) __atomic_sub_fetch(&w->queued, 1, __ATOMIC_SEQ_CST);
+    return n;
+}
+
+static void *worker_main(void *arg) {
+    Worker *wk = arg;
+    TreeWalk *w = wk->walk;
+    for (;;) {
+        TreeNode *n = find_work(wk);
+        if (n) {
+            read_dir(wk, n);
+            if (__atomic_sub_fetch(&w->outstanding, 1, __ATOMIC_SEQ_CST) == 0) {
+                pthread_mutex_lock(&w->lock);
+                pthread_cond_broadcast(&w->idle);
+                pthread_mutex_unlock(&w->lock);
+            }
+            continue;
+        }
+        pthread_mutex_lock(&w->lock);
+        __atomic_add_fetch(&w->sleepers, 1, __ATOMIC_SEQ_CST);
+        while (__atomic_load_n(&w->queued, __ATOMIC_SEQ_CST) == 0 &&
+               __atomic_load_n(&w->outstanding, __ATOMIC_SEQ_CST) > 0) {
+            pthread_cond_wait(&w->idle, &w->lock);
+        }
+        __atomic_sub_fetch(&w->sleepers, 1, __ATOMIC_SEQ_CST);
+        int finished = __atomic_load_n(&w->outstanding, __ATOMIC_SEQ_CST) == 0;
+        pthread_mutex_unlock(&w->lock);
+        if (finished) return NULL;
+    }
+}
+
+// ============ Public API ============
+
+TreeWalk *treewalk_start(const char *path, const TreeWalkOptions *options) {
+    struct stat st;
+    if (stat(path, &st) != 0) return NULL;
+    if (!S_ISDIR(st.st_mode)) {
+        errno = ENOTDIR;
+        return NULL;
+    }
+    TreeWalk *w = calloc(1, sizeof(TreeWalk));
+    if (!w) return NULL;
+    w->options = *options;
+    w->threads = thread_count();
+    w->workers = calloc(w->threads, sizeof(Worker));
+    if (!w->workers) {
+        free(w);
+        errno = ENOMEM;
+        return NULL;
+    }
+    pthread_mutex_init(&w->lock, NULL);
+    pthread_cond_init(&w->idle, NULL);
+    pthread_cond_init(&w->progress, NULL);
+    for (int i = 0; i < w->threads; i++) {
+        Worker *wk = &w->workers[i];
+        wk->walk = w;
+        wk->index = i;
+        pthread_mutex_init(&wk->deque.lock, NULL);
+        arena_init(&wk->arena);
+        dirlist_init(&wk->list);
+    }
+
+    w->root.name = path;
+    w->root.type = DT_DIR;
+    TreeNode *root = &w->root;
+    w->outstanding = w->queued = 1;
+    if (deque_push(&w->workers[0].deque, &root, 1) != 0) {
+        treewalk_finish(w);
+        errno = ENOMEM;
+        return NULL;
+    }
+    for (int i = 0; i < w->threads; i++) {
+        if (pthread_create(&w->tids[w->started], NULL, worker_main, &w->workers[i]) == 0) w->started++;
+    }
+    // Without threads the walk runs here, before returning
+    if (!w->started) worker_main(&w->workers[0]);
+    return w;
+}
+
+TreeNode *treewalk_root(TreeWalk *walk) {
+    return &walk->root;
+}
+
+void treewalk_wait(TreeWalk *walk, TreeNode *dir, int state) {
+    if (__atomic_load_n(&dir->state, __ATOMIC_SEQ_CST) >= state) return;
+    pthread_mutex_lock(&walk->lock);
+    __atomic_store_n(&walk->waiting, dir, __ATOMIC_SEQ_CST);
+    while (__atomic_load_n(&dir->state, __ATOMIC_SEQ_CST) < state) {
+        pthread_cond_wait(&walk->progress, &walk->lock);
+    }
+    __atomic_store_n(&walk->waiting, NULL, __ATOMIC_SEQ_CST);
+    pthread_mutex_unlock(&walk->lock);
+}
+
+void treewalk_finish(TreeWalk *walk) {
+    for (int i = 0; i < walk->started; i++) pthread_join(walk->tids[i], NULL);
+    for (int i = 0; i < walk->threads; i++) {
+        Worker *wk = &walk->workers[i];
+        free(wk->deque.tasks);
+        pthread_mutex_destroy(&wk->deque.lock);
+        arena_free(&wk->arena);
+        dirlist_free(&wk->list);
+    }
+    free(walk->workers);
+    pthread_mutex_destroy(&walk->lock);
+    pthread_cond_destroy(&walk->idle);
+    pthread_cond_destroy(&walk->progress);
+    free(walk);
+}
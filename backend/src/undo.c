@@ -2,16 +2,21 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <fcntl.h>
 #include <sys/stat.h>
 #include "undo.h"
-#include "utils.h"
+#include "dirlist.h"
 
 #define UNDO_BACKUP_DIR ".shell_undo"
+#define UNDO_MAX_ENTRIES 50
 
 UndoStack *init_undo_stack() {
     UndoStack *stack = malloc(sizeof(UndoStack));
     stack->top = NULL;
     stack->count = 0;
+    stack->free_nodes = NULL;
+    arena_init(&stack->nodes);
+    memset(&stack->strings, 0, sizeof(stack->strings));
     
     // Create undo backup directory if it doesn't exist
     mkdir(UNDO_BACKUP_DIR, 0755);
@@ -19,18 +24,77 @@ UndoStack *init_undo_stack() {
     return stack;
 }
 
+// Remove the entry name of dirfd and, for a directory, everything below
+// it. Symlinks are removed, never followed. Returns 0 if all of it went.
+static int remove_tree(int dirfd, const char *name) {
+    DirList list;
+    dirlist_init(&list);
+    if (dirlist_readat(&list, dirfd, name) != 0) {
+        dirlist_free(&list);
+        return unlinkat(dirfd, name, 0);
+    }
+    int rc = 0;
+    for (size_t i = 0; i < list.count; i++) {
+        const DirListEntry *e = &list.entries[i];
+        if (e->type == DT_DIR) {
+            if (remove_tree(list.fd, e->name) != 0) rc = -1;
+        } else if (unlinkat(list.fd, e->name, 0) != 0) {
+            rc = -1;
+        }
+    }
+    dirlist_free(&list);
+    if (unlinkat(dirfd, name, AT_REMOVEDIR) != 0) rc = -1;
+    return rc;
+}
+
+static const char *node_string(const UndoStack *stack, StrId id) {
+    return strpool_get_in(&stack->strings, id);
+}
+
+// Keep the node for reuse; its strings stay in the pool until compaction
+static void release_node(UndoStack *stack, UndoNode *node) {
+    node->next = stack->free_nodes;
+    stack->free_nodes = node;
+}
+
+// Popped and trimmed entries leave their strings behind. An empty stack
+// drops the pool; one holding twice what the entries can reference is
+// rebuilt from the live strings, so the pool stays bounded.
+static void compact_strings(UndoStack *stack) {
+    if (stack->count == 0) {
+        strpool_free_in(&stack->strings);
+        return;
+    }
+    if (strpool_count_in(&stack->strings) <= UNDO_MAX_ENTRIES * 3 * 2) return;
+
+    StrPool fresh;
+    memset(&fresh, 0, sizeof(fresh));
+    for (UndoNode *node = stack->top; node; node = node->next) {
+        node->command = strpool_intern_in(&fresh, node_string(stack, node->command));
+        node->target = strpool_intern_in(&fresh, node_string(stack, node->target));
+        node->backup_path = strpool_intern_in(&fresh, node_string(stack, node->backup_path));
+    }
+    strpool_free_in(&stack->strings);
+    stack->strings = fresh;
+}
+
 void push_undo(UndoStack *stack, const char *command, UndoType type, const char *target, const char *backup) {
-    UndoNode *node = malloc(sizeof(UndoNode));
-    node->command = strdup_custom(command);
+    UndoNode *node = stack->free_nodes;
+    if (node) {
+        stack->free_nodes = node->next;
+    } else {
+        node = arena_alloc(&stack->nodes, sizeof(UndoNode));
+    }
+    node->command = strpool_intern_in(&stack->strings, command);
     node->type = type;
-    node->target = target ? strdup_custom(target) : NULL;
-    node->backup_path = backup ? strdup_custom(backup) : NULL;
+    node->target = strpool_intern_in(&stack->strings, target);
+    node->backup_path = strpool_intern_in(&stack->strings, backup);
     node->next = stack->top;
     stack->top = node;
     stack->count++;
     
     // Limit stack size to prevent memory issues
-    if (stack->count > 50) {
+    if (stack->count > UNDO_MAX_ENTRIES) {
         // Remove oldest entry
         UndoNode *curr = stack->top;
         UndoNode *prev = NULL;
@@ -40,14 +104,12 @@ void push_undo(UndoStack *stack, const char *command, UndoType type, const char
         }
         if (prev) {
             prev->next = NULL;
-            if (curr->backup_path) {
-                unlink(curr->backup_path);
-                free(curr->backup_path);
+            if (curr->backup_path != STR_NONE) {
+                unlink(node_string(stack, curr->backup_path));
             }
-            free(curr->command);
-            if (curr->target) free(curr->target);
-            free(curr);
+            release_node(stack, curr);
             stack->count--;
+            compact_strings(stack);
         }
     }
 }
@@ -60,14 +122,16 @@ int execute_undo(UndoStack *stack) {
     
     UndoNode *node = stack->top;
     int success = 0;
+    const char *target = node_string(stack, node->target);
+    const char *backup_path = node_string(stack, node->backup_path);
     
-    printf("Undoing: %s\n", node->command);
+    printf("Undoing: %s\n", node_string(stack, node->command));
     
     switch (node->type) {
         case UNDO_MKDIR:
             // Remove the directory that was created
-            if (node->target && rmdir(node->target) == 0) {
-                printf("Removed directory: %s\n", node->target);
+            if (target && rmdir(target) == 0) {
+                printf("Removed directory: %s\n", target);
                 success = 1;
             } else {
                 perror("Failed to undo mkdir");
@@ -77,17 +141,17 @@ int execute_undo(UndoStack *stack) {
         case UNDO_TOUCH:
         case UNDO_RM:
             // Restore file from backup
-            if (node->backup_path && node->target) {
-                if (rename(node->backup_path, node->target) == 0) {
-                    printf("Restored file: %s\n", node->target);
+            if (backup_path && target) {
+                if (rename(backup_path, target) == 0) {
+                    printf("Restored file: %s\n", target);
                     success = 1;
                 } else {
                     perror("Failed to restore file");
                 }
-            } else if (node->target) {
+            } else if (target) {
                 // Just remove the file that was created
-                if (unlink(node->target) == 0) {
-                    printf("Removed file: %s\n", node->target);
+                if (unlink(target) == 0) {
+                    printf("Removed file: %s\n", target);
                     success = 1;
                 }
             }
@@ -95,8 +159,18 @@ int execute_undo(UndoStack *stack) {
             
         case UNDO_CP:
             // Remove the copied file
-            if (node->target && unlink(node->target) == 0) {
-                printf("Removed copied file: %s\n", node->target);
+            if (target && unlink(target) == 0) {
+                printf("Removed copied file: %s\n", target);
+                success = 1;
+            } else {
+                perror("Failed to undo copy");
+            }
+            break;
+            
+        case UNDO_CP_DIR:
+            // Remove the copied tree
+            if (target && remove_tree(AT_FDCWD, target) == 0) {
+                printf("Removed copied directory: %s\n", target);
                 success = 1;
             } else {
                 perror("Failed to undo copy");
@@ -105,9 +179,9 @@ int execute_undo(UndoStack *stack) {
             
         case UNDO_MV:
             // Restore from backup
-            if (node->backup_path && node->target) {
-                if (rename(node->backup_path, node->target) == 0) {
-                    printf("Restored moved file: %s\n", node->target);
+            if (backup_path && target) {
+                if (rename(backup_path, target) == 0) {
+                    printf("Restored moved file: %s\n", target);
                     success = 1;
                 } else {
                     perror("Failed to undo move");
@@ -123,27 +197,21 @@ int execute_undo(UndoStack *stack) {
     // Pop from stack
     stack->top = node->next;
     stack->count--;
-    
-    if (node->backup_path) free(node->backup_path);
-    if (node->target) free(node->target);
-    free(node->command);
-    free(node);
+    release_node(stack, node);
+    compact_strings(stack);
     
     return success;
 }
 
 void free_undo_stack(UndoStack *stack) {
-    while (stack->top) {
-        UndoNode *node = stack->top;
-        stack->top = node->next;
-        
-        if (node->backup_path) {
-            unlink(node->backup_path);
-            free(node->backup_path);
+    // Backups still on the stack are discarded; nodes and strings go with
+    // their arenas
+    for (UndoNode *node = stack->top; node; node = node->next) {
+        if (node->backup_path != STR_NONE) {
+            unlink(node_string(stack, node->backup_path));
         }
-        if (node->target) free(node->target);
-        free(node->command);
-        free(node);
     }
+    arena_free(&stack->nodes);
+    strpool_free_in(&stack->strings);
     free(stack);
 }
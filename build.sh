@@ -11,23 +11,42 @@ rm -f *.o src/*.o mysh
 # Compile all source files
 echo "[2/3] Compiling..."
 gcc -Wall -Wextra -Iinclude -D_GNU_SOURCE -c src/utils.c -o src/utils.o
+gcc -Wall -Wextra -Iinclude -D_GNU_SOURCE -c src/diriter.c -o src/diriter.o
+gcc -Wall -Wextra -Iinclude -D_GNU_SOURCE -c src/dirlist.c -o src/dirlist.o
+gcc -Wall -Wextra -Iinclude -D_GNU_SOURCE -c src/filewalk.c -o src/filewalk.o
+gcc -Wall -Wextra -Iinclude -D_GNU_SOURCE -c src/filecopy.c -o src/filecopy.o
+gcc -Wall -Wextra -Iinclude -D_GNU_SOURCE -c src/treewalk.c -o src/treewalk.o
+gcc -Wall -Wextra -Iinclude -D_GNU_SOURCE -c src/arena.c -o src/arena.o
+gcc -Wall -Wextra -Iinclude -D_GNU_SOURCE -c src/strpool.c -o src/strpool.o
 gcc -Wall -Wextra -Iinclude -D_GNU_SOURCE -c src/history.c -o src/history.o
 gcc -Wall -Wextra -Iinclude -D_GNU_SOURCE -c src/trie.c -o src/trie.o
 gcc -Wall -Wextra -Iinclude -D_GNU_SOURCE -c src/bktree.c -o src/bktree.o
 gcc -Wall -Wextra -Iinclude -D_GNU_SOURCE -c src/undo.c -o src/undo.o
 gcc -Wall -Wextra -Iinclude -D_GNU_SOURCE -c src/macros.c -o src/macros.o
 gcc -Wall -Wextra -Iinclude -D_GNU_SOURCE -c src/commands.c -o src/commands.o
+gcc -Wall -Wextra -Iinclude -D_GNU_SOURCE -c src/aho_corasick.c -o src/aho_corasick.o
+gcc -Wall -Wextra -Iinclude -D_GNU_SOURCE -c src/regexdfa.c -o src/regexdfa.o
+gcc -Wall -Wextra -Iinclude -D_GNU_SOURCE -c src/nlp_pack.c -o src/nlp_pack.o
+gcc -Wall -Wextra -Iinclude -D_GNU_SOURCE -c src/intent_model.c -o src/intent_model.o
+gcc -Wall -Wextra -Iinclude -D_GNU_SOURCE -c src/dircache.c -o src/dircache.o
+gcc -Wall -Wextra -Iinclude -D_GNU_SOURCE -c src/pathindex.c -o src/pathindex.o
+gcc -Wall -Wextra -Iinclude -D_GNU_SOURCE -c src/nlp_slots.c -o src/nlp_slots.o
+gcc -Wall -Wextra -Iinclude -D_GNU_SOURCE -c src/phrase_index.c -o src/phrase_index.o
 gcc -Wall -Wextra -Iinclude -D_GNU_SOURCE -c src/nlp_engine.c -o src/nlp_engine.o
+gcc -Wall -Wextra -Iinclude -D_GNU_SOURCE -c src/nlp_batch.c -o src/nlp_batch.o
+gcc -Wall -Wextra -Iinclude -D_GNU_SOURCE -c src/ngram.c -o src/ngram.o
 gcc -Wall -Wextra -Iinclude -D_GNU_SOURCE -c src/suggestion_engine.c -o src/suggestion_engine.o
 gcc -Wall -Wextra -Iinclude -D_GNU_SOURCE -c src/custom_commands.c -o src/custom_commands.o
 gcc -Wall -Wextra -Iinclude -D_GNU_SOURCE -c src/sysmon_advanced.c -o src/sysmon_advanced.o
+gcc -Wall -Wextra -Iinclude -D_GNU_SOURCE -c src/builtin_commands.c -o src/builtin_commands.o
 gcc -Wall -Wextra -Iinclude -D_GNU_SOURCE -c src/main_enhanced.c -o src/main_enhanced.o
 
 # Link
 echo "[3/3] Linking..."
-gcc -o mysh src/main_enhanced.o src/utils.o src/history.o src/trie.o src/bktree.o src/undo.o src/macros.o src/commands.o src/nlp_engine.o src/suggestion_engine.o src/custom_commands.o src/sysmon_advanced.o -lm
+gcc -o mysh src/main_enhanced.o src/utils.o src/diriter.o src/dirlist.o src/filewalk.o src/filecopy.o src/treewalk.o src/arena.o src/strpool.o src/history.o src/trie.o src/bktree.o src/undo.o src/macros.o src/commands.o src/aho_corasick.o src/regexdfa.o src/nlp_pack.o src/intent_model.o src/dircache.o src/pathindex.o src/nlp_slots.o src/phrase_index.o src/nlp_engine.o src/nlp_batch.o src/ngram.o src/suggestion_engine.o src/custom_commands.o src/sysmon_advanced.o src/builtin_commands.o -lm -pthread
 
 if [ -f mysh ]; then
+    ./mysh --compile-patterns data/nlp_patterns.txt data/nlp_patterns.pack
     echo "=== Build successful! ==="
     echo "Run with: ./backend/mysh"
     echo ""
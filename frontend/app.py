@@ -3,7 +3,6 @@ from tkinter import font, scrolledtext, messagebox
 import os
 import sys
 from backend_comm import BackendManager
-from nlp_translator import NLPCommandTranslator
 
 class TerminalApp:
     def __init__(self, root):
@@ -89,9 +88,6 @@ class TerminalApp:
         self.prompt = "shell> "
         self.prompt_end_index = "1.0"
         
-        # NLP Translator
-        self.nlp = NLPCommandTranslator()
-        
         # Key bindings
         self.setup_key_bindings()
         
@@ -253,7 +249,17 @@ class TerminalApp:
                 break
             
             type, content = item
-            if type == "OUTPUT":
+            if type == "OUTPUT" and content.startswith("NLP_TRANSLATED:"):
+                # The backend translated natural language before running it
+                parts = content.strip().split(":", 2)
+                if len(parts) >= 2:
+                    self.text_area.insert(tk.END, f"[NLP] Interpreted as: {parts[1]}\n", "nlp")
+            elif type == "OUTPUT" and content.startswith("NLP_SUGGESTED:"):
+                # A guess the backend did not run
+                parts = content.strip().split(":", 2)
+                if len(parts) >= 2:
+                    self.text_area.insert(tk.END, f"[NLP] Did you mean: {parts[1]}? Not run.\n", "nlp")
+            elif type == "OUTPUT":
                 self.text_area.insert(tk.END, content, "output")
                 self.text_area.see(tk.END)
             elif type == "PROMPT":
@@ -285,9 +291,6 @@ class TerminalApp:
         self.text_area.delete(self.prompt_end_index, "end-1c")
         self.text_area.insert(self.prompt_end_index, text)
 
-    def translate_command(self, input_text):
-        return self.nlp.translate(input_text)
-
     def handle_enter(self, event):
         command_text = self.get_current_command()
         self.text_area.insert(tk.END, "\n")
@@ -298,13 +301,8 @@ class TerminalApp:
                 self.command_history.append(command_text)
             self.history_index = len(self.command_history)
             
-            # NLP Translation
-            translated = self.translate_command(command_text)
-            if translated != command_text:
-                self.text_area.insert(tk.END, f"[NLP] Interpreted as: {translated}\n", "nlp")
-                self.backend.send_command(translated)
-            else:
-                self.backend.send_command(command_text)
+            # The backend decides whether this is natural language
+            self.backend.send_command(f"AUTO:{command_text}")
             
             self.update_status(f"Executing: {command_text}", "info")
         else:
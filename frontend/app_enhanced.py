@@ -12,6 +12,7 @@ import queue
 import os
 import sys
 import re
+import nlpterm
 
 class BackendManager:
     """Manages communication with the C backend shell"""
@@ -22,6 +23,9 @@ class BackendManager:
         self.output_queue = queue.Queue()
         self.running = False
         self.reader_thread = None
+        # Engines in-process when libnlpterm.so is built (make lib);
+        # otherwise keystroke queries go over the pipe
+        self.lib = nlpterm.load(os.path.dirname(shell_path))
 
     def start(self):
         if not os.path.exists(self.shell_path):
@@ -61,9 +65,17 @@ class BackendManager:
                         parts = buffer.strip().split(":", 2)
                         if len(parts) >= 3:
                             self.output_queue.put(("NLP", (parts[1], parts[2])))
+                    elif buffer.startswith("NLP_SUGGESTED:"):
+                        parts = buffer.strip().split(":", 2)
+                        if len(parts) >= 3:
+                            self.output_queue.put(("NLP_SUGGESTED", (parts[1], parts[2])))
                     elif buffer.startswith("SUGGESTIONS:"):
                         suggestions = buffer.strip()[12:].split("|")
                         self.output_queue.put(("SUGGESTIONS", suggestions))
+                    elif buffer.startswith("NL_CLASS:"):
+                        parts = buffer.strip().split(":")
+                        if len(parts) == 3:
+                            self.output_queue.put(("NL_CLASS", (parts[1] == "1", float(parts[2]))))
                     else:
                         self.output_queue.put(("OUTPUT", buffer))
                     buffer = ""
@@ -84,7 +96,23 @@ class BackendManager:
 
     def request_suggestions(self, partial):
         """Request suggestions from C backend"""
-        self.send_command(f"SUGGEST:{partial}")
+        if self.lib:
+            self.output_queue.put(("SUGGESTIONS", self.lib.suggest(partial)))
+        else:
+            self.send_command(f"SUGGEST:{partial}")
+
+    def request_classification(self, text):
+        """Ask the C backend whether text reads as natural language"""
+        if self.lib:
+            confidence = self.lib.classify(text)
+            self.output_queue.put(("NL_CLASS", (confidence >= 0.5, confidence)))
+        else:
+            self.send_command(f"CLASSIFY:{text}")
+
+    def record_history(self, command):
+        """Keep in-process history suggestions in step with the shell"""
+        if self.lib:
+            self.lib.add_history(command)
 
     def get_output(self):
         try:
@@ -501,8 +529,21 @@ class NLPTerminalApp:
             elif msg_type == "NLP":
                 cmd, explanation = content
                 self.text_area.insert(tk.END, f"[NLP] → {cmd} ({explanation})\n", "nlp")
+            elif msg_type == "NLP_SUGGESTED":
+                cmd, explanation = content
+                self.text_area.insert(tk.END, f"[NLP] Did you mean: {cmd} ({explanation})? Not run.\n", "nlp")
             elif msg_type == "SUGGESTIONS":
-                self.show_suggestion_popup(content)
+                if self.get_current_command():
+                    self.show_suggestion_popup(content)
+                elif content and content[0]:
+                    # Empty prompt: backend predicted the next command
+                    self.show_ghost_suggestion(content[0])
+            elif msg_type == "NL_CLASS":
+                is_nl, confidence = content
+                if is_nl and self.get_current_command():
+                    self.update_status(f"Natural language ({confidence:.0%}) - Enter translates it", "info")
+                else:
+                    self.update_status("Ready", "info")
             elif msg_type == "ERROR":
                 self.text_area.insert(tk.END, f"Error: {content}\n", "error")
         
@@ -522,6 +563,9 @@ class NLPTerminalApp:
         self.text_area.mark_set("insert", tk.END)
         self.update_status("Ready", "success")
         
+        # Ask for a next-command prediction to show as ghost text
+        self.backend.request_suggestions("")
+        
     def get_current_command(self):
         """Get current command text"""
         return self.text_area.get(self.prompt_end_index, "end-1c").strip()
@@ -586,14 +630,23 @@ class NLPTerminalApp:
     def request_suggestions(self):
         """Request suggestions from backend"""
         current = self.get_current_command()
-        if current:
-            # Get last word for suggestions
-            words = current.split()
-            if words:
-                self.backend.request_suggestions(words[-1])
+        if current.strip():
+            # The whole line, so phrases like "show fi" can be completed
+            self.backend.request_suggestions(current)
         else:
             self.suggestion_popup.hide()
             
+    def accept_suggestion(self, selected):
+        """Put a suggestion on the command line"""
+        words = self.get_current_command().split()
+        if words and " " not in selected:
+            # A command name completes the last word
+            words[-1] = selected
+            self.set_current_command(" ".join(words) + " ")
+        else:
+            # A phrase completes the whole line
+            self.set_current_command(selected + " ")
+            
     # ============ EVENT HANDLERS ============
     
     def handle_enter(self, event):
@@ -610,11 +663,9 @@ class NLPTerminalApp:
                 self.command_history.append(command_text)
             self.history_index = len(self.command_history)
             
-            # Send to backend (with NLP prefix for natural language)
-            if self.is_natural_language(command_text):
-                self.backend.send_command(f"NLP:{command_text}")
-            else:
-                self.backend.send_command(command_text)
+            # The backend decides whether to translate the line
+            self.backend.send_command(f"AUTO:{command_text}")
+            self.backend.record_history(command_text)
             
             self.update_status(f"Executing: {command_text}", "info")
         else:
@@ -622,29 +673,6 @@ class NLPTerminalApp:
         
         return "break"
     
-    def is_natural_language(self, text):
-        """Check if text looks like natural language"""
-        # Simple heuristics
-        nl_words = ['show', 'display', 'list', 'create', 'make', 'delete', 'remove',
-                   'what', 'where', 'find', 'go', 'help', 'please', 'can you']
-        
-        text_lower = text.lower()
-        
-        # Check for NL indicators
-        for word in nl_words:
-            if text_lower.startswith(word + " "):
-                return True
-        
-        # Check if contains multiple words and not a known command
-        words = text.split()
-        known_commands = ['ls', 'cd', 'pwd', 'mkdir', 'rmdir', 'cat', 'rm', 'cp', 'mv',
-                         'echo', 'sysmon', 'help', 'exit', 'clear', 'tree', 'search']
-        
-        if words and words[0] in known_commands:
-            return False
-        
-        return len(words) >= 2
-    
     def handle_up(self, event):
         """Handle Up arrow - history or suggestions"""
         if self.suggestion_popup.visible:
@@ -682,10 +710,14 @@ class NLPTerminalApp:
         """Handle Right arrow - accept suggestion or move cursor"""
         # If ghost text exists, accept it
         if self.ghost_text:
+            ghost = self.ghost_text
             self.clear_ghost_text()
             current = self.get_current_command()
             words = current.split()
-            if words:
+            if not words:
+                # Accept a predicted next command on an empty prompt
+                self.set_current_command(ghost)
+            else:
                 # Complete the last word
                 for s in self.suggestion_popup.suggestions if self.suggestion_popup.visible else []:
                     if s.startswith(words[-1]):
@@ -699,13 +731,7 @@ class NLPTerminalApp:
         if self.suggestion_popup.visible:
             selected = self.suggestion_popup.get_selected()
             if selected:
-                current = self.get_current_command()
-                words = current.split()
-                if words:
-                    words[-1] = selected
-                    self.set_current_command(" ".join(words) + " ")
-                else:
-                    self.set_current_command(selected + " ")
+                self.accept_suggestion(selected)
                 self.suggestion_popup.hide()
                 return "break"
         
@@ -726,13 +752,7 @@ class NLPTerminalApp:
         if self.suggestion_popup.visible:
             selected = self.suggestion_popup.get_selected()
             if selected:
-                current = self.get_current_command()
-                words = current.split()
-                if words:
-                    words[-1] = selected
-                    self.set_current_command(" ".join(words) + " ")
-                else:
-                    self.set_current_command(selected + " ")
+                self.accept_suggestion(selected)
                 self.suggestion_popup.hide()
         else:
             # Request suggestions
@@ -773,8 +793,10 @@ class NLPTerminalApp:
         if current and len(current) >= 1:
             # Simple local suggestion for responsiveness
             self.show_local_suggestions(current)
+            self.backend.request_classification(current)
         else:
             self.suggestion_popup.hide()
+            self.update_status("Ready", "info")
             
     def show_local_suggestions(self, current):
         """Show suggestions locally (without backend call for speed)"""
@@ -0,0 +1,103 @@
+"""
+ctypes binding for libnlpterm.so (backend/include/nlpterm.h)
+Lets the GUI run suggestions and classification in-process instead of
+over the backend pipe. load() returns None when the library is missing,
+so callers can fall back to the pipe.
+"""
+
+import ctypes
+import os
+
+API_VERSION = 2
+BUFFER_SIZE = 4096
+
+
+class SysInfo(ctypes.Structure):
+    _fields_ = [
+        ("size", ctypes.c_uint32),
+        ("num_cores", ctypes.c_int32),
+        ("cpu_percent", ctypes.c_double),
+        ("mem_total_bytes", ctypes.c_uint64),
+        ("mem_used_bytes", ctypes.c_uint64),
+        ("mem_percent", ctypes.c_double),
+        ("uptime_seconds", ctypes.c_uint64),
+    ]
+
+
+class NLPTermLib:
+    """Thin wrapper: byte buffers in, Python strings and lists out"""
+
+    def __init__(self, lib, pack_path):
+        self.lib = lib
+        c_char_p, c_size_t, c_int = ctypes.c_char_p, ctypes.c_size_t, ctypes.c_int
+        lib.nlpterm_version.restype = c_int
+        lib.nlpterm_init.argtypes = [c_char_p]
+        lib.nlpterm_translate.argtypes = [c_char_p, c_char_p, c_size_t, c_char_p, c_size_t,
+                                          ctypes.POINTER(ctypes.c_double)]
+        lib.nlpterm_classify.argtypes = [c_char_p]
+        lib.nlpterm_classify.restype = ctypes.c_double
+        lib.nlpterm_suggest.argtypes = [c_char_p, c_char_p, c_size_t]
+        lib.nlpterm_suggest_context.argtypes = [c_char_p, c_char_p, c_char_p, c_char_p, c_size_t]
+        lib.nlpterm_complete.argtypes = [c_char_p, c_char_p, c_size_t]
+        lib.nlpterm_correct.argtypes = [c_char_p, c_int, c_char_p, c_size_t]
+        lib.nlpterm_add_history.argtypes = [c_char_p]
+        lib.nlpterm_sysinfo.argtypes = [ctypes.POINTER(SysInfo)]
+        lib.nlpterm_init(pack_path.encode() if pack_path else None)
+
+    @staticmethod
+    def _list(call, *args):
+        buf = ctypes.create_string_buffer(BUFFER_SIZE)
+        count = call(*args, buf, BUFFER_SIZE)
+        text = buf.value.decode(errors="replace")
+        return text.split("|") if count > 0 else []
+
+    def translate(self, text):
+        """(command, explanation, confidence, run), or None if not translated.
+        run is False for a translation to offer but not run."""
+        cmd = ctypes.create_string_buffer(512)
+        explanation = ctypes.create_string_buffer(512)
+        confidence = ctypes.c_double()
+        status = self.lib.nlpterm_translate(text.encode(), cmd, 512, explanation, 512,
+                                            ctypes.byref(confidence))
+        if not status:
+            return None
+        return cmd.value.decode(), explanation.value.decode(), confidence.value, status == 1
+
+    def classify(self, text):
+        return self.lib.nlpterm_classify(text.encode())
+
+    def suggest(self, partial):
+        return self._list(self.lib.nlpterm_suggest, partial.encode())
+
+    def suggest_context(self, cmd, partial, cwd=None):
+        return self._list(self.lib.nlpterm_suggest_context, cmd.encode(), partial.encode(),
+                          cwd.encode() if cwd else None)
+
+    def complete(self, prefix):
+        return self._list(self.lib.nlpterm_complete, prefix.encode())
+
+    def correct(self, word, max_distance=2):
+        return self._list(self.lib.nlpterm_correct, word.encode(), max_distance)
+
+    def add_history(self, command):
+        self.lib.nlpterm_add_history(command.encode())
+
+    def sysinfo(self):
+        info = SysInfo(size=ctypes.sizeof(SysInfo))
+        if self.lib.nlpterm_sysinfo(ctypes.byref(info)) != 0:
+            return None
+        return info
+
+
+def load(backend_dir):
+    """Load backend_dir/libnlpterm.so; None if missing or incompatible"""
+    path = os.path.join(backend_dir, "libnlpterm.so")
+    if not os.path.exists(path):
+        return None
+    try:
+        lib = ctypes.CDLL(path)
+        if lib.nlpterm_version() != API_VERSION:
+            return None
+        return NLPTermLib(lib, os.path.join(backend_dir, "data", "nlp_patterns.pack"))
+    except OSError:
+        return None